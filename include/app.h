@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+// Application-level controls implemented in main.cpp, shared with the Serial interface.
+void selectTrack(int index);
+int getCurrentTrack();
+void setPlaying(bool on);
+bool getPlaying();
+void requestRedraw();
+
+// Busy-wait this long after every animated frame to emulate a heavier display (0 = off)
+void setSyntheticLoadMs(uint32_t ms);
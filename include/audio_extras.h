@@ -11,8 +11,8 @@
 // Initialization for extra generators (call once during setup)
 void initAudioExtras();
 
-// Main sample generator for extra modes. Returns 0 if type unsupported here.
-uint8_t nextAudioSampleExtra(NoiseType t);
+// Main sample generator for extra modes (signed 16-bit). Returns 0 if type unsupported here.
+int16_t nextAudioSampleExtra(NoiseType t);
 
 // Convenience: query if an enum value is handled by extras switch
 bool isExtraType(NoiseType t);
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+// Master bus and final output stage. Everything upstream runs at signed 16-bit
+// resolution; rendered blocks pass through processMasterBus() (DC blocker,
+// smoothed master gain, lookahead limiter) and are then requantized to the
+// 8-bit DAC one sample at a time by masterOutputU8().
+
+enum class DitherMode : uint8_t {
+  NONE = 0,        // plain rounding
+  TPDF = 1,        // triangular dither, +/-1 LSB at 8 bits
+  TPDF_SHAPED = 2  // TPDF plus first-order error feedback (noise pushed toward Nyquist)
+};
+
+void initAudioMaster();
+
+// Process a rendered block in place. Adds a fixed latency of 32 samples (limiter lookahead).
+void processMasterBus(int16_t* buf, int n);
+
+// Lowest limiter gain (0..1) since the previous call; 1.0 means no limiting occurred.
+float takeLimiterMinGain();
+
+// Convert one master-bus sample to an unsigned 8-bit DAC value.
+uint8_t masterOutputU8(int16_t s);
+
+void setDitherMode(DitherMode m);
+DitherMode getDitherMode();
+const char* getDitherModeName(DitherMode m);
+
+// Master volume control (0.0 .. 1.0, clamped)
+void setMasterGain(float g);
+float getMasterGain();
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <cstdint>
+#include "config.h"
 #include "types.h"
+#include "reverb.h"
 
 /* Utility functions */
 inline uint8_t clampU8(int v) {
@@ -10,53 +12,90 @@ inline uint8_t clampU8(int v) {
   return static_cast<uint8_t>(v);
 }
 
+// Generators emit signed 16-bit samples centred on 0 (1.0f == 32767).
+inline int16_t clampS16(int32_t v) {
+  if (v < -32768) return -32768;
+  if (v > 32767) return 32767;
+  return static_cast<int16_t>(v);
+}
+
+// Exact phase accumulator for integer-Hz oscillators: acc counts 1/SAMPLE_RATE_HZ of a cycle,
+// so the waveform repeats bit-exactly (see getLoopPeriodForType). Returns the phase in radians.
+inline float exactPhaseStep(uint32_t& acc, uint32_t hz) {
+  acc += hz;
+  if (acc >= (uint32_t)SAMPLE_RATE_HZ) acc -= SAMPLE_RATE_HZ;
+  return TAU_F * (float)acc / (float)SAMPLE_RATE_HZ;
+}
+
 // Basic noise generators
-uint8_t nextWhiteSample();
-uint8_t nextPinkSample();
-uint8_t nextBrownSample();
-uint8_t nextBlueSample();
-uint8_t nextVioletSample();
+int16_t nextWhiteSample();
+int16_t nextPinkSample();
+int16_t nextBrownSample();
+int16_t nextBlueSample();
+int16_t nextVioletSample();
 
 // Tone generators
-uint8_t nextToneSample(NoiseType t);
-uint8_t nextShepardUpU8();
-uint8_t nextShepardDownU8();
+int16_t nextToneSample(NoiseType t);
+int16_t nextShepardUpS16();
+int16_t nextShepardDownS16();
 
 // Advanced synthesis
-uint8_t nextKarplusU8();
-uint8_t nextModalDrumU8();
-uint8_t nextGranularU8();
-uint8_t nextSuperSawU8();
-uint8_t nextPwmU8();
-uint8_t nextBitcrushU8();
-uint8_t nextPhaseDistU8();
-uint8_t nextWavefoldU8();
-uint8_t nextBandpassNoiseU8();
-
-// Rhythm generators
-uint8_t nextEuclidU8();
-uint8_t nextEuclid716U8();
-uint8_t nextPoly34U8();
+int16_t nextKarplusS16();
+int16_t nextModalDrumS16();
+int16_t nextGranularS16();
+int16_t nextSuperSawS16();
+int16_t nextPwmS16();
+int16_t nextBitcrushS16();
+int16_t nextPhaseDistS16();
+int16_t nextWavefoldS16();
+int16_t nextBandpassNoiseS16();
 
 // Effects and modulation
-uint8_t nextRingModU8();
-uint8_t nextChorusU8();
-uint8_t nextSampleHoldU8();
-uint8_t nextFormantU8();
-uint8_t nextSyncU8();
-uint8_t nextSuperSquareU8();
-
-// Main sample generator
+int16_t nextRingModS16();
+int16_t nextChorusS16();
+int16_t nextSampleHoldS16();
+int16_t nextFormantS16();
+int16_t nextSyncS16();
+int16_t nextSuperSquareS16();
+
+// Raw source generator for a track (no insert effects, no per-type gain)
+int16_t nextSourceSampleS16(NoiseType t);
+
+// Convenience: one sample through the master output stage (8-bit DAC value)
 uint8_t nextAudioSample(NoiseType t);
 
-// Audio task function
+// Render a block of pre-master samples for one track:
+// source -> insert-effect chain -> per-type gain -> reverb send
+void renderAudioBlock(NoiseType t, int16_t* out, int n);
+
+// Optional reverb on any track. FX_GATED_REVERB always uses its own gated preset.
+void setReverbSend(bool on);
+bool getReverbSend();
+void setReverbSendParams(const ReverbParams& p);
+
+// Audio task function (core 1): paces samples to the DAC. With the pipeline on it only drains
+// the block FIFO; otherwise it renders each block itself.
 void audioTask(void* param);
 
+// Render worker (core 0): fills the block FIFO up to the render-ahead depth while the pipeline is on
+void renderTask(void* param);
+
+// Pipeline controls. Switching mode takes effect while audio is paused.
+void setAudioPipeline(bool on);
+bool getAudioPipeline();
+void setRenderAhead(int blocks);   // clamped to 1..AUDIO_FIFO_BLOCKS - 1
+int getRenderAhead();
+uint32_t getUnderrunCount();       // samples the DAC had to repeat because the FIFO was empty
+uint32_t getFifoFill();            // rendered blocks waiting for the DAC
+
 // Audio state management
 void initAudioState();
 void setAudioRunning(bool running);
 void setAudioNoiseType(NoiseType type);
 
-// Master volume control (0.0 .. 1.0, clamped)
-void setMasterGain(float g);
-float getMasterGain();
+// Print and reset cycle accounting for the audio path (call from loop())
+void printAudioProfile();
+
+// Time the control-rate generators at K = 1 versus the current K and print cycles/sample.
+// Drives the generators from the caller's task, so audio must be paused.
+void benchControlRate();
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+// Boot-phase timestamps (esp_timer microseconds since the app started), logged to Serial
+// at the end of setup() so regressions in power-on-to-sound time are visible.
+
+// Record the end of a named boot phase (call from setup() only; up to BOOT_MARKS_MAX)
+void bootMark(const char* phase);
+void printBootProfile();
+
+// First-sample tracking: play request from the UI, first DAC sample from the audio path.
+// noteFirstSample() is ISR-safe and cheap once the sample has been seen.
+void notePlayRequested();
+void noteFirstSample();
+
+// Print the boot-to-first-sample time once it is known (call from loop())
+void reportFirstSample();
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+// Bytebeat: one integer expression of the sample counter t, e.g. t*(t>>5|t>>8), whose low
+// byte is the output sample. Formulas are compiled once to a stack bytecode (constants
+// folded, "x op constant" fused into a single instruction) and interpreted a whole block at
+// a time: each instruction runs over every sample of the block, so dispatch costs once per
+// block instead of once per sample.
+//
+// Syntax: unsigned 32-bit arithmetic on t, decimal and 0x constants, parentheses and the C
+// operators + - * / % & | ^ << >> < > <= >= == != && || ! ~ unary - and ?: with C
+// precedence. Division and modulo by zero give 0; shift counts use their low 5 bits.
+// Parentheses, unary operators and ?: nest at most BYTEBEAT_NESTING deep, which bounds the
+// parser's recursion on the loop task's stack.
+// t advances at bytebeat.rate (8000 Hz, like the original programs) and each value is held
+// for the output samples in between.
+//
+// The UI compiles into a staged program; the audio side picks it up at its next block and
+// restarts t, so a new formula never plays half-installed.
+
+static const int BYTEBEAT_TEXT_MAX = 128;
+static const int BYTEBEAT_MAX_OPS = 64;
+static const int BYTEBEAT_STACK = 16;
+static const int BYTEBEAT_NESTING = 24;
+
+// Compile and stage a formula. On a syntax error returns false, writes a message naming
+// the position to err and keeps the current formula playing.
+bool setBytebeatFormula(const char* text, char* err, int errLen);
+
+// Formula `index` of a text file on SPIFFS: one formula per line, blank lines and lines
+// starting with # skipped
+bool loadBytebeatFile(const char* path, int index, char* err, int errLen);
+
+int getBytebeatPresetCount();
+const char* getBytebeatPreset(int i);
+
+// Audio side: take the evaluation stack from the DSP arena (on selection of the Bytebeat track)
+bool attachBytebeat();
+void releaseBytebeat();
+void renderBytebeat(int16_t* out, int n);
+
+// Print the staged formula and its bytecode
+void printBytebeat();
+
+// Print cycles per sample for each preset interpreted per block and per sample, next to
+// the first preset written in C++. Uses a private heap stack, so it can run while audio plays.
+void benchBytebeat();
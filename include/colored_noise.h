@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+// Colored-noise engine. Every variant renders blocks from a xorshift32 PRNG and costs O(1)
+// per sample:
+//  - Voss-McCartney pink keeps a running sum and replaces one row per sample
+//  - Kellet pink is a fixed bank of six one-pole filters (IIR approximation of -3 dB/oct)
+//  - SlopeNoise shapes white noise to a 1/f^alpha power spectrum, alpha in [-2, 2]
+//    (+2 brown, +1 pink, 0 white, -1 blue, -2 violet) with interlaced pole/zero sections
+
+// xorshift32; state must be non-zero
+inline uint32_t noiseRand(uint32_t& s) {
+  s ^= s << 13;
+  s ^= s >> 17;
+  s ^= s << 5;
+  return s;
+}
+
+// Uniform white noise, full int16 range
+void renderWhiteNoise(uint32_t& rng, int16_t* out, int n);
+
+static const int VOSS_ROWS = 16;
+
+struct VossPink {
+  uint32_t rng;
+  uint32_t counter;
+  int32_t rows[VOSS_ROWS];
+  int32_t sum;          // sum of rows, kept up to date as rows change
+};
+
+void vossInit(VossPink& v, uint32_t seed);
+void renderVossPink(VossPink& v, int16_t* out, int n);
+
+struct KelletPink {
+  uint32_t rng;
+  float b[7];
+};
+
+void kelletInit(KelletPink& k, uint32_t seed);
+void renderKelletPink(KelletPink& k, int16_t* out, int n);
+
+static const int SLOPE_SECTIONS = 10;  // one pole/zero pair per octave from 8 Hz
+
+struct SlopeNoise {
+  uint32_t rng;
+  float alpha;
+  float gain;                     // white int16 in -> target RMS out
+  float zero[SLOPE_SECTIONS];     // y = x - zero*x1 + pole*y1 per section
+  float pole[SLOPE_SECTIONS];
+  float x1[SLOPE_SECTIONS];
+  float y1[SLOPE_SECTIONS];
+};
+
+// Design the sections for alpha (clamped to [-2, 2]) and normalise the output to targetRms.
+// Takes ~1 ms at 240 MHz (power measured from the impulse response): call on selection or
+// parameter change, not per block.
+void slopeNoiseInit(SlopeNoise& s, float alpha, float targetRms, uint32_t seed);
+void renderSlopeNoise(SlopeNoise& s, int16_t* out, int n);
+
+// Measure each variant's spectral slope with Goertzel filters at octave-spaced frequencies
+// and print it against the expected -3*alpha dB/octave. Uses its own generator state.
+void checkNoiseSlopes();
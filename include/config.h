@@ -3,10 +3,41 @@
 #include <cstdint>
 
 // Audio Configuration
-static const int TRACK_COUNT = 46;
+static const int TRACK_COUNT = 50;
 static const int SAMPLE_RATE_HZ = 11025;
 static const int AUDIO_DAC_PIN = 25;
 static constexpr float TAU_F = 6.28318530718f;
+static const int AUDIO_BLOCK_SIZE = 64;      // samples rendered per master-bus pass
+static const int CTRL_RATE_DEFAULT = 32;     // slow modulators update every K samples (see control_rate.h)
+static const int CTRL_RATE_MAX = 256;
+// Dual-core pipeline: renderTask (core 0) keeps up to AUDIO_FIFO_BLOCKS - 1 blocks ready for audioTask
+static const int AUDIO_FIFO_BLOCKS = 8;             // power of two
+static const int AUDIO_RENDER_AHEAD_DEFAULT = 3;    // blocks buffered ahead of the DAC (~17 ms)
+static const bool AUDIO_PIPELINE_DEFAULT = true;
+static const uint16_t SAMPLE_TIMER_DIVIDER = 2;     // 40 MHz timer ticks: 3628 per sample (11025.4 Hz)
+// Task stacks in bytes (ESP-IDF sizes stacks in bytes); check headroom on the diagnostics page
+static const uint32_t AUDIO_TASK_STACK_BYTES = 4096;
+static const uint32_t RENDER_TASK_STACK_BYTES = 4096;
+
+// Power: CPU clock while playing and while paused (80 MHz keeps APB, UART and timers unchanged)
+static const uint32_t CPU_MHZ_PLAYING = 240;
+static const uint32_t CPU_MHZ_IDLE = 80;
+// UI loop sleeps on button/frame events; these bound the wait
+static const uint32_t UI_IDLE_POLL_MS = 50;     // timers while nothing else is due (Serial input wakes the loop)
+static const uint32_t UI_BUTTON_POLL_MS = 20;   // debounce and hold-to-repeat while a button is down
+// DSP scratch (delay lines, tables, caches) for the active track only; see dsp_arena.h
+static const uint32_t DSP_ARENA_BYTES = 20480;
+// Spectral noise designer: IFFT frame (power of two) and frames overlapping each window
+static const int SPECTRAL_FRAME_MAX = 512;
+static const int SPECTRAL_FRAME_DEFAULT = 256;
+static const int SPECTRAL_OVERLAP_DEFAULT = 2;
+static const int LOOP_CACHE_MAX_SAMPLES = 4410;  // periodic tracks up to 0.4 s loop from RAM (8.8 KB)
+
+// Profiling: print audio cycle counts to Serial this often while playing (0 = off)
+static const uint32_t AUDIO_PROFILE_INTERVAL_MS = 5000;
+// Diagnostics page (A+C chord) refresh, and the binary telemetry period at boot (0 = off)
+static const uint32_t DIAG_REFRESH_MS = 500;
+static const uint32_t TELEMETRY_DEFAULT_MS = 0;
 
 // Visual Configuration
 static const int NOISE_W = 280;
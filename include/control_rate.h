@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+// Control-rate modulation: slow LFOs, envelopes and derived coefficients are evaluated
+// every K samples and linearly interpolated in between, instead of calling sinf/sqrtf
+// per audio sample. K = 1 reproduces per-sample evaluation exactly.
+
+void setControlRate(int k);   // clamped to 1..CTRL_RATE_MAX
+int getControlRate();
+
+// Linear segment towards a target that the owner recomputes whenever ctrlRampDue() fires.
+struct CtrlRamp {
+  float value;
+  float step;
+  int left;
+};
+
+inline bool ctrlRampDue(const CtrlRamp& r) { return r.left <= 0; }
+
+// Start a new segment from the current value to target over getControlRate() samples.
+void ctrlRampTo(CtrlRamp& r, float target);
+
+inline float ctrlRampNext(CtrlRamp& r) {
+  r.value += r.step;
+  --r.left;
+  return r.value;
+}
+
+// Sine LFO in [-1, 1] built on CtrlRamp. Phase in radians.
+struct CtrlLfo {
+  CtrlRamp ramp;
+  float phase;
+  float hz;
+};
+
+void ctrlLfoInit(CtrlLfo& l, float hz, float phase = 0.0f);
+float ctrlLfoNext(CtrlLfo& l);
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+// CPU duty-cycle accounting. Each source is written from exactly one context and counts
+// the cycles it spent working (not blocked), so busy / elapsed is its share of a core.
+// Core 0 runs the render worker; core 1 runs the sample ISR, audioTask and the UI loop.
+enum class LoadSource : uint8_t {
+  RENDER = 0,  // renderTask, core 0
+  AUDIO,       // audioTask (single-task mode renders and spins here), core 1
+  ISR,         // sample-rate timer interrupt, core 1
+  UI,          // loop(): buttons, Serial, drawing, core 1
+  COUNT
+};
+
+extern volatile uint32_t g_loadCycles[(int)LoadSource::COUNT];
+
+inline __attribute__((always_inline)) void cpuLoadAdd(LoadSource s, uint32_t cycles) {
+  g_loadCycles[(int)s] += cycles;
+}
+
+// Restart the measurement window (call after changing the CPU frequency)
+void cpuLoadReset();
+
+// Restart the window if the CPU frequency changed since it began; true when it did
+bool cpuLoadCheckFrequency();
+
+// Busy cycles of core 0 or 1 since the window began at getCpuLoadStartUs(), without
+// restarting it. The sums are 32 bits and wrap, so readers take differences over short spans.
+uint32_t getCoreBusyCycles(int core);
+uint32_t getCpuLoadStartUs();
+
+// Print per-core duty cycle since the last report, tagged with what was playing, and restart
+void printCpuDuty(const char* label);
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+// Power-of-two delay line on 16-bit samples with fractional, linearly interpolated reads.
+// Delays are Q16.16 samples, measured from the sample about to be written: read first,
+// then write, and a delay of D (1 <= D <= length - 2) returns x[n - D]. A read is two loads
+// and one multiply-add; the length mask replaces any wrap test.
+//
+// DelayTap is a modulated read position: the owner sets a target once per block and the
+// tap glides there linearly, one integer add per sample, so a swept delay never steps
+// (which is what zippers) and no LFO is evaluated per sample.
+
+struct DelayLine {
+  int16_t* buf;     // caller-owned, 1 << bits samples
+  uint32_t mask;
+  uint32_t w;       // samples written
+};
+
+// Attach and clear the storage
+void delayInit(DelayLine& d, int16_t* buf, int bits);
+
+inline void delayWrite(DelayLine& d, int16_t x) {
+  d.buf[d.w & d.mask] = x;
+  d.w++;
+}
+
+inline int32_t delayRead(const DelayLine& d, uint32_t delayQ16) {
+  const uint32_t i = d.w - (delayQ16 >> 16);
+  const int32_t s0 = d.buf[i & d.mask];
+  const int32_t s1 = d.buf[(i - 1u) & d.mask];
+  return s0 + (((s1 - s0) * (int32_t)((delayQ16 & 0xFFFFu) >> 1)) >> 15);
+}
+
+struct DelayTap {
+  uint32_t pos;     // current delay, Q16
+  int32_t step;     // per sample, Q16
+};
+
+inline uint32_t delayToQ16(float samples) {
+  return (uint32_t)(samples * 65536.0f);
+}
+
+inline void delayTapSet(DelayTap& t, float samples) {
+  t.pos = delayToQ16(samples);
+  t.step = 0;
+}
+
+// Glide from the current delay to target over the next n samples
+inline void delayTapGlide(DelayTap& t, float samples, int n) {
+  t.step = ((int32_t)delayToQ16(samples) - (int32_t)t.pos) / n;
+}
+
+inline int32_t delayTapRead(const DelayLine& d, DelayTap& t) {
+  const int32_t v = delayRead(d, t.pos);
+  t.pos += (uint32_t)t.step;
+  return v;
+}
+
+// Print cycles per sample for integer, interpolated and multi-tap reads (private buffers,
+// safe while audio plays)
+void benchDelayLine();
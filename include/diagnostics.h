@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Runtime health: heap, stack headroom, per-core load and frame/sample timing.
+// Shown on the diagnostics page (A+C chord) and streamed as binary telemetry over Serial.
+
+struct DiagSnapshot {
+  uint32_t ms;
+  uint32_t freeHeap;
+  uint32_t minFreeHeap;       // low-water mark since boot
+  uint32_t largestBlock;      // largest allocatable heap block (fragmentation)
+  uint32_t freePsram;         // 0 without PSRAM
+  uint32_t audioStackFree;    // bytes never touched, per task
+  uint32_t renderStackFree;
+  uint32_t uiStackFree;
+  float core0Busy;            // % of the core since the reader's last snapshot, see cpu_load.h
+  float core1Busy;
+  uint32_t frameDrawUs;       // last animated frame
+  uint32_t frameDrawMaxUs;    // worst since the reader's last snapshot
+  uint32_t frameIntervalMs;   // time between the last two frames
+  uint32_t underruns;         // DAC samples repeated, since boot
+  uint64_t sampleClock;       // samples heard since boot (sample_clock.h)
+  uint32_t avLatencyUs;       // audio -> display, running average
+  uint32_t renderLeadUs;      // rendered -> DAC
+  uint8_t fifoFill;           // blocks rendered ahead right now
+  uint8_t track;
+};
+
+// Telemetry frame (little-endian, packed). The checksum is the 8-bit sum of the payload,
+// i.e. every byte after `length` up to the checksum. Frames are dropped, never queued,
+// when the Serial TX buffer cannot take a whole frame.
+struct __attribute__((packed)) TelemetryFrame {
+  uint8_t sync[2];            // 0xA5 0x5A
+  uint8_t version;            // TELEMETRY_VERSION
+  uint8_t length;             // payload bytes
+  uint32_t ms;
+  uint32_t freeHeap, minFreeHeap, largestBlock, freePsram;
+  uint16_t audioStackFree, renderStackFree, uiStackFree;
+  uint16_t core0Busy, core1Busy;  // 0.1 %
+  uint32_t frameDrawUs;
+  uint16_t frameIntervalMs;
+  uint32_t underruns;
+  uint8_t fifoFill;
+  uint8_t track;
+  uint32_t sampleClock;       // low 32 bits (v2)
+  uint32_t avLatencyUs;       // (v2)
+  uint16_t renderLeadUs;      // (v2)
+  uint32_t frameDrawMaxUs;    // worst since the previous frame (v3)
+  uint8_t checksum;
+};
+
+static const uint8_t TELEMETRY_VERSION = 3;
+
+// Each reader of snapshots keeps its own window for the "since the last snapshot" figures,
+// so streaming telemetry does not shorten what the page shows
+enum class DiagReader : uint8_t {
+  PAGE = 0,    // diagnostics page and `diag`
+  TELEMETRY,
+  COUNT
+};
+
+// Register the tasks whose stacks are watched (call once the tasks exist)
+void initDiagnostics(TaskHandle_t audio, TaskHandle_t render, TaskHandle_t ui);
+
+// Record the draw time of an animated frame (called by the UI loop)
+void diagNoteFrame(uint32_t drawUs);
+
+void collectDiagnostics(DiagSnapshot& d, DiagReader reader);
+
+// Draw the page into the visual area
+void drawDiagnosticsPage(const DiagSnapshot& d);
+
+// Print a snapshot as text
+void printDiagnostics();
+
+// Binary telemetry every ms milliseconds (0 = off); pollTelemetry() is called from loop()
+void setTelemetryInterval(uint32_t ms);
+uint32_t getTelemetryInterval();
+void pollTelemetry();
+uint32_t getTelemetryDropped();
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+// Fixed-size arena for per-track DSP memory (delay lines, tables, caches).
+// Generators take their buffers from it when a track is selected and everything is
+// released at once on the next switch, so only the active track's scratch is resident.
+// Allocation and reset happen on the audio side only (onTrackSelected / render path).
+
+// Forget all allocations. Owners must drop their pointers first.
+void arenaReset();
+
+// 4-byte aligned, uninitialised. Returns nullptr when the arena is full.
+void* arenaAlloc(uint32_t bytes, const char* owner);
+
+uint32_t getArenaUsed();
+uint32_t getArenaPeak();
+
+// Current allocations by owner, the largest each owner has ever taken, and peak usage
+void printArenaReport();
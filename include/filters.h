@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+
+// Filter library: a state-variable filter (topology-preserving, stable up to Nyquist and
+// under modulation), RBJ biquads and a three-band formant filter that morphs between vowels.
+// Setters cache their inputs and only recompute coefficients when they change, so calling
+// them every block is cheap; sweeps call them at control rate and run the audio loop with
+// fixed coefficients in between. All processing is in place on float samples.
+
+/* === State-variable filter === */
+
+enum class SvfMode : uint8_t { LOW = 0, BAND, HIGH, NOTCH };
+
+struct Svf {
+  float hz, q;            // as last set (cache key)
+  float g, k, a1, a2, a3;
+  float ic1, ic2;         // integrator states
+};
+
+void svfInit(Svf& f, float hz, float q);
+void svfSet(Svf& f, float hz, float q);   // no-op when unchanged
+void svfReset(Svf& f);
+
+// One sample; BAND peaks at q at the centre frequency, the others are unity-gain
+inline float svfTick(Svf& f, float x, SvfMode mode) {
+  const float v3 = x - f.ic2;
+  const float v1 = f.a1 * f.ic1 + f.a2 * v3;
+  const float v2 = f.ic2 + f.a2 * f.ic1 + f.a3 * v3;
+  f.ic1 = 2.0f * v1 - f.ic1;
+  f.ic2 = 2.0f * v2 - f.ic2;
+  switch (mode) {
+    case SvfMode::LOW:  return v2;
+    case SvfMode::BAND: return v1;
+    case SvfMode::HIGH: return x - f.k * v1 - v2;
+    default:            return x - f.k * v1;  // NOTCH = low + high
+  }
+}
+
+void svfProcess(Svf& f, float* buf, int n, SvfMode mode);
+
+/* === Biquad (RBJ cookbook, transposed direct form II) === */
+
+enum class BiquadType : uint8_t { LOWPASS = 0, HIGHPASS, BANDPASS, NOTCH };
+
+struct Biquad {
+  BiquadType type;
+  float hz, q;            // as last set (cache key)
+  float b0, b1, b2, a1, a2;
+  float z1, z2;
+};
+
+void biquadInit(Biquad& f, BiquadType type, float hz, float q);
+void biquadSet(Biquad& f, BiquadType type, float hz, float q);  // no-op when unchanged
+void biquadReset(Biquad& f);
+
+inline float biquadTick(Biquad& f, float x) {
+  const float y = f.b0 * x + f.z1;
+  f.z1 = f.b1 * x - f.a1 * y + f.z2;
+  f.z2 = f.b2 * x - f.a2 * y;
+  return y;
+}
+
+void biquadProcess(Biquad& f, float* buf, int n);
+
+/* === Formant filter === */
+
+static const int FORMANT_BANDS = 3;
+static const int FORMANT_VOWELS = 5;   // a, e, i, o, u
+
+// Parallel SVF bandpasses at the first three formants of a vowel. The vowel position is
+// continuous: 0 = a, 1 = e, 2 = i, 3 = o, 4 = u, and values in between interpolate the
+// formant frequencies and gains; it wraps, so 4.5 is halfway from u back to a.
+struct FormantFilter {
+  float vowel;            // as last set (cache key)
+  float q;
+  float gain[FORMANT_BANDS];
+  Svf band[FORMANT_BANDS];
+};
+
+void formantInit(FormantFilter& f, float vowel, float q);
+void formantSetVowel(FormantFilter& f, float vowel);  // no-op when unchanged
+void formantProcess(FormantFilter& f, float* buf, int n);
+const char* getVowelName(int vowel);
+
+// Print cycles per sample for the filters with cached coefficients next to the same
+// filters recomputing their coefficients every sample (the pattern this replaced)
+void benchFilters();
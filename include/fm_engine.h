@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include "types.h"
+
+// Four-operator phase-modulation (DX-style "FM") engine. Each operator is a sine read from
+// the shared sine table (lut.h) at an integer phase accumulator, offset by the outputs of
+// the operators that modulate it. Which operator modulates which comes from a small
+// algorithm table; operators are numbered 1..4 in names and 0..3 in code, and a modulator
+// always has a higher index than its target so one pass from op 4 down to op 1 renders a block.
+//
+// An operator's level is its modulation index in radians when it modulates and its output
+// gain when it is a carrier. Envelopes are attack (linear) / decay (exponential to sustain) /
+// release, run per sample. Blocks are rendered one operator at a time.
+
+static const int FM_OPS = 4;
+
+enum class FmAlgo : uint8_t {
+  STACK = 0,     // 4 -> 3 -> 2 -> 1
+  TWO_PAIRS,     // 2 -> 1, 4 -> 3
+  THREE_TO_ONE,  // 2 + 3 + 4 -> 1
+  BRANCH,        // 4 -> 3 -> 1, 2 -> 1
+  ONE_TO_THREE,  // 4 -> 1, 2, 3
+  ADDITIVE,      // four carriers
+  COUNT
+};
+
+enum class FmPreset : uint8_t {
+  BELL = 0,   // struck two-pair bell (FM Bell track)
+  METAL,      // sustained 2 -> 1 clangor, ratio and index from params (FM Metallic track)
+  COUNT
+};
+
+struct FmOpSpec {
+  float ratio;     // frequency = ratio * voice pitch
+  float level;     // index (radians) as a modulator, gain as a carrier
+  float attackS;   // linear rise to full level
+  float decayS;    // T60 towards sustain
+  float sustain;   // 0..1
+  float releaseS;  // T60 after note off
+};
+
+struct FmPatch {
+  const char* name;
+  FmAlgo algo;
+  float feedback;  // op 4 self-modulation, radians
+  FmOpSpec op[FM_OPS];
+};
+
+enum class FmStage : uint8_t { IDLE = 0, ATTACK, DECAY, RELEASE };
+
+struct FmVoice {
+  const FmPatch* patch;
+  FmAlgo algo;
+  float pitchHz;
+  float velocity;
+  float ratio[FM_OPS];
+  float level[FM_OPS];
+  uint32_t phase[FM_OPS];
+  uint32_t inc[FM_OPS];
+  // Envelope
+  FmStage stage[FM_OPS];
+  float env[FM_OPS];
+  float attackInc[FM_OPS];
+  float decayMul[FM_OPS];
+  float releaseMul[FM_OPS];
+  float fb[2];  // last two op 4 outputs, for feedback
+};
+
+const FmPatch& getFmPreset(FmPreset p);
+const char* getFmAlgoName(FmAlgo a);
+
+// Load a patch (copies ratios and levels, silences the voice)
+void fmVoiceInit(FmVoice& v, const FmPatch& patch);
+
+// Live edits, effective from the next sample
+void fmVoiceSetPitch(FmVoice& v, float hz);
+void fmVoiceSetRatio(FmVoice& v, int op, float ratio);
+void fmVoiceSetLevel(FmVoice& v, int op, float level);
+
+// Restart the envelopes (phases keep running, so retriggers do not click)
+void fmNoteOn(FmVoice& v, float hz, float velocity);
+void fmNoteOff(FmVoice& v);
+bool fmVoiceActive(const FmVoice& v);
+
+// Add n samples (n <= AUDIO_BLOCK_SIZE) of the voice's carriers into acc.
+// Renders silence while the sine table is not attached.
+void fmRender(FmVoice& v, float* acc, int n);
+
+// FM Bell and FM Metallic tracks
+void renderFmTrack(NoiseType t, int16_t* out, int n);
+
+// Print cycles per sample for every algorithm with 1..4 operators sounding. Needs the sine
+// table, i.e. an FM track selected.
+void benchFmEngine();
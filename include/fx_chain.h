@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include "types.h"
+
+// Per-track insert-effect chain. Effects run in place on the rendered 16-bit block,
+// after the source generator and before the reverb send. Dispatch happens once per
+// effect per block; the inner loops are plain per-effect code.
+
+static const int FX_CHAIN_MAX = 4;
+
+void initFxChain();
+
+// Replace the active chain (up to FX_CHAIN_MAX entries, FxType::NONE entries are skipped).
+// Effect state is taken fresh from the DSP arena. Call from the audio task or while audio is stopped.
+void setFxChain(const FxType* types, int count);
+
+// Empty the chain (before the DSP arena is reset)
+void releaseFxChain();
+
+// Load the default chain for a track (see getFxChainForType in types.cpp)
+void setFxChainForType(NoiseType t);
+
+int getFxChain(FxType* out);
+
+void processFxChain(int16_t* buf, int n);
+
+const char* getFxTypeName(FxType f);
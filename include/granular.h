@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+// Granular engine: Hann-windowed grains (window from lut.h) read from a sine oscillator or
+// from a short buffer captured from another generator. Onsets form a Poisson process: the
+// gap to the next onset is drawn once, from an exponential distribution, when a grain
+// starts, so nothing is decided per sample. Active grains sit densely at the front of a
+// GRAIN_MAX pool (removal swaps in the last one) and each renders a block in one run.
+//
+// Params: grain.density (onsets/s), grain.size (ms), grain.spread (+- semitones),
+// grain.pitch (Hz; buffer sources play at grain.pitch / 630 Hz) and grain.source.
+
+static const int GRAIN_MAX = 32;
+static const int GRAIN_BUF_BITS = 12;
+static const int GRAIN_BUF_LEN = 1 << GRAIN_BUF_BITS;  // 0.37 s at 11,025 Hz
+
+enum class GrainSource : uint8_t {
+  SINE = 0,   // oscillator at the grain's pitch
+  SUPERSAW,   // buffer captured from the SuperSaw generator
+  PINK,       // buffer captured from pink noise
+  COUNT
+};
+
+const char* getGrainSourceName(GrainSource s);
+
+// Take the capture buffer from the DSP arena (on selection of the Granular track); without
+// it buffer sources fall back to the oscillator
+bool attachGranular();
+void releaseGranular();
+
+void renderGranular(int16_t* out, int n);
+
+// Print the settings, pool use and onset counts since the last call
+void printGranular();
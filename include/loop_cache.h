@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include "types.h"
+
+// Loop cache for strictly periodic tracks (see getLoopPeriodForType). One exact period of
+// the source is rendered when the track is selected and then replayed, so playback costs
+// a copy per sample. Periods longer than LOOP_CACHE_MAX_SAMPLES, or that do not fit in the
+// DSP arena, fall back to live synthesis.
+
+// Render and verify t's period into the cache. Returns false (cache off) when t must run live.
+bool prepareLoopCache(NoiseType t);
+
+// Copy the next n cached source samples (only valid after prepareLoopCache returned true).
+void renderLoopCache(int16_t* out, int n);
+
+// Drop the cached period (before arenaReset on a track change)
+void releaseLoopCache();
+
+// Cached period in samples, or 0 when the current track is synthesised live
+int getLoopCachePeriod();
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include "config.h"
+#include "types.h"
+
+// Lookup tables built lazily when a track that needs them is selected, so they add nothing
+// to boot time. They are taken from the DSP arena and dropped on the next track switch.
+// Lookups are only valid while the matching pointer is non-null.
+
+static const int SINE_LUT_SIZE = 1024;          // entries per cycle (power of two)
+static const int SHEPARD_LUT_SIZE = 256;        // Gaussian weight over SHEPARD_LUT_OCTAVES
+static const float SHEPARD_LUT_OCTAVES = 12.0f; // centred on the Shepard centre frequency
+static const int GRAIN_WINDOW_LUT_SIZE = 256;   // Hann window over one grain
+
+// Build the table into the arena if it is not attached (no-op when the arena is full)
+void ensureSineLut();
+void ensureShepardLut();
+void ensureGrainWindowLut();
+
+// Build whatever tables track t uses (called on track selection)
+void prepareLutsForType(NoiseType t);
+
+// Drop the tables (before arenaReset on a track change)
+void releaseLuts();
+
+// Bytes of tables currently attached and the time spent building them
+uint32_t getLutBytes();
+uint32_t getLutBuildUs();
+
+extern float* g_sineLut;     // SINE_LUT_SIZE + 1 entries
+extern float* g_shepardLut;  // SHEPARD_LUT_SIZE + 1 entries
+extern float* g_grainWindowLut;  // GRAIN_WINDOW_LUT_SIZE + 1 entries
+
+// sin(phase) for phase in [0, TAU_F), linearly interpolated
+inline float lutSin(float phase) {
+  float x = phase * ((float)SINE_LUT_SIZE / TAU_F);
+  int i = (int)x;
+  float frac = x - (float)i;
+  i &= (SINE_LUT_SIZE - 1);
+  return g_sineLut[i] + frac * (g_sineLut[i + 1] - g_sineLut[i]);
+}
+
+// sin of a 32-bit phase (2^32 = one cycle) from a sine table passed in by the caller, so
+// block loops can hoist the pointer: 10 index bits, 16 interpolation bits
+inline float lutSinU32(const float* lut, uint32_t p) {
+  static_assert(SINE_LUT_SIZE == 1024, "lutSinU32 assumes a 1024-entry sine table");
+  const uint32_t i = p >> 22;
+  const float frac = (float)((p >> 6) & 0xFFFFu) * (1.0f / 65536.0f);
+  return lut[i] + frac * (lut[i + 1] - lut[i]);
+}
+
+// Grain window at a 32-bit position through the grain (2^32 = whole grain)
+inline float lutGrainWindow(const float* lut, uint32_t pos) {
+  static_assert(GRAIN_WINDOW_LUT_SIZE == 256, "lutGrainWindow assumes a 256-entry window");
+  const uint32_t i = pos >> 24;
+  const float frac = (float)((pos >> 8) & 0xFFFFu) * (1.0f / 65536.0f);
+  return lut[i] + frac * (lut[i + 1] - lut[i]);
+}
+
+// Shepard partial weight for a partial `octaves` above (or below, if negative) the centre
+inline float lutShepardWeight(float octaves) {
+  float x = (octaves + 0.5f * SHEPARD_LUT_OCTAVES) * ((float)SHEPARD_LUT_SIZE / SHEPARD_LUT_OCTAVES);
+  if (x <= 0.0f || x >= (float)SHEPARD_LUT_SIZE) return 0.0f;
+  int i = (int)x;
+  float frac = x - (float)i;
+  return g_shepardLut[i] + frac * (g_shepardLut[i + 1] - g_shepardLut[i]);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+
+// Modal synthesis: a bank of up to MODAL_MAX two-pole resonators, one per vibration mode,
+// each with its own frequency, decay time and gain. Per mode and sample the audio path is
+// y = a1*y1 + a2*y2 (+ b*x while an excitation is running); all trig happens when modes
+// are configured. Strikes are an impulse, a short noise burst or both.
+
+static const int MODAL_MAX = 32;
+
+enum class ModalPreset : uint8_t {
+  DRUM = 0,   // circular membrane (Bessel-zero ratios), short decay
+  BELL,       // church-bell partials: hum, prime, tierce, quint, nominal...
+  BAR,        // free-free bar (glockenspiel/xylophone ratios)
+  PLATE,      // simply supported rectangular plate, 32 modes struck off-centre
+  COUNT
+};
+
+struct ModalBank {
+  int count;
+  float a1[MODAL_MAX], a2[MODAL_MAX], b[MODAL_MAX];
+  float y1[MODAL_MAX], y2[MODAL_MAX];
+  float hz[MODAL_MAX], t60[MODAL_MAX];   // as configured (for printing)
+  // Pending excitation
+  float impulse;
+  int burstLeft;
+  float burstLevel;
+  uint32_t rng;
+};
+
+void modalInit(ModalBank& m);
+
+// Set mode i (0 <= i < MODAL_MAX; grows count). Modes at or above 0.45 * SAMPLE_RATE_HZ are muted.
+void modalSetMode(ModalBank& m, int i, float hz, float t60Sec, float gain);
+
+// Configure the bank from a preset with the given fundamental; returns the mode count
+int modalLoadPreset(ModalBank& m, ModalPreset p, float fundamentalHz);
+const char* getModalPresetName(ModalPreset p);
+
+// Excite on the next rendered sample
+void modalStrike(ModalBank& m, float velocity);
+void modalBurst(ModalBank& m, float velocity, int samples);
+
+// Add n samples (n <= AUDIO_BLOCK_SIZE) of the summed modes into acc
+void modalRender(ModalBank& m, float* acc, int n);
+
+// Modal Drum track: the bank set from modal.preset / modal.pitch, struck periodically
+void renderModalTrack(int16_t* out, int n);
+void printModalTrack();
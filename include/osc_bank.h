@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include "config.h"
+
+// Oscillator bank for unison stacks, additive partials and chords: up to OSC_BANK_MAX voices
+// of one waveform, with phases, increments and gains in separate contiguous arrays. A block
+// is rendered one voice at a time: a short integer pass builds the voice's phase ramp, then
+// a branch-free waveform pass over the block that compilers can vectorize.
+//
+// Phases are integers in 1/OSC_PHASE_ONE of a cycle (SAMPLE_RATE_HZ * 256), so any frequency
+// that is a multiple of 1/256 Hz repeats bit-exactly, as the loop cache requires.
+
+static const int OSC_BANK_MAX = 32;
+static const uint32_t OSC_PHASE_ONE = (uint32_t)SAMPLE_RATE_HZ * 256u;
+
+enum class OscWave : uint8_t {
+  SINE = 0,   // 9th-order polynomial, < 0.1 LSB error at 16 bits
+  SAW,        // naive ramp, -1..1
+  SQUARE      // naive, 50 % duty
+};
+
+struct OscBank {
+  OscWave wave;
+  int count;
+  uint32_t phase[OSC_BANK_MAX];
+  uint32_t inc[OSC_BANK_MAX];
+  float gain[OSC_BANK_MAX];
+};
+
+// count voices, all at 0 Hz, phase 0 and gain 0
+void oscBankInit(OscBank& b, OscWave wave, int count);
+
+void oscBankSetVoice(OscBank& b, int v, float hz, float gain);
+void oscBankSetFreq(OscBank& b, int v, float hz);
+
+// Voice v at baseHz * ratios[v] (unison detune); gains unchanged
+void oscBankSetRatios(OscBank& b, float baseHz, const float* ratios);
+
+// Voice v = harmonic (firstHarmonic + v) of f0 with gain level / harmonic
+void oscBankSetHarmonics(OscBank& b, float f0, int firstHarmonic, float level);
+
+// One voice per MIDI note, equal gains
+void oscBankSetChord(OscBank& b, const uint8_t* notes, int count, float gain);
+
+// Random start phases (from a xorshift32 state)
+void oscBankRandomizePhases(OscBank& b, uint32_t& rng);
+
+// Add n samples (n <= AUDIO_BLOCK_SIZE) of the summed voices into acc
+void oscBankRender(OscBank& b, float* acc, int n);
+
+// Render n samples to int16: out = clamp(sum * scale)
+void oscBankRenderS16(OscBank& b, int16_t* out, int n, float scale);
+
+// Print cycles per sample for 1..OSC_BANK_MAX voices of each waveform, next to a per-sample
+// scalar loop calling sinf (what the unison generators used to do). Uses private banks, so
+// it can run while audio plays.
+void benchOscBank();
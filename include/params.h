@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include "types.h"
+
+// Live parameter registry.
+// loop() (core 1, UI) writes values with setParam(); they travel to the audio task
+// through a single-producer/single-consumer lock-free queue and are applied at the
+// start of each rendered block by applyPendingParams(). Continuous parameters glide
+// toward their target once per block (control rate) so edits never click.
+
+enum class ParamId : uint8_t {
+  TONE_FREQ = 0,        // Sine/Square/Triangle pitch
+  AM_RATE,
+  AM_DEPTH,
+  SUPERSAW_FREQ,
+  PWM_FREQ,
+  PWM_RATE,
+  ISO_CARRIER,
+  ISO_GATE,
+  COMBO_F1,
+  COMBO_F2,
+  COMBO_DRIVE,
+  INFRA_FREQ,
+  INFRA_LEVEL,
+  SOMATIC_FREQ,
+  SOMATIC_PERIOD,
+  HOWL_CENTER,
+  HOWL_SWEEP,
+  FM_METAL_CARRIER,
+  FM_METAL_MOD,
+  FM_METAL_INDEX,
+  PINK_METHOD,          // 0 = Voss-McCartney, 1 = Kellet filter bank
+  TILT_ALPHA,           // spectral slope of Tilt Noise, 1/f^alpha
+  SEQ_BPM,              // tempo shared by the rhythm tracks
+  MODAL_PRESET,         // 0 drum, 1 bell, 2 bar, 3 plate
+  MODAL_PITCH,          // fundamental of the Modal Drum track
+  GRAIN_DENSITY,        // grain onsets per second (Poisson)
+  GRAIN_SIZE,           // ms, +-25 % per grain
+  GRAIN_SPREAD,         // +- semitones of random grain pitch
+  GRAIN_PITCH,
+  GRAIN_SOURCE,         // 0 sine, 1 SuperSaw buffer, 2 pink-noise buffer
+  FORMANT_VOWEL,        // 0 a, 1 e, 2 i, 3 o, 4 u (fractions morph)
+  FORMANT_RATE,         // cycles/s through all five vowels, 0 = hold
+  CHORUS_DEPTH,         // ms of delay modulation per chorus tap
+  FLANGER_FEEDBACK,     // -0.9..0.9
+  DOPPLER_SPEED,        // m/s of the passing source
+  BYTEBEAT_RATE,        // Hz at which t advances
+  VOICE_STEAL,          // 0 quietest, 1 oldest (voice_manager.h)
+  VOICE_DEMO,           // play the built-in progression when no notes arrive
+  REVERB_SEND,
+  REVERB_SIZE,
+  REVERB_DECAY,
+  REVERB_MIX,
+  COUNT
+};
+
+static const int PARAM_COUNT = (int)ParamId::COUNT;
+
+enum class ParamKind : uint8_t {
+  FLOAT,   // smoothed at control rate
+  STEP,    // applied immediately (lengths, switches)
+  BOOL
+};
+
+struct ParamInfo {
+  const char* name;     // "group.param", used by the Serial interface
+  NoiseType owner;      // track the parameter belongs to (informational for globals)
+  bool global;          // applies to every track (e.g. reverb send)
+  ParamKind kind;
+  float minV, maxV, defV;
+};
+
+void initParams();
+
+const ParamInfo& getParamInfo(ParamId id);
+const char* getParamName(ParamId id);
+
+// Look up a parameter by name; returns false if unknown
+bool findParam(const char* name, ParamId* out);
+
+// UI side: clamp and queue a new value. Returns false if the queue was full.
+bool setParam(ParamId id, float v);
+// UI side: last value set (not the audio task's smoothed value)
+float getParam(ParamId id);
+
+// Audio side: drain the queue and advance smoothing; call once per block.
+// Returns true if any parameter target changed in this call.
+bool applyPendingParams();
+
+// Audio side: current (smoothed) value for generators
+float paramValue(ParamId id);
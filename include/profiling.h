@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Arduino.h>
+#include <cstdint>
+
+// Lightweight cycle accounting for the audio hot path.
+// Stats are written from the audio task and read from loop() for reporting;
+// a torn read only skews one report, so no locking is used.
+struct CycleStat {
+  volatile uint32_t cycles;
+  volatile uint32_t samples;
+  volatile uint32_t peak;   // worst single measurement since last reset
+};
+
+// Force-inlined: also used by the sample timer ISR, which must not call into flash
+inline __attribute__((always_inline)) uint32_t cycleNow() {
+  return ESP.getCycleCount();
+}
+
+inline void cycleStatAdd(CycleStat& st, uint32_t cycles, uint32_t samples) {
+  st.cycles = st.cycles + cycles;
+  st.samples = st.samples + samples;
+  if (cycles > st.peak) st.peak = cycles;
+}
+
+inline float cycleStatPerSample(const CycleStat& st) {
+  uint32_t n = st.samples;
+  return n ? (float)st.cycles / (float)n : 0.0f;
+}
+
+inline void cycleStatReset(CycleStat& st) {
+  st.cycles = 0;
+  st.samples = 0;
+  st.peak = 0;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+// Schroeder/Freeverb-style reverb: four damped feedback combs in parallel followed by
+// two series allpasses. All delay lines are power-of-two int16 rings; the per-sample
+// path is integer-only. A single instance is shared by the gated-reverb track and the
+// optional send that can be enabled on any other track.
+
+struct ReverbParams {
+  float size;           // 0.25 .. 1.0, scales comb lengths (max ~41 ms)
+  float decay;          // 0.0 .. 1.0, maps to comb feedback 0.70 .. 0.97
+  float damping;        // 0.0 .. 1.0, lowpass in the comb feedback path
+  float mix;            // 0.0 (dry) .. 1.0 (wet)
+  bool gate;            // shut the wet tail once the input has been quiet for gateHoldSec
+  float gateThreshold;  // input envelope level (0..1) below which the hold timer runs
+  float gateHoldSec;
+};
+
+extern const ReverbParams REVERB_ROOM;
+extern const ReverbParams REVERB_GATED;
+
+void initReverb();
+
+// Take the delay lines from the DSP arena (no-op if already attached) and clear them.
+// processReverb passes audio through unchanged while detached.
+bool attachReverb();
+// Drop the delay lines before the arena is reset
+void releaseReverb();
+void clearReverb();
+
+void setReverbParams(const ReverbParams& p);
+ReverbParams getReverbParams();
+
+// Process a block in place
+void processReverb(int16_t* buf, int n);
+
+// Memory used by the reverb while attached (arena delay lines + static state)
+uint32_t getReverbMemoryBytes();
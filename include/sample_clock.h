@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+// Shared timebase: a monotonic 64-bit count of audio samples that have reached the DAC.
+// The output stage publishes an anchor (sample count, esp_timer microseconds) at every block
+// boundary and readers on either core interpolate from it, capped at one block so the clock
+// never runs ahead of the next anchor. DAC repeats on underrun do not count, so a sample's
+// clock value is exactly when it is heard; the clock holds while audio is paused.
+//
+// The render side keeps a second counter, the render clock: the clock value of the first
+// sample of the block being rendered. Generators stamp events with it, and the display can
+// then show each event when it is heard rather than when it was computed.
+
+// Audio side (output stage)
+void sampleClockAdvance(uint32_t samples);  // samples reached the DAC (ISR safe)
+void sampleClockStop();                     // output stopped; the clock holds its current value
+void sampleClockSyncRender();               // the next block rendered is the next one heard
+void sampleClockBlockRendered(uint32_t samples);
+
+// Render side: clock value of sample 0 of the block being rendered
+uint64_t getRenderClock();
+
+// Any core
+uint64_t getSampleClock();
+bool sampleClockRunning();
+int64_t sampleClockToUs(uint64_t clock);    // esp_timer time at which the sample is (was) heard
+uint64_t sampleClockAtUs(int64_t us);
+
+// Display: record a frame that showed audio up to `shownClock` and has just been pushed to
+// the panel. The average audio-to-display latency feeds getDisplayClock(), the audio time
+// to draw against so that what appears on screen matches what is heard.
+void sampleClockNoteFrame(uint64_t shownClock);
+uint64_t getDisplayClock();
+uint32_t getAvLatencyUs();                  // running average
+uint32_t getRenderLeadUs();                 // render clock ahead of the DAC, i.e. output latency
+
+// Print the clock, its measured rate and the latency figures (min/avg/max since last call)
+void printSampleClock();
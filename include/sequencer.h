@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include "types.h"
+
+// Step sequencer for the rhythm tracks: up to SEQ_LANES polymetric lanes, each with its own
+// Euclidean pattern, step count, subdivision of the beat and voice. Step times come from a
+// 16.16 fixed-point countdown per lane, so events land on the exact sample (no drift at any
+// BPM). Events are collected once per block and the voices render in runs between them.
+// Each step is stamped with its sample-clock time (sample_clock.h), so visuals can show it
+// when it is heard rather than when it was rendered.
+
+static const int SEQ_LANES = 4;
+static const int SEQ_MAX_STEPS = 32;
+
+// Euclidean (Bjorklund) rhythm as a bit mask, bit i = step i. Onsets are spread as evenly
+// as possible: step i fires when (i + rotation) * k mod n < k. C++11 constexpr, so fixed
+// patterns are built at compile time; the same function serves runtime edits.
+constexpr uint32_t euclidMask(int k, int n, int rotation, int i = 0) {
+  return i >= n ? 0u
+    : ((((i + rotation) % n) * k % n < k ? 1u : 0u) << i) | euclidMask(k, n, rotation, i + 1);
+}
+
+enum class SeqVoice : uint8_t {
+  BLIP = 0,   // sine ping with exponential decay
+  NOISE,      // white-noise burst with exponential decay
+  PLUCK       // Karplus-Strong string (string_bank.h; needs the bank attached)
+};
+
+struct SeqLaneConfig {
+  uint8_t pulses;         // k
+  uint8_t steps;          // n, 1..SEQ_MAX_STEPS (0 = lane off)
+  uint8_t rotation;
+  float stepsPerBeat;     // subdivision; lanes with different values form polyrhythms
+  SeqVoice voice;
+  float freqHz;
+  float decay;            // per-sample envelope multiplier
+  float level;            // 0..1
+};
+
+// Audio side: load the lanes for a rhythm track (called on track selection)
+void seqLoadForType(NoiseType t);
+
+// Audio side: render n samples of the summed lanes; tempo is the seq.bpm parameter
+void renderSequencer(int16_t* out, int n);
+
+// UI side: change a lane's pattern or voice; applied by the audio side at the next block.
+// Turning on an empty lane copies lane 0's subdivision and voice.
+void seqSetPattern(int lane, int pulses, int steps, int rotation);
+void seqSetVoice(int lane, SeqVoice v);
+
+// Snapshot for visuals and Serial (read from any core)
+int seqLaneSteps(int lane);       // 0 if the lane is off
+uint32_t seqLaneMask(int lane);
+int seqLaneStepAt(int lane, uint64_t clock);  // last step heard by `clock`, -1 if none
+
+void printSequencer();
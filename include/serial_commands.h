@@ -0,0 +1,27 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Line-based Serial command interface for automation (115200 baud, '\n' terminated).
+// Non-blocking: call pollSerialCommands() from loop(); it only consumes bytes already received.
+// initSerialCommands() wakes the UI task as soon as bytes arrive and stamps their arrival,
+// which note events carry for the latency figures in voice_manager.h.
+//
+//   help                      list commands
+//   list [all]                parameters of the current track (or all)
+//   get <name>                print one parameter
+//   set <name> <value>        change a parameter (smoothed on the audio task)
+//   track <1..N>              select a track
+//   play | pause              start/stop audio
+//   vol <0..100>              master volume
+//   dither <none|tpdf|shaped> output-stage dither mode
+//   ctrl <1..256>             control-rate K for slow modulators
+//   bench                     time control-rate generators at K = 1 vs current K
+//   pipeline [on|off]         dual-core render pipeline (reports underruns)
+//   ahead <1..7>              render-ahead depth in blocks
+//   load <ms>                 synthetic display load per animated frame
+//   duty                      CPU duty cycle per core since the last report
+// Register the UART receive callback (call after Serial.begin); it notifies `ui`
+void initSerialCommands(TaskHandle_t ui);
+void pollSerialCommands();
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+
+// Spectral noise designer: noise with an arbitrary magnitude curve, synthesised per frame by
+// a randomized-phase inverse FFT and sine-windowed overlap-add. The curve is SPECTRAL_POINTS
+// gains in dB at log-spaced frequencies (linear in dB between points). Output RMS is fixed,
+// so the curve only shapes the spectrum.
+//
+// The UI edits a staged configuration; the audio side picks it up at the next frame
+// boundary, where the overlap-add crossfades old and new spectra, so edits never click.
+// Frame-size and overlap changes restart the overlap-add.
+
+static const int SPECTRAL_POINTS = 12;
+
+struct SpectralConfig {
+  int frame;                       // 64..SPECTRAL_FRAME_MAX, power of two
+  int overlap;                     // 2 or 4 frames per window length
+  float db[SPECTRAL_POINTS];
+};
+
+enum class SpectralPreset : uint8_t {
+  FLAT = 0,
+  NOTCH,      // -30 dB notch around 1 kHz
+  LOW_SHELF,  // +12 dB below 200 Hz
+  BAND,       // 250-900 Hz band, -24 dB elsewhere
+  COUNT
+};
+
+// Centre frequency of curve point i
+float spectralPointHz(int i);
+
+// UI side: read-modify-write the staged configuration (values are clamped)
+void getSpectralConfig(SpectralConfig& c);
+void setSpectralConfig(const SpectralConfig& c);
+void setSpectralPoint(int i, float db);
+void setSpectralPreset(SpectralPreset p);
+const char* getSpectralPresetName(SpectralPreset p);
+
+// Audio side: take buffers from the DSP arena (on selection of the Spectral Noise track)
+bool attachSpectralNoise();
+void releaseSpectralNoise();
+void renderSpectralNoise(int16_t* out, int n);
+
+// Print the current curve and frame settings
+void printSpectralConfig();
+
+// Time frame synthesis for every frame size and overlap and print cycles per frame,
+// cycles per sample and share of the per-sample budget. Uses private buffers, so it can
+// run while audio plays; the heap allocation is released afterwards.
+void benchSpectralNoise();
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+// Polyphonic Karplus-Strong string bank.
+// Each string is a power-of-two int16 ring buffer with a two-point averaging loss
+// filter and a first-order allpass for fractional-delay tuning. Plucks inject a
+// precomputed noise burst over one period instead of refilling the buffer.
+
+static const int STRING_VOICES = 6;
+static const int STRING_BUF_LEN = 512;   // power of two; lowest pitch ~21.5 Hz at 11,025 Hz
+
+struct PluckEvent {
+  uint8_t note;      // MIDI note number, 0 = rest
+  uint8_t velocity;  // 1..127
+};
+
+// Clear all strings and the pattern; no buffers are attached (call once during setup)
+void initStringBank();
+
+// Allocate ring buffers and the excitation table from the DSP arena ("strings").
+// Returns false when the arena is full; the bank then renders silence.
+bool attachStringBank();
+
+// Drop the arena buffers (before arenaReset on a track change)
+void releaseStringBank();
+
+// Arena bytes taken by an attached bank
+uint32_t getStringBankBytes();
+
+// Start a string at the given pitch; steals the oldest voice when all are busy
+void pluckString(float freqHz, uint8_t velocity);
+
+// Drive plucks from a looping pattern, one event per step (pattern is not copied)
+void setPluckPattern(const PluckEvent* events, int count, int stepSamples);
+
+// Render n samples of the summed strings (advances the pattern sample-accurately)
+void renderStringBank(int16_t* out, int n);
+
+// Convert a MIDI note number to Hz
+float midiNoteToHz(uint8_t note);
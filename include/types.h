@@ -49,7 +49,24 @@ enum class NoiseType : uint8_t {
   FX_PHASER,
   FX_DOPPLER,
   FX_GATED_REVERB,
-  FX_ALIASING_BUZZ
+  FX_ALIASING_BUZZ,
+  NOISE_TILT,             // 1/f^alpha noise, alpha from the tilt.alpha parameter
+  NOISE_SPECTRAL,         // IFFT overlap-add noise from an editable curve (spectral_noise.h)
+  TONE_BYTEBEAT,          // formula of t compiled to bytecode (bytebeat.h)
+  TONE_VOICES             // polyphonic notes from MIDI / `note` events (voice_manager.h)
+};
+
+// Insert effects available to the per-track chain (see include/fx_chain.h)
+enum class FxType : uint8_t {
+  NONE = 0,
+  BITCRUSH,     // amplitude quantization + sample hold
+  DOWNSAMPLE,   // swept sample-rate reduction (aliasing)
+  PHASER,       // swept allpass stages mixed with the dry signal
+  STUTTER,      // captures short slices of the input and repeats them
+  FORMANT,      // three parallel resonant bandpasses (vowel-like)
+  CHORUS,       // three slowly modulated 12 ms taps
+  FLANGER,      // swept 0.2..5 ms delay with feedback
+  DOPPLER       // source passing by: distance sets the delay and level
 };
 
 // Get noise type for current track
@@ -60,3 +77,10 @@ const char* getNoiseTypeName(NoiseType t);
 
 // Get gain normalization factor for noise type
 float getGainForType(NoiseType t);
+
+// Default insert-effect chain for a noise type; returns the number of entries written (<= 4)
+int getFxChainForType(NoiseType t, FxType* out);
+
+// Exact period in samples of a strictly periodic track (integer-Hz partials on an
+// exact phase accumulator), or 0 if the track is not periodic
+int getLoopPeriodForType(NoiseType t);
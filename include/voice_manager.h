@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+// Polyphonic note player for the Voices track. Note-on/off events (key, pitch, velocity,
+// generator) are queued from the UI core and applied by the audio side at the start of its
+// next block; each note-on takes a voice from a fixed pool, stealing one when all are busy.
+// Nothing is allocated: the pool and the queue are static, and plucks use the string bank.
+//
+// Events arrive as MIDI bytes mixed into the Serial text stream (any byte >= 0x80 starts a
+// message, so a host can send a .mid track's raw events or a captured byte file as-is) or as
+// `note` commands. Running status is not supported: its bare data bytes would be
+// indistinguishable from typed text. The MIDI channel picks the generator (program change
+// reassigns it); note-on with velocity 0 is a note-off and CC 120/123 silence everything.
+//
+// Latency is measured per note, from the event's arrival at the UART to the time its first
+// sample reaches the DAC (sample_clock.h), and split into input (arrival until the UI loop
+// parses it), queueing (parse to render) and output (render to DAC).
+
+static const int VOICE_MAX = 8;
+static const int VOICE_EVENT_QUEUE = 32;  // power of two
+
+enum class VoiceGen : uint8_t {
+  SINE = 0,
+  SAW,      // PolyBLEP band-limited
+  SQUARE,   // PolyBLEP band-limited
+  FM,       // FM Bell patch (fm_engine.h)
+  PLUCK,    // Karplus-Strong string (string_bank.h, its own 6-string pool)
+  COUNT
+};
+
+enum class VoiceSteal : uint8_t {
+  QUIETEST = 0,  // lowest current level, wherever it is in its envelope
+  OLDEST,        // earliest note-on, released notes first
+};
+
+const char* getVoiceGenName(VoiceGen g);
+bool findVoiceGen(const char* name, VoiceGen* out);
+
+// UI side. Keys identify a note for its note-off: MIDI uses (channel << 8) | note and
+// `note` commands use voiceKeyForHz. Return false when the queue is full.
+// Arrival time (esp_timer) of the input being parsed; events pushed until the next call are
+// stamped with it instead of the time they are pushed (0)
+void voiceSetInputArrival(int64_t us);
+
+bool voiceNoteOn(uint16_t key, float hz, uint8_t velocity, VoiceGen gen);
+bool voiceNoteOff(uint16_t key);
+bool voicePanic();
+uint16_t voiceKeyForHz(float hz);
+
+// Feed one Serial byte; returns true when it belongs to a MIDI message (the caller then
+// keeps it out of the text line)
+bool voiceMidiByte(uint8_t b);
+
+// Audio side: attach the string bank (on selection of the Voices track), drop queued events
+// and silence the pool
+bool attachVoices();
+void releaseVoices();
+void renderVoices(int16_t* out, int n);
+
+// Print the pool, steal/drop counts and note-on latency (min/avg/max and its parts since the
+// last call)
+void printVoices();
@@ -0,0 +1,189 @@
+#include "audio_master.h"
+#include "audio_synthesis.h"  // clampU8, clampS16
+#include "config.h"
+#include <Arduino.h>
+
+// Master gain target in Q15 (32768 == unity) so the per-sample path stays integer.
+static volatile float g_masterGain = 1.0f;
+static volatile int32_t g_masterGainQ15 = 32768;
+static volatile DitherMode g_ditherMode = DitherMode::TPDF_SHAPED;
+
+// Output-stage state (audio task only)
+static uint32_t g_ditherRng = 0x9E3779B9u;
+static int32_t g_shapeErr = 0;
+
+/* =========================
+   Master bus state (audio task only)
+   ========================= */
+
+// Smoothed gain, Q23 so the one-pole step never stalls short of the target
+static int32_t g_busGainQ23 = 32768 << 8;
+static const int BUS_GAIN_SHIFT = 7;           // ~12 ms time constant at 11,025 Hz
+
+// DC blocker y = x - x1 + R*y1 with R = 1 - 2^-9 (corner ~3.4 Hz, keeps the 12 Hz infrasound track)
+static const int DC_FRAC = 8;
+static const int DC_POLE_SHIFT = 9;
+static int32_t g_dcX1 = 0;
+static int32_t g_dcYq = 0;
+
+// Lookahead peak limiter: the dry signal is delayed by LIMIT_LOOKAHEAD samples so the
+// gain envelope has fully ramped down by the time a peak reaches the output.
+static const int LIMIT_LOOKAHEAD = 32;         // power of two, ~2.9 ms
+static const int32_t LIMIT_CEILING = 31130;    // ~ -0.45 dBFS
+static const int LIMIT_RELEASE_SHIFT = 10;     // ~93 ms release
+static int16_t g_limDelay[LIMIT_LOOKAHEAD];
+static uint32_t g_limIdx = 0;
+static int32_t g_limEnv = 32768;               // current gain, Q15
+static int32_t g_limTarget = 32768;
+static int32_t g_limStep = 0;
+static int32_t g_limHold = 0;
+static volatile int32_t g_limMinEnv = 32768;   // deepest reduction since last query
+
+static inline uint32_t ditherRand() {
+  // xorshift32: a few cycles per call, far cheaper than random()
+  uint32_t x = g_ditherRng;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  g_ditherRng = x;
+  return x;
+}
+
+void processMasterBus(int16_t* buf, int n) {
+  const int32_t gainTargetQ23 = g_masterGainQ15 << 8;
+  int32_t gq23 = g_busGainQ23;
+  int32_t dcX1 = g_dcX1, dcYq = g_dcYq;
+  int32_t env = g_limEnv, target = g_limTarget, step = g_limStep, hold = g_limHold;
+  int32_t minEnv = g_limMinEnv;
+  uint32_t li = g_limIdx;
+
+  for (int i = 0; i < n; ++i) {
+    int32_t x = buf[i];
+
+    // DC blocker
+    dcYq += ((x - dcX1) << DC_FRAC) - (dcYq >> DC_POLE_SHIFT);
+    dcX1 = x;
+    x = dcYq >> DC_FRAC;
+
+    // Smoothed master gain
+    int32_t dg = gainTargetQ23 - gq23;
+    gq23 += (dg > 0 && dg < (1 << BUS_GAIN_SHIFT)) ? dg : (dg >> BUS_GAIN_SHIFT);
+    x = (int32_t)(((int64_t)x * (gq23 >> 8)) >> 15);
+
+    // Limiter detector on the undelayed signal
+    int32_t ax = x < 0 ? -x : x;
+    if (ax > LIMIT_CEILING) {
+      int32_t need = (int32_t)(((int64_t)LIMIT_CEILING << 15) / ax);
+      if (need < target) {
+        target = need;
+        step = (env - need) / LIMIT_LOOKAHEAD + 1;
+        hold = 2 * LIMIT_LOOKAHEAD;
+      } else if (need == target) {
+        hold = 2 * LIMIT_LOOKAHEAD;
+      }
+    }
+    if (hold > 0) --hold;
+    else target = 32768;
+
+    if (env > target) {
+      env -= step;
+      if (env < target) env = target;
+    } else if (env < target) {
+      env += ((target - env) >> LIMIT_RELEASE_SHIFT) + 1;
+      if (env > target) env = target;
+    }
+    if (env < minEnv) minEnv = env;
+
+    // Delay line: emit the sample from LIMIT_LOOKAHEAD ago with the current gain
+    int32_t delayed = g_limDelay[li];
+    g_limDelay[li] = clampS16(x);
+    li = (li + 1) & (LIMIT_LOOKAHEAD - 1);
+    buf[i] = clampS16((delayed * env) >> 15);
+  }
+
+  g_busGainQ23 = gq23;
+  g_dcX1 = dcX1; g_dcYq = dcYq;
+  g_limEnv = env; g_limTarget = target; g_limStep = step; g_limHold = hold;
+  g_limMinEnv = minEnv;
+  g_limIdx = li;
+}
+
+float takeLimiterMinGain() {
+  float g = (float)g_limMinEnv / 32768.0f;
+  g_limMinEnv = 32768;
+  return g;
+}
+
+uint8_t masterOutputU8(int16_t s) {
+  if (g_busGainQ23 == 0) {
+    g_shapeErr = 0;
+    return 128;  // hard mute: no dither hiss at zero volume
+  }
+  int32_t x = s;
+
+  DitherMode mode = g_ditherMode;
+  int32_t v = x;
+  int32_t d = 0;
+  if (mode == DitherMode::TPDF_SHAPED) v -= g_shapeErr;
+  if (mode != DitherMode::NONE) {
+    uint32_t r = ditherRand();
+    d = (int32_t)(r & 0xFF) + (int32_t)((r >> 8) & 0xFF) - 255;  // triangular, +/-1 LSB8
+  }
+
+  int32_t q = (v + d + 128) >> 8;  // round to 8 bits (arithmetic shift)
+  if (q < -128) q = -128;
+  if (q > 127) q = 127;
+
+  if (mode == DitherMode::TPDF_SHAPED) {
+    int32_t e = (q << 8) - v;
+    // Bound the feedback so a clipped peak cannot wind the loop up.
+    if (e > 512) e = 512;
+    if (e < -512) e = -512;
+    g_shapeErr = e;
+  }
+  return clampU8(q + 128);
+}
+
+void initAudioMaster() {
+  g_ditherRng = 0x9E3779B9u ^ (uint32_t)micros();
+  if (g_ditherRng == 0) g_ditherRng = 1;
+  g_shapeErr = 0;
+  setMasterGain(1.0f);
+  g_busGainQ23 = g_masterGainQ15 << 8;
+  g_dcX1 = 0;
+  g_dcYq = 0;
+  for (int i = 0; i < LIMIT_LOOKAHEAD; ++i) g_limDelay[i] = 0;
+  g_limIdx = 0;
+  g_limEnv = g_limTarget = 32768;
+  g_limStep = g_limHold = 0;
+  g_limMinEnv = 32768;
+}
+
+void setDitherMode(DitherMode m) {
+  g_ditherMode = m;
+}
+
+DitherMode getDitherMode() {
+  return g_ditherMode;
+}
+
+const char* getDitherModeName(DitherMode m) {
+  switch (m) {
+    case DitherMode::NONE:        return "None";
+    case DitherMode::TPDF:        return "TPDF";
+    case DitherMode::TPDF_SHAPED: return "TPDF+Shaped";
+    default: return "Unknown";
+  }
+}
+
+void setMasterGain(float g) {
+  if (g < 0.0f) g = 0.0f;
+  if (g > 1.0f) g = 1.0f;
+  g_masterGain = g;
+  // Only the target moves; processMasterBus() glides toward it per sample.
+  g_masterGainQ15 = (int32_t)(g * 32768.0f + 0.5f);
+}
+
+float getMasterGain() {
+  return g_masterGain;
+}
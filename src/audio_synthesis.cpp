@@ -2,9 +2,35 @@
 #include "config.h"
 #include "types.h"
 #include "audio_extras.h"
+#include "audio_master.h"
+#include "profiling.h"
+#include "string_bank.h"
+#include "reverb.h"
+#include "fx_chain.h"
+#include "params.h"
+#include "control_rate.h"
+#include "loop_cache.h"
+#include "cpu_load.h"
+#include "lut.h"
+#include "boot_profile.h"
+#include "dsp_arena.h"
+#include "colored_noise.h"
+#include "spectral_noise.h"
+#include "sequencer.h"
+#include "sample_clock.h"
+#include "osc_bank.h"
+#include "modal_bank.h"
+#include "fm_engine.h"
+#include "granular.h"
+#include "bytebeat.h"
+#include "voice_manager.h"
+#include "filters.h"
 #include <Arduino.h>
 #include <math.h>
+#include <atomic>
 #include "driver/dac.h"
+#include "soc/rtc_io_reg.h"
+#include "soc/soc.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
@@ -19,75 +45,107 @@ volatile float g_shepBaseHzUp = 110.0f;
 volatile float g_shepBaseHzDown = 1760.0f;
 volatile float g_shepPhaseUp[12] = {0,0,0,0,0,0,0,0,0,0,0,0};
 volatile float g_shepPhaseDown[12] = {0,0,0,0,0,0,0,0,0,0,0,0};
-volatile float g_masterGain = 1.0f;
+
+// Cycle accounting (see printAudioProfile)
+static CycleStat g_profSynth = {0, 0, 0};
+static CycleStat g_profBus = {0, 0, 0};
+static CycleStat g_profReverb = {0, 0, 0};
+
+// Reverb send for tracks other than FX_GATED_REVERB (which always uses it)
+static volatile bool g_reverbSend = false;
+static volatile bool g_reverbSendParamsDirty = false;
+static ReverbParams g_reverbSendParams = REVERB_ROOM;
+static CycleStat g_profOutput = {0, 0, 0};
+
+// Render-ahead FIFO of 8-bit output blocks: renderTask produces, audioTask consumes
+static uint8_t g_fifo[AUDIO_FIFO_BLOCKS][AUDIO_BLOCK_SIZE];
+static std::atomic<uint32_t> g_fifoHead(0);  // next block to write (renderTask)
+static std::atomic<uint32_t> g_fifoTail(0);  // next block to play (audioTask)
+static volatile bool g_pipelineRequested = AUDIO_PIPELINE_DEFAULT;
+static volatile bool g_pipelineActive = AUDIO_PIPELINE_DEFAULT;
+static volatile int g_renderAhead = AUDIO_RENDER_AHEAD_DEFAULT;
+static volatile uint32_t g_underruns = 0;
+static TaskHandle_t g_renderTaskHandle = nullptr;
+static TaskHandle_t g_audioTaskHandle = nullptr;
+static hw_timer_t* g_sampleTimer = nullptr;
+static volatile int g_isrPos = 0;        // next sample within the FIFO's tail block
+static volatile uint8_t g_isrLast = 128; // repeated on underrun
 
 // Oscilloscope ring buffer (shared with visual)
 extern volatile uint8_t g_visRing[1024];
 extern volatile uint16_t g_visWriteIdx;
 
 
-uint8_t nextWhiteSample() {
-  int s = random(-128, 128);
-  return (uint8_t)(s + 128);
+/* === Colored noise (see colored_noise.h) === */
+
+static uint32_t g_noiseRng = 0x9E3779B9u;
+static VossPink g_vossPink;
+static KelletPink g_kelletPink;
+static SlopeNoise g_slopeNoise;  // shared by brown/blue/violet/tilt, redesigned on change
+static bool g_pinkReady = false;
+static bool g_slopeReady = false;
+
+static void useSlopeNoise(float alpha, float targetRms) {
+  if (g_slopeReady && g_slopeNoise.alpha == alpha) return;
+  slopeNoiseInit(g_slopeNoise, alpha, targetRms, g_slopeReady ? g_slopeNoise.rng : 0x6A09E667u);
+  g_slopeReady = true;
 }
 
-uint8_t nextPinkSample() {
-  static const int OCTAVES = 16;
-  static uint32_t counter = 0;
-  static int32_t rows[OCTAVES];
-  static bool init = false;
-  if (!init) {
-    for (int i = 0; i < OCTAVES; ++i) rows[i] = random(-32768, 32767);
-    init = true;
-  }
-  counter++;
-  uint32_t ctz = __builtin_ctz(counter);
-  if (ctz >= OCTAVES) ctz = OCTAVES - 1;
-  for (uint32_t i = 0; i <= ctz; ++i) {
-    rows[i] = random(-32768, 32767);
+// Block renderer for the five noise colours and Tilt Noise
+static void renderNoiseBlock(NoiseType t, int16_t* out, int n) {
+  switch (t) {
+    case NoiseType::NOISE_PINK:
+      if (!g_pinkReady) {
+        vossInit(g_vossPink, 0xBB67AE85u);
+        kelletInit(g_kelletPink, 0x3C6EF372u);
+        g_pinkReady = true;
+      }
+      if (paramValue(ParamId::PINK_METHOD) >= 0.5f) renderKelletPink(g_kelletPink, out, n);
+      else renderVossPink(g_vossPink, out, n);
+      return;
+    case NoiseType::NOISE_BROWN:  useSlopeNoise(2.0f, 12000.0f);  break;
+    case NoiseType::NOISE_BLUE:   useSlopeNoise(-1.0f, 10000.0f); break;
+    case NoiseType::NOISE_VIOLET: useSlopeNoise(-2.0f, 12000.0f); break;
+    case NoiseType::NOISE_TILT:   useSlopeNoise(paramValue(ParamId::TILT_ALPHA), 10000.0f); break;
+    default:
+      renderWhiteNoise(g_noiseRng, out, n);
+      return;
   }
-  int64_t sum = 0;
-  for (int i = 0; i < OCTAVES; ++i) sum += rows[i];
-  float s = (float)sum / (float)(OCTAVES * 32768.0f);
-  int sample = (int)(s * 127.0f);
-  return clampU8(sample + 128);
-}
-
-uint8_t nextBrownSample() {
-  static float acc = 0.0f;
-  float step = (float)random(-64, 65) / 256.0f;
-  acc += step;
-  acc *= 0.995f;
-  if (acc < -1.0f) acc = -1.0f;
-  if (acc > 1.0f) acc = 1.0f;
-  int sample = (int)(acc * 127.0f);
-  return clampU8(sample + 128);
-}
-
-uint8_t nextBlueSample() {
-  static int prevW = 0;
-  int w = random(-128, 128);
-  int diff = w - prevW;
-  prevW = w;
-  int sample = (w + diff) / 2;
-  if (sample < -128) sample = -128;
-  if (sample > 127) sample = 127;
-  return (uint8_t)(sample + 128);
-}
-
-uint8_t nextVioletSample() {
-  static int w1 = 0, w2 = 0;
-  int w0 = random(-128, 128);
-  int sample = w0 - 2 * w1 + w2;
-  w2 = w1;
-  w1 = w0;
-  sample /= 3;
-  if (sample < -128) sample = -128;
-  if (sample > 127) sample = 127;
-  return (uint8_t)(sample + 128);
-}
-
-uint8_t nextToneSample(NoiseType t) {
+  renderSlopeNoise(g_slopeNoise, out, n);
+}
+
+static inline bool isNoiseColorType(NoiseType t) {
+  return t == NoiseType::NOISE_WHITE || t == NoiseType::NOISE_PINK || t == NoiseType::NOISE_BROWN ||
+         t == NoiseType::NOISE_BLUE || t == NoiseType::NOISE_VIOLET || t == NoiseType::NOISE_TILT;
+}
+
+static inline int16_t nextNoiseSample(NoiseType t) {
+  int16_t v;
+  renderNoiseBlock(t, &v, 1);
+  return v;
+}
+
+int16_t nextWhiteSample() {
+  return nextNoiseSample(NoiseType::NOISE_WHITE);
+}
+
+int16_t nextPinkSample() {
+  return nextNoiseSample(NoiseType::NOISE_PINK);
+}
+
+int16_t nextBrownSample() {
+  return nextNoiseSample(NoiseType::NOISE_BROWN);
+}
+
+int16_t nextBlueSample() {
+  return nextNoiseSample(NoiseType::NOISE_BLUE);
+}
+
+int16_t nextVioletSample() {
+  return nextNoiseSample(NoiseType::NOISE_VIOLET);
+}
+
+int16_t nextToneSample(NoiseType t) {
   float freq = 440.0f;
   float step = 0.0f;
   float v = 0.0f;
@@ -96,7 +154,7 @@ uint8_t nextToneSample(NoiseType t) {
     case NoiseType::TONE_SINE:
     case NoiseType::TONE_SQUARE:
     case NoiseType::TONE_TRIANGLE:
-      freq = 440.0f;
+      freq = paramValue(ParamId::TONE_FREQ);
       step = TAU_F * freq / (float)SAMPLE_RATE_HZ;
       step += ((float)random(-1, 2)) * 0.00005f;
       g_phase += step;
@@ -134,21 +192,8 @@ uint8_t nextToneSample(NoiseType t) {
       break;
     }
     
-    case NoiseType::TONE_FM_BELL: {
-      float fc = 440.0f, fm = 110.0f, beta = 2.0f;
-      float step_m = TAU_F * fm / (float)SAMPLE_RATE_HZ;
-      g_phase_mod += step_m;
-      if (g_phase_mod >= TAU_F) g_phase_mod -= TAU_F;
-      float instFreq = fc + beta * fm * sinf(g_phase_mod);
-      float step_c = TAU_F * instFreq / (float)SAMPLE_RATE_HZ;
-      g_phase += step_c;
-      if (g_phase >= TAU_F) g_phase -= TAU_F;
-      v = sinf(g_phase);
-      break;
-    }
-
     case NoiseType::TONE_AM_TREMOLO: {
-      float fc = 440.0f, fm = 5.0f, depth = 0.8f;
+      float fc = 440.0f, fm = paramValue(ParamId::AM_RATE), depth = paramValue(ParamId::AM_DEPTH);
       float step_c = TAU_F * fc / (float)SAMPLE_RATE_HZ;
       float step_m = TAU_F * fm / (float)SAMPLE_RATE_HZ;
       g_phase += step_c;
@@ -168,44 +213,46 @@ uint8_t nextToneSample(NoiseType t) {
   }
 
   v *= 0.9f;
-  int s = (int)(v * 127.0f);
-  return clampU8(s + 128);
+  return clampS16((int32_t)(v * 32767.0f));
 }
 
-uint8_t nextShepardUpU8() {
+// Sum of 12 octave-spaced partials under a fixed Gaussian (in log-frequency) centred on 440 Hz.
+// Sine and weight come from lazily built tables (lut.h, prepared on track selection).
+static float shepardMix(float baseHz, volatile float* phases) {
+  if (!g_sineLut || !g_shepardLut) return 0.0f;  // arena full: stay silent
   const int PARTS = 12;
   const float center = 440.0f;
-  const float rateSec = 6.0f;
-  const float rate = powf(2.0f, 1.0f / (SAMPLE_RATE_HZ * rateSec));
-
-  g_shepBaseHzUp *= rate;
-  if (g_shepBaseHzUp > center * 2.0f) g_shepBaseHzUp *= 0.5f;
-
+  const float baseOct = log2f(baseHz / center);
+  float f = baseHz / (float)(1 << (PARTS/2 - 1));  // partial j is baseHz * 2^(j - 5)
   float sum = 0.0f, wsum = 0.0f;
-  const float sigma = 0.55f;
 
-  for (int j = 0; j < PARTS; ++j) {
-    int k = j - (PARTS/2 - 1);
-    float f = g_shepBaseHzUp * powf(2.0f, (float)k);
+  for (int j = 0; j < PARTS; ++j, f *= 2.0f) {
     if (f < 20.0f || f > 6000.0f) continue;
 
-    float step = TAU_F * f / (float)SAMPLE_RATE_HZ;
-    g_shepPhaseUp[j] += step;
-    if (g_shepPhaseUp[j] >= TAU_F) g_shepPhaseUp[j] -= TAU_F;
+    float ph = phases[j] + TAU_F * f / (float)SAMPLE_RATE_HZ;
+    if (ph >= TAU_F) ph -= TAU_F;
+    phases[j] = ph;
 
-    float o = log2f(f / center);
-    float w = expf(-0.5f * (o * o) / (sigma * sigma));
-    sum += w * sinf(g_shepPhaseUp[j]);
+    float w = lutShepardWeight(baseOct + (float)(j - (PARTS/2 - 1)));
+    sum += w * lutSin(ph);
     wsum += w;
   }
+  return (wsum > 0.0f) ? (sum / wsum) : 0.0f;
+}
 
-  float v = (wsum > 0.0f) ? (sum / wsum) : 0.0f;
-  int s = (int)(v * 127.0f);
-  return clampU8(s + 128);
+int16_t nextShepardUpS16() {
+  const float center = 440.0f;
+  const float rateSec = 6.0f;
+  const float rate = powf(2.0f, 1.0f / (SAMPLE_RATE_HZ * rateSec));
+
+  g_shepBaseHzUp *= rate;
+  if (g_shepBaseHzUp > center * 2.0f) g_shepBaseHzUp *= 0.5f;
+
+  float v = shepardMix(g_shepBaseHzUp, g_shepPhaseUp);
+  return clampS16((int32_t)(v * 32767.0f));
 }
 
-uint8_t nextShepardDownU8() {
-  const int PARTS = 12;
+int16_t nextShepardDownS16() {
   const float center = 440.0f;
   const float rateSec = 6.0f;
   const float rate = powf(2.0f, 1.0f / (SAMPLE_RATE_HZ * rateSec));
@@ -213,273 +260,169 @@ uint8_t nextShepardDownU8() {
   g_shepBaseHzDown /= rate;
   if (g_shepBaseHzDown < center * 0.5f) g_shepBaseHzDown *= 2.0f;
 
-  float sum = 0.0f, wsum = 0.0f;
-  const float sigma = 0.55f;
-
-  for (int j = 0; j < PARTS; ++j) {
-    int k = j - (PARTS/2 - 1);
-    float f = g_shepBaseHzDown * powf(2.0f, (float)k);
-    if (f < 20.0f || f > 6000.0f) continue;
+  float v = shepardMix(g_shepBaseHzDown, g_shepPhaseDown);
+  return clampS16((int32_t)(v * 32767.0f));
+}
 
-    float step = TAU_F * f / (float)SAMPLE_RATE_HZ;
-    g_shepPhaseDown[j] += step;
-    if (g_shepPhaseDown[j] >= TAU_F) g_shepPhaseDown[j] -= TAU_F;
+// Karplus track: a looping strum-and-pick figure over G major on the string bank
+static const PluckEvent kKarplusPattern[] = {
+  {43, 110}, {47, 90}, {50, 90}, {55, 100}, {59, 90}, {67, 100}, {0, 0}, {0, 0},
+  {62, 110}, {0, 0}, {59, 80}, {0, 0}, {55, 100}, {57, 70}, {59, 90}, {0, 0},
+  {40, 120}, {47, 90}, {52, 90}, {55, 100}, {59, 90}, {64, 100}, {0, 0}, {0, 0},
+  {67, 110}, {66, 80}, {64, 90}, {0, 0}, {62, 100}, {0, 0}, {59, 90}, {0, 0},
+};
+static const int KARPLUS_STEP_SAMPLES = SAMPLE_RATE_HZ / 8;
 
-    float o = log2f(f / center);
-    float w = expf(-0.5f * (o * o) / (sigma * sigma));
-    sum += w * sinf(g_shepPhaseDown[j]);
-    wsum += w;
-  }
+int16_t nextKarplusS16() {
+  int16_t s;
+  renderStringBank(&s, 1);
+  return s;
+}
 
-  float v = (wsum > 0.0f) ? (sum / wsum) : 0.0f;
-  int s = (int)(v * 127.0f);
-  return clampU8(s + 128);
-}
-
-uint8_t nextKarplusU8() {
-  static const int MAX_KS_LEN = 256;
-  static float buf[MAX_KS_LEN];
-  static int len = 0, idx = 0, repluck = 0;
-  if (len == 0) {
-    float f = 196.0f;
-    len = (int)((float)SAMPLE_RATE_HZ / f);
-    if (len < 8) len = 8;
-    if (len > MAX_KS_LEN) len = MAX_KS_LEN;
-    repluck = (int)(0.8f * SAMPLE_RATE_HZ);
-    for (int i = 0; i < len; ++i) buf[i] = ((float)random(-128, 128)) / 256.0f;
-  }
-  if (--repluck <= 0) {
-    for (int i = 0; i < len; ++i) buf[i] = ((float)random(-128, 128)) / 256.0f;
-    repluck = (int)(0.8f * SAMPLE_RATE_HZ);
-  }
-  int next = (idx + 1) % len;
-  float y = buf[idx];
-  buf[idx] = 0.5f * (buf[idx] + buf[next]) * 0.996f;
-  idx = next;
-  return clampU8((int)(y * 127.0f) + 128);
+int16_t nextModalDrumS16() {
+  int16_t s;
+  renderModalTrack(&s, 1);
+  return s;
 }
 
-uint8_t nextModalDrumU8() {
-  static const int N = 4;
-  static const float freqs[N] = {180.0f, 300.0f, 460.0f, 620.0f};
-  static const float gains[N] = {1.0f, 0.6f, 0.45f, 0.35f};
-  static float phase[N] = {0}, env = 0.0f;
-  static int retrig = 0;
-  if (env < 0.0008f && retrig <= 0) {
-    env = 1.0f;
-    for (int i = 0; i < N; ++i) phase[i] = (float)random(0, 1000) * 0.001f * TAU_F;
-    retrig = (int)(0.6f * SAMPLE_RATE_HZ);
-  }
-  if (retrig > 0) retrig--;
-  float sum = 0.0f;
-  for (int i = 0; i < N; ++i) {
-    float step = TAU_F * freqs[i] / (float)SAMPLE_RATE_HZ;
-    phase[i] += step;
-    if (phase[i] >= TAU_F) phase[i] -= TAU_F;
-    sum += gains[i] * sinf(phase[i]);
-  }
-  sum *= env;
-  env *= 0.9992f;
-  int s = (int)(sum * 100.0f);
-  if (s < -127) s = -127;
-  if (s > 127) s = 127;
-  return (uint8_t)(s + 128);
-}
-
-uint8_t nextGranularU8() {
-  struct Grain { bool on; float phase, dphase, amp, adec; int left; };
-  static Grain g[8] = {};
-  if (random(0, 1000) < 6) {
-    for (int i = 0; i < 8; ++i) if (!g[i].on) {
-      float f = (float)random(200, 2000);
-      int dur = random((int)(0.05f * SAMPLE_RATE_HZ), (int)(0.20f * SAMPLE_RATE_HZ));
-      g[i].on = true;
-      g[i].phase = 0.0f;
-      g[i].dphase = TAU_F * f / (float)SAMPLE_RATE_HZ;
-      g[i].amp = 0.15f + (float)random(0, 100) * 0.003f;
-      g[i].adec = powf(0.001f, 1.0f / (float)dur);
-      g[i].left = dur;
-      break;
-    }
-  }
-  float sum = 0.0f;
-  for (int i = 0; i < 8; ++i) if (g[i].on) {
-    sum += g[i].amp * sinf(g[i].phase);
-    g[i].phase += g[i].dphase;
-    if (g[i].phase >= TAU_F) g[i].phase -= TAU_F;
-    g[i].amp *= g[i].adec;
-    if (--g[i].left <= 0 || g[i].amp < 0.001f) g[i].on = false;
-  }
-  return clampU8((int)(sum * 127.0f) + 128);
+int16_t nextGranularS16() {
+  int16_t s;
+  renderGranular(&s, 1);
+  return s;
 }
 
-uint8_t nextSuperSawU8() {
+static void renderSuperSawBlock(int16_t* out, int n) {
   static const int N = 6;
-  static float phase[N] = {0};
   static const float det[N] = {0.985f, 0.992f, 0.998f, 1.002f, 1.008f, 1.015f};
-  float base = 110.0f, sum = 0.0f;
-  for (int i = 0; i < N; ++i) {
-    float f = base * det[i];
-    phase[i] += f / (float)SAMPLE_RATE_HZ;
-    if (phase[i] >= 1.0f) phase[i] -= 1.0f;
-    sum += 2.0f * phase[i] - 1.0f;
+  static OscBank bank;
+  static bool ready = false;
+  if (!ready) {
+    oscBankInit(bank, OscWave::SAW, N);
+    for (int i = 0; i < N; ++i) bank.gain[i] = 1.0f / (float)N;
+    ready = true;
   }
-  sum /= (float)N;
-  return clampU8((int)(sum * 120.0f) + 128);
+  oscBankSetRatios(bank, paramValue(ParamId::SUPERSAW_FREQ), det);
+  oscBankRenderS16(bank, out, n, 30960.0f);
 }
 
-uint8_t nextPwmU8() {
-  static float p = 0.0f, lfo = 0.0f;
-  float fc = 110.0f, fm = 2.0f;
+int16_t nextSuperSawS16() {
+  int16_t s;
+  renderSuperSawBlock(&s, 1);
+  return s;
+}
+
+int16_t nextPwmS16() {
+  static float p = 0.0f;
+  static CtrlLfo lfo = {{0.0f, 0.0f, 0}, 0.0f, 0.0f};
+  float fc = paramValue(ParamId::PWM_FREQ);
+  lfo.hz = paramValue(ParamId::PWM_RATE);
   p += fc / (float)SAMPLE_RATE_HZ;
   if (p >= 1.0f) p -= 1.0f;
-  lfo += fm / (float)SAMPLE_RATE_HZ;
-  if (lfo >= 1.0f) lfo -= 1.0f;
-  float duty = 0.5f + 0.4f * sinf(TAU_F * lfo);
+  float duty = 0.5f + 0.4f * ctrlLfoNext(lfo);
   float v = (p < duty) ? 1.0f : -1.0f;
-  return clampU8((int)(v * 110.0f) + 128);
+  return clampS16((int32_t)(v * 28380.0f));
 }
 
-uint8_t nextBitcrushU8() {
-  static float ph = 0.0f, held = 0.0f;
-  static int hold = 0;
-  const int holdN = 8, q = 8;
-  if (hold == 0) {
-    float f = 220.0f;
-    ph += TAU_F * f / (float)SAMPLE_RATE_HZ;
-    if (ph >= TAU_F) ph -= TAU_F;
-    float v = sinf(ph);
-    float x = (v * 0.5f) + 0.5f;
-    int qi = (int)roundf(x * (q - 1));
-    float xq = (float)qi / (float)(q - 1);
-    held = (xq * 2.0f) - 1.0f;
-    hold = holdN;
-  }
-  hold--;
-  return clampU8((int)(held * 120.0f) + 128);
+// Bitcrush track source: plain 220 Hz sine; crushing is the FxType::BITCRUSH insert
+int16_t nextBitcrushS16() {
+  static float ph = 0.0f;
+  ph += TAU_F * 220.0f / (float)SAMPLE_RATE_HZ;
+  if (ph >= TAU_F) ph -= TAU_F;
+  return clampS16((int32_t)(sinf(ph) * 30960.0f));
 }
 
-uint8_t nextPhaseDistU8() {
-  static float ph = 0.0f, lfo = 0.0f;
-  float fc = 220.0f, fm = 1.2f;
+int16_t nextPhaseDistS16() {
+  static float ph = 0.0f;
+  static CtrlLfo lfo = {{0.0f, 0.0f, 0}, 0.0f, 1.2f};
+  float fc = 220.0f;
   ph += TAU_F * fc / (float)SAMPLE_RATE_HZ;
   if (ph >= TAU_F) ph -= TAU_F;
-  lfo += TAU_F * fm / (float)SAMPLE_RATE_HZ;
-  if (lfo >= TAU_F) lfo -= TAU_F;
-  float amt = 1.2f * (0.5f + 0.5f * sinf(lfo));
+  float amt = 1.2f * (0.5f + 0.5f * ctrlLfoNext(lfo));
   float v = sinf(ph + amt * sinf(ph));
-  return clampU8((int)(v * 120.0f) + 128);
+  return clampS16((int32_t)(v * 30960.0f));
 }
 
-uint8_t nextWavefoldU8() {
-  static float ph = 0.0f, lfo = 0.0f;
-  float fc = 220.0f, fm = 0.8f;
+int16_t nextWavefoldS16() {
+  static float ph = 0.0f;
+  static CtrlLfo lfo = {{0.0f, 0.0f, 0}, 0.0f, 0.8f};
+  float fc = 220.0f;
   ph += TAU_F * fc / (float)SAMPLE_RATE_HZ;
   if (ph >= TAU_F) ph -= TAU_F;
-  lfo += TAU_F * fm / (float)SAMPLE_RATE_HZ;
-  if (lfo >= TAU_F) lfo -= TAU_F;
-  float gain = 1.5f + 2.0f * (0.5f + 0.5f * sinf(lfo));
+  float gain = 1.5f + 2.0f * (0.5f + 0.5f * ctrlLfoNext(lfo));
   float v = tanhf(gain * sinf(ph));
-  return clampU8((int)(v * 120.0f) + 128);
-}
-
-uint8_t nextBandpassNoiseU8() {
-  static float low = 0.0f, band = 0.0f, lfo = 0.0f;
-  float x = ((float)random(-128, 128)) / 128.0f;
-  lfo += 0.3f / (float)SAMPLE_RATE_HZ;
-  if (lfo >= 1.0f) lfo -= 1.0f;
-  float fc = 200.0f + 1800.0f * (0.5f + 0.5f * sinf(TAU_F * lfo));
-  float f = 2.0f * sinf(3.14159265f * fc / (float)SAMPLE_RATE_HZ);
-  float q = 0.3f;
-  low += f * band;
-  float high = x - low - q * band;
-  band += f * high;
-  float bp = band;
-  if (bp < -1.0f) bp = -1.0f;
-  if (bp > 1.0f) bp = 1.0f;
-  return clampU8((int)(bp * 127.0f) + 128);
-}
-
-uint8_t nextEuclidU8() {
-  static const bool pat[16] = {1,0,0,1,0,0,1,0,1,0,0,1,0,1,0,0};
-  static int idx = 0, toStep = 0;
-  static float env = 0.0f, ph = 0.0f;
-  const int stepSamples = (int)((float)SAMPLE_RATE_HZ / 8.0f);
-  if (--toStep <= 0) {
-    if (pat[idx]) env = 1.0f;
-    idx = (idx + 1) & 15;
-    toStep = stepSamples;
+  return clampS16((int32_t)(v * 30960.0f));
+}
+
+// White noise through an SVF bandpass swept 200-2000 Hz at 0.3 Hz. The centre moves at
+// control rate; between updates the filter runs with fixed coefficients.
+static void renderBandpassNoiseBlock(int16_t* out, int n) {
+  static Svf svf;
+  static bool ready = false;
+  static float lfo = 0.0f;
+  static int ctrlLeft = 0;
+  static uint32_t rng = 0x1F83D9ABu;
+  if (!ready) {
+    svfInit(svf, 200.0f, 3.3f);
+    ready = true;
   }
-  float f = 1000.0f;
-  ph += TAU_F * f / (float)SAMPLE_RATE_HZ;
-  if (ph >= TAU_F) ph -= TAU_F;
-  float v = env * sinf(ph);
-  env *= 0.995f;
-  return clampU8((int)(v * 127.0f) + 128);
-}
-
-uint8_t nextEuclid716U8() {
-  static const bool pat[16] = {1,0,1,0,1,0,1,0,1,0,1,0,1,0,0,0};
-  static int idx = 0, toStep = 0;
-  static float env = 0.0f, ph = 0.0f;
-  const int stepSamples = (int)((float)SAMPLE_RATE_HZ / 8.0f);
-  if (--toStep <= 0) {
-    if (pat[idx]) env = 1.0f;
-    idx = (idx + 1) & 15;
-    toStep = stepSamples;
+  float x[AUDIO_BLOCK_SIZE];
+  while (n > 0) {
+    if (ctrlLeft <= 0) {
+      ctrlLeft = getControlRate();
+      lfo += 0.3f * (float)ctrlLeft / (float)SAMPLE_RATE_HZ;
+      if (lfo >= 1.0f) lfo -= 1.0f;
+      svfSet(svf, 200.0f + 1800.0f * (0.5f + 0.5f * sinf(TAU_F * lfo)), 3.3f);
+    }
+    int run = n < ctrlLeft ? n : ctrlLeft;
+    if (run > AUDIO_BLOCK_SIZE) run = AUDIO_BLOCK_SIZE;
+    for (int i = 0; i < run; ++i) x[i] = (float)(int32_t)noiseRand(rng) * (1.0f / 2147483648.0f);
+    svfProcess(svf, x, run, SvfMode::BAND);
+    for (int i = 0; i < run; ++i) {
+      float bp = x[i];
+      if (bp < -1.0f) bp = -1.0f;
+      if (bp > 1.0f) bp = 1.0f;
+      out[i] = clampS16((int32_t)(bp * 32767.0f));
+    }
+    out += run;
+    n -= run;
+    ctrlLeft -= run;
   }
-  float f = 1600.0f;
-  ph += TAU_F * f / (float)SAMPLE_RATE_HZ;
-  if (ph >= TAU_F) ph -= TAU_F;
-  float v = env * sinf(ph);
-  env *= 0.994f;
-  return clampU8((int)(v * 127.0f) + 128);
-}
-
-uint8_t nextPoly34U8() {
-  static int toA = 0, toB = 0;
-  static float envA = 0.0f, envB = 0.0f, ph = 0.0f;
-  const int stepA = (int)((float)SAMPLE_RATE_HZ / 3.0f);
-  const int stepB = (int)((float)SAMPLE_RATE_HZ / 4.0f);
-  if (--toA <= 0) { envA = 1.0f; toA = stepA; }
-  if (--toB <= 0) { envB = 1.0f; toB = stepB; }
-  float f = 1200.0f;
-  ph += TAU_F * f / (float)SAMPLE_RATE_HZ;
-  if (ph >= TAU_F) ph -= TAU_F;
-  float v = (envA + envB) * 0.5f * sinf(ph);
-  envA *= 0.994f;
-  envB *= 0.994f;
-  return clampU8((int)(v * 127.0f) + 128);
-}
-
-uint8_t nextRingModU8() {
-  static float phc = 0.0f, phm = 0.0f;
-  float fc = 220.0f, fm = 60.0f;
-  phc += TAU_F * fc / (float)SAMPLE_RATE_HZ;
-  if (phc >= TAU_F) phc -= TAU_F;
-  phm += TAU_F * fm / (float)SAMPLE_RATE_HZ;
-  if (phm >= TAU_F) phm -= TAU_F;
+}
+
+int16_t nextBandpassNoiseS16() {
+  int16_t s;
+  renderBandpassNoiseBlock(&s, 1);
+  return s;
+}
+
+int16_t nextRingModS16() {
+  static uint32_t accC = 0, accM = 0;
+  float phc = exactPhaseStep(accC, 220);
+  float phm = exactPhaseStep(accM, 60);
   float v = sinf(phc) * sinf(phm);
-  return clampU8((int)(v * 120.0f) + 128);
-}
-
-uint8_t nextChorusU8() {
-  static float ph1 = 0.0f, ph2 = 0.0f, ph3 = 0.0f;
-  static float l1 = 0.0f, l2 = 1.3f;
-  float base = 220.0f;
-  l1 += 0.002f; if (l1 >= TAU_F) l1 -= TAU_F;
-  l2 += 0.0013f; if (l2 >= TAU_F) l2 -= TAU_F;
-  float f1 = base * (1.0f + 0.004f * sinf(l1));
-  float f2 = base * (1.0f - 0.005f * sinf(l2));
-  float f3 = base;
-  ph1 += TAU_F * f1 / (float)SAMPLE_RATE_HZ; if (ph1 >= TAU_F) ph1 -= TAU_F;
-  ph2 += TAU_F * f2 / (float)SAMPLE_RATE_HZ; if (ph2 >= TAU_F) ph2 -= TAU_F;
-  ph3 += TAU_F * f3 / (float)SAMPLE_RATE_HZ; if (ph3 >= TAU_F) ph3 -= TAU_F;
-  float v = (sinf(ph1) + sinf(ph2) + sinf(ph3)) / 3.0f;
-  return clampU8((int)(v * 120.0f) + 128);
-}
-
-uint8_t nextSampleHoldU8() {
+  return clampS16((int32_t)(v * 30960.0f));
+}
+
+// 220 Hz with its 2nd and 3rd harmonics; the movement is the FxType::CHORUS insert.
+// Integer-Hz partials, so the loop cache plays it after the first cycle.
+static void renderChorusBlock(int16_t* out, int n) {
+  static OscBank bank;
+  static bool ready = false;
+  if (!ready) {
+    oscBankInit(bank, OscWave::SINE, 3);
+    oscBankSetHarmonics(bank, 220.0f, 1, 0.65f);
+    ready = true;
+  }
+  oscBankRenderS16(bank, out, n, 30960.0f);
+}
+
+int16_t nextChorusS16() {
+  int16_t s;
+  renderChorusBlock(&s, 1);
+  return s;
+}
+
+int16_t nextSampleHoldS16() {
   static int hold = 0;
   static float target = 0.0f, current = 0.0f;
   if (--hold <= 0) {
@@ -489,141 +432,482 @@ uint8_t nextSampleHoldU8() {
   current += 0.05f * (target - current);
   if (current < -1.0f) current = -1.0f;
   if (current > 1.0f) current = 1.0f;
-  return clampU8((int)(current * 127.0f) + 128);
-}
-
-uint8_t nextFormantU8() {
-  static float low1=0, band1=0, low2=0, band2=0, low3=0, band3=0;
-  const float fc1 = 700.0f, fc2 = 1200.0f, fc3 = 2400.0f, q = 0.2f;
-  float x = ((float)random(-128, 128)) / 128.0f;
-  auto svf = [q](float in, float fc, float& low, float& band) -> float {
-    float f = 2.0f * sinf(3.14159265f * fc / (float)SAMPLE_RATE_HZ);
-    low += f * band;
-    float high = in - low - q * band;
-    band += f * high;
-    return band;
-  };
-  float y1 = svf(x, fc1, low1, band1);
-  float y2 = svf(x, fc2, low2, band2);
-  float y3 = svf(x, fc3, low3, band3);
-  float v = (y1 * 0.9f + y2 * 0.7f + y3 * 0.5f) * 0.7f;
-  if (v < -1.0f) v = -1.0f;
-  if (v > 1.0f) v = 1.0f;
-  return clampU8((int)(v * 127.0f) + 128);
-}
-
-uint8_t nextSyncU8() {
-  static float phM = 0.0f, phS = 0.0f;
-  float fM = 110.0f, fS = 330.0f;
-  phM += fM / (float)SAMPLE_RATE_HZ;
-  if (phM >= 1.0f) { phM -= 1.0f; phS = 0.0f; }
-  phS += fS / (float)SAMPLE_RATE_HZ;
-  if (phS >= 1.0f) phS -= 1.0f;
-  float v = 2.0f * phS - 1.0f;
-  return clampU8((int)(v * 120.0f) + 128);
-}
-
-uint8_t nextSuperSquareU8() {
-  static float p1=0.0f, p2=0.0f, p3=0.0f, p4=0.0f;
-  float base = 110.0f;
-  float d1 = 0.985f, d2 = 0.997f, d3 = 1.003f, d4 = 1.015f;
-  p1 += (base*d1) / (float)SAMPLE_RATE_HZ; if (p1 >= 1.0f) p1 -= 1.0f;
-  p2 += (base*d2) / (float)SAMPLE_RATE_HZ; if (p2 >= 1.0f) p2 -= 1.0f;
-  p3 += (base*d3) / (float)SAMPLE_RATE_HZ; if (p3 >= 1.0f) p3 -= 1.0f;
-  p4 += (base*d4) / (float)SAMPLE_RATE_HZ; if (p4 >= 1.0f) p4 -= 1.0f;
-  auto sq = [](float ph)->float { return (ph < 0.5f) ? 1.0f : -1.0f; };
-  float v = (sq(p1)+sq(p2)+sq(p3)+sq(p4))/4.0f;
-  return clampU8((int)(v * 110.0f) + 128);
+  return clampS16((int32_t)(current * 32767.0f));
 }
 
-uint8_t nextAudioSample(NoiseType t) {
-  // Handle extra modes first (uses same gain normalization path)
-  if (isExtraType(t)) {
-    uint8_t rawExtra = nextAudioSampleExtra(t);
-    int centeredExtra = (int)rawExtra - 128;
-    float gExtra = getGainForType(t);
-    int scaledExtra = (int)(centeredExtra * gExtra * g_masterGain);
-    return clampU8(scaledExtra + 128);
+// Formant track source: white noise; the vowel filters are the FxType::FORMANT insert
+int16_t nextFormantS16() {
+  return nextWhiteSample();
+}
+
+int16_t nextSyncS16() {
+  // Master 110 Hz hard-syncs a 330 Hz saw; integer accumulators keep the loop exact
+  static uint32_t accM = 0, accS = 0;
+  float v = 2.0f * (float)accS / (float)SAMPLE_RATE_HZ - 1.0f;
+  accS += 330;
+  if (accS >= (uint32_t)SAMPLE_RATE_HZ) accS -= SAMPLE_RATE_HZ;
+  accM += 110;
+  if (accM >= (uint32_t)SAMPLE_RATE_HZ) { accM -= SAMPLE_RATE_HZ; accS = 0; }
+  return clampS16((int32_t)(v * 30960.0f));
+}
+
+static void renderSuperSquareBlock(int16_t* out, int n) {
+  static const int N = 4;
+  static const float det[N] = {0.985f, 0.997f, 1.003f, 1.015f};
+  static OscBank bank;
+  static bool ready = false;
+  if (!ready) {
+    oscBankInit(bank, OscWave::SQUARE, N);
+    for (int i = 0; i < N; ++i) bank.gain[i] = 1.0f / (float)N;
+    oscBankSetRatios(bank, 110.0f, det);
+    ready = true;
   }
-  uint8_t raw = 128;
-  switch (t) {
+  oscBankRenderS16(bank, out, n, 28380.0f);
+}
+
+int16_t nextSuperSquareS16() {
+  int16_t s;
+  renderSuperSquareBlock(&s, 1);
+  return s;
+}
+
+int16_t nextSourceSampleS16(NoiseType t) {
+  int16_t raw = 0;
+  // Handle extra modes first (uses same gain normalization path)
+  if (isExtraType(t)) raw = nextAudioSampleExtra(t);
+  else switch (t) {
     case NoiseType::NOISE_WHITE:       raw = nextWhiteSample();   break;
     case NoiseType::NOISE_PINK:        raw = nextPinkSample();    break;
     case NoiseType::NOISE_BROWN:       raw = nextBrownSample();   break;
     case NoiseType::NOISE_BLUE:        raw = nextBlueSample();    break;
     case NoiseType::NOISE_VIOLET:      raw = nextVioletSample();  break;
+    case NoiseType::NOISE_TILT:        raw = nextNoiseSample(t);  break;
+    case NoiseType::NOISE_SPECTRAL:    renderSpectralNoise(&raw, 1); break;
     case NoiseType::TONE_SINE:
     case NoiseType::TONE_SQUARE:
     case NoiseType::TONE_TRIANGLE:
     case NoiseType::TONE_SAW:
     case NoiseType::TONE_CHIRP:
-    case NoiseType::TONE_FM_BELL:
     case NoiseType::TONE_AM_TREMOLO:   raw = nextToneSample(t);   break;
-    case NoiseType::TONE_KARPLUS:      raw = nextKarplusU8();     break;
-    case NoiseType::TONE_MODAL_DRUM:   raw = nextModalDrumU8();   break;
-    case NoiseType::TONE_GRANULAR:     raw = nextGranularU8();    break;
-    case NoiseType::TONE_SUPERSAW:     raw = nextSuperSawU8();    break;
-    case NoiseType::TONE_PWM:          raw = nextPwmU8();         break;
-    case NoiseType::FX_BITCRUSH:       raw = nextBitcrushU8();    break;
-    case NoiseType::TONE_PHASE_DIST:   raw = nextPhaseDistU8();   break;
-    case NoiseType::TONE_WAVEFOLD:     raw = nextWavefoldU8();    break;
-    case NoiseType::NOISE_BANDPASS:    raw = nextBandpassNoiseU8(); break;
-    case NoiseType::RHYTHM_EUCLIDEAN:  raw = nextEuclidU8();      break;
-    case NoiseType::TONE_SHEPARD:      raw = nextShepardUpU8();   break;
-    case NoiseType::TONE_SHEPARD_DOWN: raw = nextShepardDownU8(); break;
-    case NoiseType::RHYTHM_EUCLIDEAN_7_16: raw = nextEuclid716U8();   break;
-    case NoiseType::RHYTHM_POLY_3_4:       raw = nextPoly34U8();      break;
-    case NoiseType::TONE_RING_MOD:         raw = nextRingModU8();     break;
-    case NoiseType::TONE_CHORUS:           raw = nextChorusU8();      break;
-    case NoiseType::FX_SAMPLE_HOLD:        raw = nextSampleHoldU8();  break;
-    case NoiseType::FX_FORMANT:            raw = nextFormantU8();     break;
-    case NoiseType::TONE_SYNC:             raw = nextSyncU8();        break;
-    case NoiseType::TONE_SUPER_SQUARE:     raw = nextSuperSquareU8(); break;
+    case NoiseType::TONE_FM_BELL:      renderFmTrack(t, &raw, 1); break;
+    case NoiseType::TONE_KARPLUS:      raw = nextKarplusS16();     break;
+    case NoiseType::TONE_MODAL_DRUM:   raw = nextModalDrumS16();   break;
+    case NoiseType::TONE_GRANULAR:     raw = nextGranularS16();    break;
+    case NoiseType::TONE_BYTEBEAT:     renderBytebeat(&raw, 1);    break;
+    case NoiseType::TONE_VOICES:       renderVoices(&raw, 1);      break;
+    case NoiseType::TONE_SUPERSAW:     raw = nextSuperSawS16();    break;
+    case NoiseType::TONE_PWM:          raw = nextPwmS16();         break;
+    case NoiseType::FX_BITCRUSH:       raw = nextBitcrushS16();    break;
+    case NoiseType::TONE_PHASE_DIST:   raw = nextPhaseDistS16();   break;
+    case NoiseType::TONE_WAVEFOLD:     raw = nextWavefoldS16();    break;
+    case NoiseType::NOISE_BANDPASS:    raw = nextBandpassNoiseS16(); break;
+    case NoiseType::RHYTHM_EUCLIDEAN:  renderSequencer(&raw, 1);  break;
+    case NoiseType::TONE_SHEPARD:      raw = nextShepardUpS16();   break;
+    case NoiseType::TONE_SHEPARD_DOWN: raw = nextShepardDownS16(); break;
+    case NoiseType::RHYTHM_EUCLIDEAN_7_16:
+    case NoiseType::RHYTHM_POLY_3_4:       renderSequencer(&raw, 1);   break;
+    case NoiseType::TONE_RING_MOD:         raw = nextRingModS16();     break;
+    case NoiseType::TONE_CHORUS:           raw = nextChorusS16();      break;
+    case NoiseType::FX_SAMPLE_HOLD:        raw = nextSampleHoldS16();  break;
+    case NoiseType::FX_FORMANT:            raw = nextFormantS16();     break;
+    case NoiseType::TONE_SYNC:             raw = nextSyncS16();        break;
+    case NoiseType::TONE_SUPER_SQUARE:     raw = nextSuperSquareS16(); break;
     default: break;
   }
-  int centered = (int)raw - 128;
-  float g = getGainForType(t);
-  int scaled = (int)(centered * g * g_masterGain);
-  return clampU8(scaled + 128);
+  return raw;
+}
+
+uint8_t nextAudioSample(NoiseType t) {
+  int16_t s;
+  renderAudioBlock(t, &s, 1);
+  return masterOutputU8(s);
+}
+
+// Per-type loudness normalization stays at 16-bit; master gain and the
+// single requantization to 8 bits happen in the master bus / output stage.
+static void applyTypeGain(NoiseType t, int16_t* buf, int n) {
+  const int32_t gq = (int32_t)(getGainForType(t) * 32768.0f);
+  for (int i = 0; i < n; ++i) buf[i] = clampS16((buf[i] * gq) >> 15);
+}
+
+// Mirror the reverb.* registry entries onto the shared reverb send
+static void syncReverbSendFromParams() {
+  ReverbParams p = REVERB_ROOM;
+  p.size = paramValue(ParamId::REVERB_SIZE);
+  p.decay = paramValue(ParamId::REVERB_DECAY);
+  p.mix = paramValue(ParamId::REVERB_MIX);
+  setReverbSendParams(p);
+  setReverbSend(paramValue(ParamId::REVERB_SEND) >= 0.5f);
+}
+
+// Strictly periodic tracks replay a cached cycle instead of synthesising
+static bool g_loopCached = false;
+
+// Called from the audio task at the first block of a newly selected track.
+// All per-track DSP memory is returned to the arena and only what t needs is taken again.
+static void onTrackSelected(NoiseType t) {
+  releaseLoopCache();
+  releaseFxChain();
+  releaseReverb();
+  releaseStringBank();
+  releaseLuts();
+  releaseSpectralNoise();
+  releaseGranular();
+  releaseBytebeat();
+  releaseVoices();
+  arenaReset();
+
+  prepareLutsForType(t);
+  if (t == NoiseType::TONE_KARPLUS) {
+    attachStringBank();
+    setPluckPattern(kKarplusPattern, (int)(sizeof(kKarplusPattern) / sizeof(kKarplusPattern[0])), KARPLUS_STEP_SAMPLES);
+  }
+  if (t == NoiseType::NOISE_SPECTRAL) attachSpectralNoise();
+  if (t == NoiseType::TONE_GRANULAR) attachGranular();
+  if (t == NoiseType::TONE_BYTEBEAT) attachBytebeat();
+  if (t == NoiseType::TONE_VOICES) attachVoices();
+  seqLoadForType(t);
+  g_loopCached = prepareLoopCache(t);
+  setFxChainForType(t);
+  if (t == NoiseType::FX_GATED_REVERB || g_reverbSend) attachReverb();
+  clearReverb();
+  setReverbParams(t == NoiseType::FX_GATED_REVERB ? REVERB_GATED : g_reverbSendParams);
+  g_reverbSendParamsDirty = false;
+}
+
+void renderAudioBlock(NoiseType t, int16_t* out, int n) {
+  static bool first = true;
+  static NoiseType lastType = NoiseType::NOISE_WHITE;
+  if (first || t != lastType) {
+    onTrackSelected(t);
+    lastType = t;
+    first = false;
+  }
+
+  // Cached loops and block-native engines render the whole block at once;
+  // everything else falls back to the per-sample generators.
+  if (g_loopCached) {
+    renderLoopCache(out, n);
+  } else if (isNoiseColorType(t)) {
+    renderNoiseBlock(t, out, n);
+  } else switch (t) {
+    case NoiseType::TONE_KARPLUS:
+      renderStringBank(out, n);
+      break;
+    case NoiseType::NOISE_SPECTRAL:
+      renderSpectralNoise(out, n);
+      break;
+    case NoiseType::RHYTHM_EUCLIDEAN:
+    case NoiseType::RHYTHM_EUCLIDEAN_7_16:
+    case NoiseType::RHYTHM_POLY_3_4:
+      renderSequencer(out, n);
+      break;
+    case NoiseType::TONE_MODAL_DRUM:
+      renderModalTrack(out, n);
+      break;
+    case NoiseType::TONE_FM_BELL:
+    case NoiseType::TONE_FM_METAL:
+      renderFmTrack(t, out, n);
+      break;
+    case NoiseType::TONE_GRANULAR:
+      renderGranular(out, n);
+      break;
+    case NoiseType::TONE_BYTEBEAT:
+      renderBytebeat(out, n);
+      break;
+    case NoiseType::TONE_VOICES:
+      renderVoices(out, n);
+      break;
+    case NoiseType::NOISE_BANDPASS:
+      renderBandpassNoiseBlock(out, n);
+      break;
+    case NoiseType::TONE_SUPERSAW:
+      renderSuperSawBlock(out, n);
+      break;
+    case NoiseType::TONE_SUPER_SQUARE:
+      renderSuperSquareBlock(out, n);
+      break;
+    case NoiseType::TONE_CHORUS:
+      renderChorusBlock(out, n);
+      break;
+    default:
+      for (int i = 0; i < n; ++i) out[i] = nextSourceSampleS16(t);
+      break;
+  }
+  processFxChain(out, n);
+  applyTypeGain(t, out, n);
+
+  bool gated = (t == NoiseType::FX_GATED_REVERB);
+  if (gated || g_reverbSend) {
+    attachReverb();  // the send may have been switched on mid-track
+    if (!gated && g_reverbSendParamsDirty) {
+      setReverbParams(g_reverbSendParams);
+      g_reverbSendParamsDirty = false;
+    }
+    uint32_t c0 = cycleNow();
+    processReverb(out, n);
+    cycleStatAdd(g_profReverb, cycleNow() - c0, n);
+  }
+}
+
+void setReverbSend(bool on) {
+  if (on && !g_reverbSend) clearReverb();
+  g_reverbSend = on;
+}
+
+bool getReverbSend() {
+  return g_reverbSend;
+}
+
+void setReverbSendParams(const ReverbParams& p) {
+  g_reverbSendParams = p;
+  g_reverbSendParamsDirty = true;
+}
+
+// Render one block through synthesis, the master bus and the 8-bit output stage.
+// Runs on whichever task owns rendering (renderTask with the pipeline on, audioTask otherwise).
+static void renderOutputBlock(uint8_t* out) {
+  static int16_t block[AUDIO_BLOCK_SIZE];
+  uint32_t c0 = cycleNow();
+  if (applyPendingParams()) syncReverbSendFromParams();
+  renderAudioBlock((NoiseType)g_audioNoise, block, AUDIO_BLOCK_SIZE);
+  sampleClockBlockRendered(AUDIO_BLOCK_SIZE);
+  uint32_t c1 = cycleNow();
+  processMasterBus(block, AUDIO_BLOCK_SIZE);
+  uint32_t c2 = cycleNow();
+  for (int i = 0; i < AUDIO_BLOCK_SIZE; ++i) out[i] = masterOutputU8(block[i]);
+  uint32_t c3 = cycleNow();
+  cycleStatAdd(g_profSynth, c1 - c0, AUDIO_BLOCK_SIZE);
+  cycleStatAdd(g_profBus, c2 - c1, AUDIO_BLOCK_SIZE);
+  cycleStatAdd(g_profOutput, c3 - c2, AUDIO_BLOCK_SIZE);
+}
+
+static inline uint32_t fifoFill() {
+  return g_fifoHead.load(std::memory_order_acquire) - g_fifoTail.load(std::memory_order_relaxed);
+}
+
+// Pace one sample to the DAC against an absolute deadline so rendering time does not stretch the period
+static inline void outputSample(uint8_t s, uint32_t& nextUs) {
+  const uint32_t samplePeriodUs = 1000000UL / SAMPLE_RATE_HZ;
+  g_visRing[(g_visWriteIdx + 1) & VIS_RING_MASK] = s;
+  g_visWriteIdx = (g_visWriteIdx + 1) & VIS_RING_MASK;
+  while ((int32_t)(micros() - nextUs) < 0) { }
+  dacWrite(AUDIO_DAC_PIN, s);
+  noteFirstSample();
+  nextUs += samplePeriodUs;
+}
+
+// DAC1 data field written straight to the pad register. dac_output_voltage() lives in flash
+// and would fault in the ISR while the flash cache is off (SPIFFS access); the pad itself is
+// powered by dac_output_enable() before playback starts.
+static inline __attribute__((always_inline)) void dacWriteFromIsr(uint8_t s) {
+  SET_PERI_REG_BITS(RTC_IO_PAD_DAC1_REG, RTC_IO_PDAC1_DAC, s, RTC_IO_PDAC1_DAC_S);
+}
+
+// Sample-rate timer ISR (pipeline mode): drains the FIFO to the DAC and wakes renderTask
+// each time a block has been consumed, so neither task needs to poll or spin.
+// Everything it calls is in IRAM or force-inlined.
+static void IRAM_ATTR onSampleTimer() {
+  uint32_t c0 = cycleNow();
+  uint32_t tail = g_fifoTail.load(std::memory_order_relaxed);
+  uint8_t s;
+  if (g_fifoHead.load(std::memory_order_acquire) != tail) {
+    s = g_fifo[tail & (AUDIO_FIFO_BLOCKS - 1)][g_isrPos];
+    g_isrLast = s;
+    if (++g_isrPos >= AUDIO_BLOCK_SIZE) {
+      g_isrPos = 0;
+      g_fifoTail.store(tail + 1, std::memory_order_release);
+      sampleClockAdvance(AUDIO_BLOCK_SIZE);
+      BaseType_t woken = pdFALSE;
+      vTaskNotifyGiveFromISR(g_renderTaskHandle, &woken);
+      if (woken) portYIELD_FROM_ISR();
+    }
+  } else {
+    // Underrun: hold the last value
+    s = g_isrLast;
+    g_underruns++;
+  }
+  dacWriteFromIsr(s);
+  noteFirstSample();
+  g_visRing[(g_visWriteIdx + 1) & VIS_RING_MASK] = s;
+  g_visWriteIdx = (g_visWriteIdx + 1) & VIS_RING_MASK;
+  cpuLoadAdd(LoadSource::ISR, cycleNow() - c0);
 }
 
 void audioTask(void* param) {
+  (void)param;
+  static uint8_t direct[AUDIO_BLOCK_SIZE];
   const uint32_t samplePeriodUs = 1000000UL / SAMPLE_RATE_HZ;
+  g_audioTaskHandle = xTaskGetCurrentTaskHandle();
+
+  // Sample clock: APB (80 MHz) / SAMPLE_TIMER_DIVIDER, attached on this core.
+  // Stays exact when the CPU is scaled down, since APB is fixed at >= 80 MHz.
+  const uint32_t timerHz = 80000000UL / SAMPLE_TIMER_DIVIDER;
+  g_sampleTimer = timerBegin(0, SAMPLE_TIMER_DIVIDER, true);
+  timerAttachInterrupt(g_sampleTimer, &onSampleTimer, false);  // level: ESP32 timers have no reliable edge mode
+  timerAlarmWrite(g_sampleTimer, (timerHz + SAMPLE_RATE_HZ / 2) / SAMPLE_RATE_HZ, true);
+
+  uint32_t nextUs = micros();
   while (true) {
-    if (g_audioRunning) {
-      for (int i = 0; i < 256; ++i) {
-        uint8_t s = nextAudioSample((NoiseType)g_audioNoise);
-        g_visRing[(g_visWriteIdx + 1) & VIS_RING_MASK] = s;
-        g_visWriteIdx = (g_visWriteIdx + 1) & VIS_RING_MASK;
-        dacWrite(AUDIO_DAC_PIN, s);
-        delayMicroseconds(samplePeriodUs);
-      }
+    if (!g_audioRunning) {
+      // Paused: apply a pending mode switch, then sleep until setAudioRunning/setAudioPipeline
+      sampleClockStop();
+      g_pipelineActive = g_pipelineRequested;
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      nextUs = micros();
+      continue;
+    }
+
+    if (!g_pipelineActive) {
+      // Single-task mode: render and busy-wait the DAC deadlines on this core
+      uint32_t c0 = cycleNow();
+      sampleClockSyncRender();
+      renderOutputBlock(direct);
+      for (int i = 0; i < AUDIO_BLOCK_SIZE; ++i) outputSample(direct[i], nextUs);
+      sampleClockAdvance(AUDIO_BLOCK_SIZE);
+      // After a stall (e.g. resume from pause) restart the schedule instead of bursting to catch up
+      if ((int32_t)(micros() - nextUs) > (int32_t)(samplePeriodUs * AUDIO_BLOCK_SIZE)) nextUs = micros();
+      cpuLoadAdd(LoadSource::AUDIO, cycleNow() - c0);
+      continue;
+    }
+
+    // Pipeline: drop blocks rendered before the pause, let the worker fill the render-ahead,
+    // then hand the DAC to the timer ISR and sleep until paused.
+    g_fifoTail.store(g_fifoHead.load(std::memory_order_acquire), std::memory_order_release);
+    g_isrPos = 0;
+    sampleClockSyncRender();
+    xTaskNotifyGive(g_renderTaskHandle);
+    while (g_audioRunning && fifoFill() < (uint32_t)g_renderAhead) vTaskDelay(1);
+    timerAlarmEnable(g_sampleTimer);
+    while (g_audioRunning) ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    timerAlarmDisable(g_sampleTimer);
+  }
+}
+
+void renderTask(void* param) {
+  (void)param;
+  g_renderTaskHandle = xTaskGetCurrentTaskHandle();
+  while (true) {
+    if (g_audioRunning && g_pipelineActive && fifoFill() < (uint32_t)g_renderAhead) {
+      uint32_t c0 = cycleNow();
+      uint32_t head = g_fifoHead.load(std::memory_order_relaxed);
+      renderOutputBlock(g_fifo[head & (AUDIO_FIFO_BLOCKS - 1)]);
+      g_fifoHead.store(head + 1, std::memory_order_release);
+      cpuLoadAdd(LoadSource::RENDER, cycleNow() - c0);
     } else {
-      vTaskDelay(pdMS_TO_TICKS(10));
+      // Woken by the sample ISR whenever a block is consumed, or by audioTask on start
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
     }
   }
 }
 
+void setAudioPipeline(bool on) {
+  g_pipelineRequested = on;
+  if (g_audioTaskHandle) xTaskNotifyGive(g_audioTaskHandle);
+}
+
+bool getAudioPipeline() {
+  return g_pipelineActive;
+}
+
+void setRenderAhead(int blocks) {
+  if (blocks < 1) blocks = 1;
+  if (blocks > AUDIO_FIFO_BLOCKS - 1) blocks = AUDIO_FIFO_BLOCKS - 1;
+  g_renderAhead = blocks;
+}
+
+int getRenderAhead() {
+  return g_renderAhead;
+}
+
+uint32_t getFifoFill() {
+  return fifoFill();
+}
+
+uint32_t getUnderrunCount() {
+  return g_underruns;
+}
+
 void initAudioState() {
   g_audioNoise = NoiseType::NOISE_WHITE;
   g_audioRunning = false;
-  g_masterGain = 1.0f;
+  cycleStatReset(g_profSynth);
+  cycleStatReset(g_profBus);
+  cycleStatReset(g_profReverb);
+  cycleStatReset(g_profOutput);
+  initAudioMaster();
+  initParams();
+  initFxChain();
+  initReverb();
+  initStringBank();
 }
 
 void setAudioRunning(bool running) {
   g_audioRunning = running;
+  if (g_audioTaskHandle) xTaskNotifyGive(g_audioTaskHandle);
 }
 
 void setAudioNoiseType(NoiseType type) {
   g_audioNoise = type;
 }
 
-void setMasterGain(float g) {
-  if (g < 0.0f) g = 0.0f;
-  if (g > 1.0f) g = 1.0f;
-  g_masterGain = g;
-}
-
-float getMasterGain() {
-  return g_masterGain;
+void printAudioProfile() {
+  float synth = cycleStatPerSample(g_profSynth);
+  float bus = cycleStatPerSample(g_profBus);
+  float out = cycleStatPerSample(g_profOutput);
+  const float budget = (float)ESP.getCpuFreqMHz() * 1000000.0f / (float)SAMPLE_RATE_HZ;
+  Serial.printf("Audio cycles/sample: synth %.0f, bus %.0f (%.0f/block, peak %u), output %.0f (%s), budget %.0f, limiter min gain %.2f\n",
+    synth, bus, bus * AUDIO_BLOCK_SIZE, (unsigned)g_profBus.peak, out,
+    getDitherModeName(getDitherMode()), budget, takeLimiterMinGain());
+  if (g_pipelineActive) {
+    Serial.printf("Pipeline: render-ahead %d blocks (%.1f ms), fill %u, underruns %u samples\n",
+      (int)g_renderAhead, 1000.0f * g_renderAhead * AUDIO_BLOCK_SIZE / (float)SAMPLE_RATE_HZ,
+      (unsigned)fifoFill(), (unsigned)g_underruns);
+  }
+  Serial.printf("DSP arena: %u bytes in use, peak %u of %u\n",
+    (unsigned)getArenaUsed(), (unsigned)getArenaPeak(), (unsigned)DSP_ARENA_BYTES);
+  if (getLutBytes()) {
+    Serial.printf("Tables: %u bytes, built in %u us\n", (unsigned)getLutBytes(), (unsigned)getLutBuildUs());
+  }
+  if (getLoopCachePeriod()) {
+    Serial.printf("Loop cache: %d-sample period (%u bytes)\n", getLoopCachePeriod(),
+      (unsigned)(getLoopCachePeriod() * sizeof(int16_t)));
+  }
+  if (g_profReverb.samples) {
+    Serial.printf("Reverb: %.0f cycles/sample, %u bytes\n",
+      cycleStatPerSample(g_profReverb), (unsigned)getReverbMemoryBytes());
+  }
+  cycleStatReset(g_profSynth);
+  cycleStatReset(g_profBus);
+  cycleStatReset(g_profReverb);
+  cycleStatReset(g_profOutput);
+}
+
+void benchControlRate() {
+  // Tracks with control-rate modulators. Chorus Sines, Phaser/Flanger and Doppler replay the
+  // loop cache into block-rate inserts, so K does not change their cost.
+  static const NoiseType kTypes[] = {
+    NoiseType::TONE_PWM, NoiseType::TONE_PHASE_DIST, NoiseType::TONE_WAVEFOLD,
+    NoiseType::NOISE_BANDPASS, NoiseType::TONE_FEEDBACK_HOWL
+  };
+  static int16_t block[AUDIO_BLOCK_SIZE];
+  const int BLOCKS = 64;
+  const int samples = BLOCKS * AUDIO_BLOCK_SIZE;
+  const int k = getControlRate();
+  Serial.printf("Control-rate bench: K = 1 vs K = %d, %d samples each\n", k, samples);
+  for (size_t i = 0; i < sizeof(kTypes) / sizeof(kTypes[0]); ++i) {
+    uint32_t cycles[2];
+    for (int pass = 0; pass < 2; ++pass) {
+      setControlRate(pass == 0 ? 1 : k);
+      renderAudioBlock(kTypes[i], block, AUDIO_BLOCK_SIZE);  // select track, warm up
+      uint32_t c0 = cycleNow();
+      for (int b = 0; b < BLOCKS; ++b) renderAudioBlock(kTypes[i], block, AUDIO_BLOCK_SIZE);
+      cycles[pass] = cycleNow() - c0;
+    }
+    float perSample = (float)cycles[0] / (float)samples;
+    float perSampleK = (float)cycles[1] / (float)samples;
+    Serial.printf("  %-24s %6.0f -> %6.0f cycles/sample (%.0f%% saved)\n", getNoiseTypeName(kTypes[i]),
+      perSample, perSampleK, 100.0f * (1.0f - perSampleK / perSample));
+  }
+  setControlRate(k);
 }
@@ -0,0 +1,46 @@
+#include "boot_profile.h"
+#include <Arduino.h>
+#include "esp_timer.h"
+
+static const int BOOT_MARKS_MAX = 12;
+static const char* g_markName[BOOT_MARKS_MAX];
+static int64_t g_markUs[BOOT_MARKS_MAX];
+static int g_markCount = 0;
+
+static volatile bool g_firstSampleSeen = false;
+static volatile int64_t g_firstSampleUs = 0;
+static int64_t g_playRequestUs = 0;
+static bool g_firstSampleReported = false;
+
+void bootMark(const char* phase) {
+  if (g_markCount >= BOOT_MARKS_MAX) return;
+  g_markName[g_markCount] = phase;
+  g_markUs[g_markCount] = esp_timer_get_time();
+  g_markCount++;
+}
+
+void printBootProfile() {
+  Serial.println("Boot profile (ms since app start, phase duration):");
+  int64_t prev = 0;
+  for (int i = 0; i < g_markCount; ++i) {
+    Serial.printf("  %7.2f  +%6.2f  %s\n", g_markUs[i] / 1000.0f, (g_markUs[i] - prev) / 1000.0f, g_markName[i]);
+    prev = g_markUs[i];
+  }
+}
+
+void notePlayRequested() {
+  if (g_playRequestUs == 0) g_playRequestUs = esp_timer_get_time();
+}
+
+void IRAM_ATTR noteFirstSample() {
+  if (g_firstSampleSeen) return;
+  g_firstSampleUs = esp_timer_get_time();
+  g_firstSampleSeen = true;
+}
+
+void reportFirstSample() {
+  if (g_firstSampleReported || !g_firstSampleSeen) return;
+  g_firstSampleReported = true;
+  Serial.printf("First sample: %.1f ms after app start, %.1f ms after play\n",
+    g_firstSampleUs / 1000.0f, (g_firstSampleUs - g_playRequestUs) / 1000.0f);
+}
@@ -0,0 +1,573 @@
+#include "bytebeat.h"
+#include "config.h"
+#include "dsp_arena.h"
+#include "params.h"
+#include "profiling.h"
+#include <Arduino.h>
+#include <SPIFFS.h>
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* const kPresets[] = {
+  "t*(t>>5|t>>8)",
+  "(t*5&t>>7)|(t*3&t>>10)",
+  "t*(((t>>12)|(t>>8))&(63&(t>>4)))",
+  "(t>>6|t|t>>(t>>16))*10+((t>>11)&7)",
+  "t*((t>>9|t>>13)&25&t>>6)",
+};
+static const int PRESET_COUNT = (int)(sizeof(kPresets) / sizeof(kPresets[0]));
+
+/* =========================
+   Bytecode
+   ========================= */
+
+// Binary operators: name, C expression of x (left) and y (right). Each has a stack form
+// and a K form whose right operand is the instruction's constant.
+#define BB_BINARY_OPS(X)                 \
+  X(ADD,  x + y)                         \
+  X(SUB,  x - y)                         \
+  X(MUL,  x * y)                         \
+  X(DIV,  y ? x / y : 0u)                \
+  X(MOD,  y ? x % y : 0u)                \
+  X(AND,  x & y)                         \
+  X(OR,   x | y)                         \
+  X(XOR,  x ^ y)                         \
+  X(SHL,  x << (y & 31u))                \
+  X(SHR,  x >> (y & 31u))                \
+  X(LT,   (uint32_t)(x < y))             \
+  X(GT,   (uint32_t)(x > y))             \
+  X(LE,   (uint32_t)(x <= y))            \
+  X(GE,   (uint32_t)(x >= y))            \
+  X(EQ,   (uint32_t)(x == y))            \
+  X(NE,   (uint32_t)(x != y))            \
+  X(LAND, (uint32_t)(x && y))            \
+  X(LOR,  (uint32_t)(x || y))
+
+enum BbOpCode : uint8_t {
+  BB_T = 0,     // push t
+  BB_CONST,     // push k
+  BB_NEG,
+  BB_NOT,
+  BB_LNOT,
+  BB_SELECT,    // c ? a : b
+#define BB_ENUM(name, expr) BB_##name,
+  BB_BINARY_OPS(BB_ENUM)
+#undef BB_ENUM
+#define BB_ENUM(name, expr) BB_##name##_K,
+  BB_BINARY_OPS(BB_ENUM)
+#undef BB_ENUM
+  BB_OP_COUNT
+};
+
+static const uint8_t BB_FIRST_BINARY = BB_ADD;
+static const uint8_t BB_K_OFFSET = BB_ADD_K - BB_ADD;
+
+static const char* const kOpNames[BB_OP_COUNT] = {
+  "T", "CONST", "NEG", "NOT", "LNOT", "SELECT",
+#define BB_NAME(name, expr) #name,
+  BB_BINARY_OPS(BB_NAME)
+  BB_BINARY_OPS(BB_NAME)
+#undef BB_NAME
+};
+
+struct BbOp {
+  uint8_t code;
+  uint32_t k;
+};
+
+struct BytebeatProgram {
+  BbOp ops[BYTEBEAT_MAX_OPS];
+  int count;
+  int depth;                        // stack entries needed
+  char text[BYTEBEAT_TEXT_MAX];
+};
+
+static uint32_t applyBinary(uint8_t code, uint32_t x, uint32_t y) {
+  switch (code) {
+#define BB_CASE(name, expr) case BB_##name: return expr;
+    BB_BINARY_OPS(BB_CASE)
+#undef BB_CASE
+    default: return 0;
+  }
+}
+
+static bool isCommutative(uint8_t code) {
+  switch (code) {
+    case BB_ADD: case BB_MUL: case BB_AND: case BB_OR: case BB_XOR:
+    case BB_EQ: case BB_NE: case BB_LAND: case BB_LOR:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Run the program over n samples (n <= AUDIO_BLOCK_SIZE). The stack holds one block-wide
+// row per entry; returns the result row.
+static const uint32_t* runProgram(const BytebeatProgram& p, const uint32_t* tv, uint32_t* stack, int n) {
+  const int W = AUDIO_BLOCK_SIZE;
+  uint32_t* top = nullptr;
+  for (int pc = 0; pc < p.count; ++pc) {
+    const uint32_t k = p.ops[pc].k;
+    switch (p.ops[pc].code) {
+      case BB_T:
+        top = top ? top + W : stack;
+        for (int i = 0; i < n; ++i) top[i] = tv[i];
+        break;
+      case BB_CONST:
+        top = top ? top + W : stack;
+        for (int i = 0; i < n; ++i) top[i] = k;
+        break;
+      case BB_NEG:
+        for (int i = 0; i < n; ++i) top[i] = 0u - top[i];
+        break;
+      case BB_NOT:
+        for (int i = 0; i < n; ++i) top[i] = ~top[i];
+        break;
+      case BB_LNOT:
+        for (int i = 0; i < n; ++i) top[i] = (uint32_t)(top[i] == 0u);
+        break;
+      case BB_SELECT: {
+        uint32_t* c = top - 2 * W;
+        const uint32_t* a = top - W;
+        for (int i = 0; i < n; ++i) c[i] = c[i] ? a[i] : top[i];
+        top = c;
+        break;
+      }
+#define BB_CASE(name, expr)                                                   \
+      case BB_##name: {                                                       \
+        uint32_t* l = top - W;                                                \
+        for (int i = 0; i < n; ++i) { const uint32_t x = l[i], y = top[i]; l[i] = expr; } \
+        top = l;                                                              \
+        break;                                                                \
+      }                                                                       \
+      case BB_##name##_K:                                                     \
+        for (int i = 0; i < n; ++i) { const uint32_t x = top[i], y = k; top[i] = expr; } \
+        break;
+      BB_BINARY_OPS(BB_CASE)
+#undef BB_CASE
+      default:
+        break;
+    }
+  }
+  return top;
+}
+
+/* =========================
+   Compiler (recursive descent, C precedence)
+   ========================= */
+
+struct Compiler {
+  const char* s;
+  int pos;
+  BytebeatProgram* p;
+  char* err;
+  int errLen;
+  bool ok;
+  int nesting;  // open parentheses, unary operators and ?: around the cursor
+};
+
+static void fail(Compiler& c, const char* what) {
+  if (!c.ok) return;  // keep the first error
+  c.ok = false;
+  if (c.err && c.errLen > 0) {
+    if (c.s[c.pos]) snprintf(c.err, c.errLen, "%s at %d ('%c')", what, c.pos + 1, c.s[c.pos]);
+    else snprintf(c.err, c.errLen, "%s at end", what);
+  }
+}
+
+static bool enterNesting(Compiler& c) {
+  if (c.nesting >= BYTEBEAT_NESTING) {
+    fail(c, "nested too deep");
+    return false;
+  }
+  c.nesting++;
+  return true;
+}
+
+static void skipSpace(Compiler& c) {
+  while (c.s[c.pos] == ' ' || c.s[c.pos] == '\t') c.pos++;
+}
+
+static void emit(Compiler& c, uint8_t code, uint32_t k) {
+  if (c.p->count >= BYTEBEAT_MAX_OPS) {
+    fail(c, "formula too long");
+    return;
+  }
+  c.p->ops[c.p->count].code = code;
+  c.p->ops[c.p->count].k = k;
+  c.p->count++;
+}
+
+static bool isConstAt(const Compiler& c, int i) {
+  return c.p->ops[i].code == BB_CONST;
+}
+
+// The operands' code starts at leftStart and rightStart. Two constants fold; a constant
+// right operand (or left, for commutative operators) becomes the K form.
+static void emitBinary(Compiler& c, uint8_t code, int leftStart, int rightStart) {
+  BytebeatProgram& p = *c.p;
+  const bool leftConst = rightStart - leftStart == 1 && isConstAt(c, leftStart);
+  const bool rightConst = p.count - rightStart == 1 && isConstAt(c, rightStart);
+  if (leftConst && rightConst) {
+    p.ops[leftStart].k = applyBinary(code, p.ops[leftStart].k, p.ops[rightStart].k);
+    p.count = leftStart + 1;
+  } else if (rightConst) {
+    const uint32_t k = p.ops[rightStart].k;
+    p.count--;
+    emit(c, code + BB_K_OFFSET, k);
+  } else if (leftConst && isCommutative(code)) {
+    const uint32_t k = p.ops[leftStart].k;
+    memmove(&p.ops[leftStart], &p.ops[rightStart], (size_t)(p.count - rightStart) * sizeof(BbOp));
+    p.count--;
+    emit(c, code + BB_K_OFFSET, k);
+  } else {
+    emit(c, code, 0);
+  }
+}
+
+// Binary operator at the cursor: opcode, precedence (higher binds tighter) and length
+static bool peekBinary(Compiler& c, uint8_t* code, int* prec, int* len) {
+  const char a = c.s[c.pos], b = c.s[c.pos + 1];
+  struct Two { char a, b; uint8_t code; int prec; };
+  static const Two kTwo[] = {
+    {'|', '|', BB_LOR, 1}, {'&', '&', BB_LAND, 2}, {'=', '=', BB_EQ, 6}, {'!', '=', BB_NE, 6},
+    {'<', '=', BB_LE, 7}, {'>', '=', BB_GE, 7}, {'<', '<', BB_SHL, 8}, {'>', '>', BB_SHR, 8},
+  };
+  for (const Two& t : kTwo) {
+    if (a == t.a && b == t.b) {
+      *code = t.code;
+      *prec = t.prec;
+      *len = 2;
+      return true;
+    }
+  }
+  *len = 1;
+  switch (a) {
+    case '|': *code = BB_OR;  *prec = 3;  return true;
+    case '^': *code = BB_XOR; *prec = 4;  return true;
+    case '&': *code = BB_AND; *prec = 5;  return true;
+    case '<': *code = BB_LT;  *prec = 7;  return true;
+    case '>': *code = BB_GT;  *prec = 7;  return true;
+    case '+': *code = BB_ADD; *prec = 9;  return true;
+    case '-': *code = BB_SUB; *prec = 9;  return true;
+    case '*': *code = BB_MUL; *prec = 10; return true;
+    case '/': *code = BB_DIV; *prec = 10; return true;
+    case '%': *code = BB_MOD; *prec = 10; return true;
+    default:  return false;
+  }
+}
+
+static void parseExpr(Compiler& c);
+
+static void parseUnary(Compiler& c) {
+  skipSpace(c);
+  const char ch = c.s[c.pos];
+  if (ch == '-' || ch == '~' || ch == '!' || ch == '+') {
+    c.pos++;
+    const int start = c.p->count;
+    if (!enterNesting(c)) return;
+    parseUnary(c);
+    c.nesting--;
+    if (!c.ok || ch == '+') return;
+    const uint8_t code = ch == '-' ? BB_NEG : ch == '~' ? BB_NOT : BB_LNOT;
+    if (c.p->count - start == 1 && isConstAt(c, start)) {
+      uint32_t& k = c.p->ops[start].k;
+      k = code == BB_NEG ? 0u - k : code == BB_NOT ? ~k : (uint32_t)(k == 0u);
+    } else {
+      emit(c, code, 0);
+    }
+    return;
+  }
+  if (ch == '(') {
+    c.pos++;
+    if (!enterNesting(c)) return;
+    parseExpr(c);
+    c.nesting--;
+    skipSpace(c);
+    if (c.s[c.pos] != ')') {
+      fail(c, "expected ')'");
+      return;
+    }
+    c.pos++;
+    return;
+  }
+  if (ch == 't') {
+    c.pos++;
+    emit(c, BB_T, 0);
+    return;
+  }
+  if (ch >= '0' && ch <= '9') {
+    char* end;
+    const bool hex = ch == '0' && (c.s[c.pos + 1] == 'x' || c.s[c.pos + 1] == 'X');
+    const uint32_t k = (uint32_t)strtoul(c.s + c.pos, &end, hex ? 16 : 10);
+    c.pos = (int)(end - c.s);
+    emit(c, BB_CONST, k);
+    return;
+  }
+  fail(c, "expected t, a number or '('");
+}
+
+static void parseBinary(Compiler& c, int minPrec) {
+  const int leftStart = c.p->count;
+  parseUnary(c);
+  while (c.ok) {
+    skipSpace(c);
+    uint8_t code;
+    int prec, len;
+    if (!peekBinary(c, &code, &prec, &len) || prec < minPrec) return;
+    c.pos += len;
+    const int rightStart = c.p->count;
+    parseBinary(c, prec + 1);
+    if (c.ok) emitBinary(c, code, leftStart, rightStart);
+  }
+}
+
+static void parseExpr(Compiler& c) {
+  const int condStart = c.p->count;
+  parseBinary(c, 1);
+  skipSpace(c);
+  if (!c.ok || c.s[c.pos] != '?') return;
+  c.pos++;
+  const int thenStart = c.p->count;
+  if (!enterNesting(c)) return;
+  parseExpr(c);
+  skipSpace(c);
+  if (c.s[c.pos] != ':') {
+    fail(c, "expected ':'");
+    return;
+  }
+  c.pos++;
+  const int elseStart = c.p->count;
+  parseExpr(c);
+  c.nesting--;
+  if (!c.ok) return;
+  BytebeatProgram& p = *c.p;
+  if (thenStart - condStart == 1 && isConstAt(c, condStart)) {
+    // Constant condition: keep the chosen branch only
+    const int from = p.ops[condStart].k ? thenStart : elseStart;
+    const int len = p.ops[condStart].k ? elseStart - thenStart : p.count - elseStart;
+    memmove(&p.ops[condStart], &p.ops[from], (size_t)len * sizeof(BbOp));
+    p.count = condStart + len;
+  } else {
+    emit(c, BB_SELECT, 0);
+  }
+}
+
+// Stack entries the program needs, or -1 if it is malformed
+static int stackDepth(const BytebeatProgram& p) {
+  int d = 0, maxD = 0;
+  for (int i = 0; i < p.count; ++i) {
+    const uint8_t code = p.ops[i].code;
+    if (code == BB_T || code == BB_CONST) d++;
+    else if (code == BB_SELECT) d -= 2;
+    else if (code >= BB_FIRST_BINARY && code < BB_FIRST_BINARY + BB_K_OFFSET) d--;
+    if (d < 1) return -1;
+    if (d > maxD) maxD = d;
+  }
+  return d == 1 ? maxD : -1;
+}
+
+static bool compileFormula(const char* text, BytebeatProgram& p, char* err, int errLen) {
+  if (strlen(text) >= (size_t)BYTEBEAT_TEXT_MAX) {
+    if (err && errLen > 0) snprintf(err, errLen, "formula longer than %d characters", BYTEBEAT_TEXT_MAX - 1);
+    return false;
+  }
+  Compiler c = {text, 0, &p, err, errLen, true, 0};
+  p.count = 0;
+  parseExpr(c);
+  skipSpace(c);
+  if (c.ok && c.s[c.pos]) fail(c, "unexpected character");
+  if (!c.ok) return false;
+  p.depth = stackDepth(p);
+  if (p.depth < 0 || p.depth > BYTEBEAT_STACK) {
+    if (err && errLen > 0) snprintf(err, errLen, "needs %d stack entries, max %d", p.depth, BYTEBEAT_STACK);
+    return false;
+  }
+  strcpy(p.text, text);
+  return true;
+}
+
+/* =========================
+   Staged program (seqlock: odd sequence = UI is writing)
+   ========================= */
+
+static BytebeatProgram g_staged;
+static std::atomic<uint32_t> g_stagedSeq(0);
+static uint32_t g_appliedSeq = 0;  // audio side
+static BytebeatProgram g_active;   // audio side
+
+static uint32_t* g_stack = nullptr;
+static uint32_t g_t = 0, g_tFrac = 0;
+
+bool setBytebeatFormula(const char* text, char* err, int errLen) {
+  static BytebeatProgram p;  // UI side scratch
+  if (!compileFormula(text, p, err, errLen)) return false;
+  g_stagedSeq.fetch_add(1, std::memory_order_acq_rel);
+  g_staged = p;
+  g_stagedSeq.fetch_add(1, std::memory_order_acq_rel);
+  return true;
+}
+
+bool loadBytebeatFile(const char* path, int index, char* err, int errLen) {
+  if (!SPIFFS.begin(false)) {
+    snprintf(err, errLen, "SPIFFS not mounted");
+    return false;
+  }
+  File f = SPIFFS.open(path, "r");
+  if (!f) {
+    snprintf(err, errLen, "cannot open %s", path);
+    return false;
+  }
+  char line[BYTEBEAT_TEXT_MAX];
+  int len = 0, found = -1, lineNo = 1;
+  bool tooLong = false, done = false;
+  while (!done) {
+    const int ch = f.available() ? f.read() : -1;
+    if (ch >= 0 && ch != '\n' && ch != '\r') {
+      if (len < BYTEBEAT_TEXT_MAX - 1) line[len++] = (char)ch;
+      else tooLong = true;
+      continue;
+    }
+    line[len] = '\0';
+    len = 0;
+    if (line[0] && line[0] != '#' && ++found == index) break;
+    tooLong = false;  // long comments are fine
+    if (ch == '\n') lineNo++;
+    done = ch < 0;
+  }
+  f.close();
+  if (found == index && tooLong) {
+    // Never compile a truncated formula
+    snprintf(err, errLen, "line %d too long (max %d characters)", lineNo, BYTEBEAT_TEXT_MAX - 1);
+    return false;
+  }
+  if (found != index) {
+    snprintf(err, errLen, "%s has %d formulas", path, found + 1);
+    return false;
+  }
+  return setBytebeatFormula(line, err, errLen);
+}
+
+int getBytebeatPresetCount() {
+  return PRESET_COUNT;
+}
+
+const char* getBytebeatPreset(int i) {
+  return i >= 0 && i < PRESET_COUNT ? kPresets[i] : nullptr;
+}
+
+bool attachBytebeat() {
+  g_t = 0;
+  g_tFrac = 0;
+  if (g_active.count == 0) compileFormula(kPresets[0], g_active, nullptr, 0);
+  if (g_stack) return true;
+  g_stack = (uint32_t*)arenaAlloc(BYTEBEAT_STACK * AUDIO_BLOCK_SIZE * sizeof(uint32_t), "bytebeat stack");
+  return g_stack != nullptr;
+}
+
+void releaseBytebeat() {
+  g_stack = nullptr;
+}
+
+void renderBytebeat(int16_t* out, int n) {
+  // Block boundary: pick up a complete staged program if it changed
+  const uint32_t seq = g_stagedSeq.load(std::memory_order_acquire);
+  if (seq != g_appliedSeq && !(seq & 1u)) {
+    const BytebeatProgram p = g_staged;
+    if (g_stagedSeq.load(std::memory_order_acquire) == seq) {
+      g_active = p;
+      g_appliedSeq = seq;
+      g_t = 0;
+      g_tFrac = 0;
+    }
+  }
+  if (!g_stack || g_active.count == 0) {  // arena full: stay silent
+    for (int i = 0; i < n; ++i) out[i] = 0;
+    return;
+  }
+
+  // t for each output sample: bytebeat.rate ticks per second, held in between
+  const uint32_t rate = (uint32_t)paramValue(ParamId::BYTEBEAT_RATE);
+  uint32_t tv[AUDIO_BLOCK_SIZE];
+  for (int i = 0; i < n; ++i) {
+    tv[i] = g_t;
+    g_tFrac += rate;
+    if (g_tFrac >= (uint32_t)SAMPLE_RATE_HZ) {
+      g_tFrac -= (uint32_t)SAMPLE_RATE_HZ;
+      g_t++;
+    }
+  }
+  const uint32_t* v = runProgram(g_active, tv, g_stack, n);
+  for (int i = 0; i < n; ++i) out[i] = (int16_t)(((int32_t)(v[i] & 255u) - 128) << 8);
+}
+
+static void printProgram(const BytebeatProgram& p) {
+  Serial.printf("  %d ops, %d stack entries:", p.count, p.depth);
+  for (int i = 0; i < p.count; ++i) {
+    const uint8_t code = p.ops[i].code;
+    if (code == BB_CONST || code >= BB_FIRST_BINARY + BB_K_OFFSET) Serial.printf(" %s(%u)", kOpNames[code], (unsigned)p.ops[i].k);
+    else Serial.printf(" %s", kOpNames[code]);
+  }
+  Serial.println();
+}
+
+void printBytebeat() {
+  BytebeatProgram p = g_staged;  // only the UI writes g_staged
+  if (p.count == 0) compileFormula(kPresets[0], p, nullptr, 0);
+  Serial.printf("Bytebeat: %s  (t at %.0f Hz)\n", p.text, getParam(ParamId::BYTEBEAT_RATE));
+  printProgram(p);
+}
+
+/* =========================
+   Benchmark
+   ========================= */
+
+static volatile uint32_t g_benchSink;
+
+void benchBytebeat() {
+  uint32_t* stack = (uint32_t*)malloc(BYTEBEAT_STACK * AUDIO_BLOCK_SIZE * sizeof(uint32_t));
+  if (!stack) {
+    Serial.println("Bytebeat bench: out of memory");
+    return;
+  }
+  const int BLOCKS = 32;
+  const int N = BLOCKS * AUDIO_BLOCK_SIZE;
+  uint32_t tv[AUDIO_BLOCK_SIZE];
+  uint32_t sink = 0;
+  Serial.printf("Bytebeat @%u MHz, cycles/sample (block interpreter / per-sample interpreter):\n",
+    (unsigned)ESP.getCpuFreqMHz());
+  static BytebeatProgram p;
+  for (int k = 0; k < PRESET_COUNT; ++k) {
+    compileFormula(kPresets[k], p, nullptr, 0);
+    uint32_t c0 = cycleNow();
+    for (int b = 0; b < BLOCKS; ++b) {
+      for (int i = 0; i < AUDIO_BLOCK_SIZE; ++i) tv[i] = (uint32_t)(b * AUDIO_BLOCK_SIZE + i);
+      const uint32_t* v = runProgram(p, tv, stack, AUDIO_BLOCK_SIZE);
+      for (int i = 0; i < AUDIO_BLOCK_SIZE; ++i) sink += v[i];
+    }
+    const float blockCost = (float)(cycleNow() - c0) / (float)N;
+    c0 = cycleNow();
+    for (int i = 0; i < N; ++i) {
+      const uint32_t t = (uint32_t)i;
+      sink += runProgram(p, &t, stack, 1)[0];
+    }
+    const float sampleCost = (float)(cycleNow() - c0) / (float)N;
+    Serial.printf("  %-36s %2d ops %6.1f / %6.1f\n", kPresets[k], p.count, blockCost, sampleCost);
+  }
+
+  // The first preset written out in C++
+  uint32_t out[AUDIO_BLOCK_SIZE];
+  uint32_t c0 = cycleNow();
+  for (int b = 0; b < BLOCKS; ++b) {
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; ++i) {
+      const uint32_t t = (uint32_t)(b * AUDIO_BLOCK_SIZE + i);
+      out[i] = t * (t >> 5 | t >> 8);
+    }
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; ++i) sink += out[i];
+  }
+  Serial.printf("  %-36s    native %6.1f\n", kPresets[0], (float)(cycleNow() - c0) / (float)N);
+  g_benchSink = sink;
+  free(stack);
+}
@@ -0,0 +1,205 @@
+#include "colored_noise.h"
+#include "audio_synthesis.h"  // clampS16
+#include "config.h"
+#include <Arduino.h>
+#include <math.h>
+
+static inline int32_t randS16(uint32_t& rng) {
+  return (int32_t)(noiseRand(rng) >> 16) - 32768;
+}
+
+void renderWhiteNoise(uint32_t& rng, int16_t* out, int n) {
+  for (int i = 0; i < n; ++i) out[i] = (int16_t)randS16(rng);
+}
+
+/* === Voss-McCartney pink === */
+
+void vossInit(VossPink& v, uint32_t seed) {
+  v.rng = seed ? seed : 1;
+  v.counter = 0;
+  v.sum = 0;
+  for (int i = 0; i < VOSS_ROWS; ++i) {
+    v.rows[i] = randS16(v.rng);
+    v.sum += v.rows[i];
+  }
+}
+
+void renderVossPink(VossPink& v, int16_t* out, int n) {
+  uint32_t rng = v.rng, counter = v.counter;
+  int32_t sum = v.sum;
+  for (int i = 0; i < n; ++i) {
+    // Row k changes every 2^(k+1) samples: exactly one row per sample, picked by the
+    // trailing zeros of the counter, plus a fresh white row every sample
+    counter++;
+    uint32_t k = __builtin_ctz(counter);
+    if (k < (uint32_t)VOSS_ROWS) {
+      int32_t r = randS16(rng);
+      sum += r - v.rows[k];
+      v.rows[k] = r;
+    }
+    out[i] = clampS16((sum + randS16(rng)) >> 4);
+  }
+  v.rng = rng;
+  v.counter = counter;
+  v.sum = sum;
+}
+
+/* === Kellet filter-bank pink === */
+
+void kelletInit(KelletPink& k, uint32_t seed) {
+  k.rng = seed ? seed : 1;
+  for (int i = 0; i < 7; ++i) k.b[i] = 0.0f;
+}
+
+void renderKelletPink(KelletPink& k, int16_t* out, int n) {
+  // Paul Kellet's refined coefficients; the pole frequencies scale with the sample rate,
+  // which keeps the 1/f shape over the same number of octaves below Nyquist
+  float b0 = k.b[0], b1 = k.b[1], b2 = k.b[2], b3 = k.b[3], b4 = k.b[4], b5 = k.b[5], b6 = k.b[6];
+  uint32_t rng = k.rng;
+  const float OUT_SCALE = 0.11f;  // ~unity peak for unit white input
+  for (int i = 0; i < n; ++i) {
+    float w = (float)randS16(rng);
+    b0 = 0.99886f * b0 + w * 0.0555179f;
+    b1 = 0.99332f * b1 + w * 0.0750759f;
+    b2 = 0.96900f * b2 + w * 0.1538520f;
+    b3 = 0.86650f * b3 + w * 0.3104856f;
+    b4 = 0.55000f * b4 + w * 0.5329522f;
+    b5 = -0.7616f * b5 - w * 0.0168980f;
+    float p = b0 + b1 + b2 + b3 + b4 + b5 + b6 + w * 0.5362f;
+    b6 = w * 0.115926f;
+    out[i] = clampS16((int32_t)(p * OUT_SCALE));
+  }
+  k.b[0] = b0; k.b[1] = b1; k.b[2] = b2; k.b[3] = b3; k.b[4] = b4; k.b[5] = b5; k.b[6] = b6;
+  k.rng = rng;
+}
+
+/* === 1/f^alpha slope filter === */
+
+// Poles one octave apart from SLOPE_F0. A zero placed 2^(alpha/2) octaves from its pole
+// makes each octave contribute -3*alpha dB on average: alpha = 2 moves every zero onto the
+// next pole (a plain integrator), alpha = 0 cancels them, negative alpha puts zeros below.
+static const float SLOPE_F0 = 8.0f;
+static const int SLOPE_GAIN_PROBE = 4096;  // impulse response length used for the RMS gain
+
+static inline float matchedZ(float hz) {
+  return expf(-TAU_F * hz / (float)SAMPLE_RATE_HZ);
+}
+
+void slopeNoiseInit(SlopeNoise& s, float alpha, float targetRms, uint32_t seed) {
+  if (alpha < -2.0f) alpha = -2.0f;
+  if (alpha > 2.0f) alpha = 2.0f;
+  s.rng = seed ? seed : 1;
+  s.alpha = alpha;
+  const float zeroRatio = powf(2.0f, 0.5f * alpha);
+  float f = SLOPE_F0;
+  for (int j = 0; j < SLOPE_SECTIONS; ++j, f *= 2.0f) {
+    s.pole[j] = matchedZ(f);
+    s.zero[j] = matchedZ(f * zeroRatio);
+    s.x1[j] = s.y1[j] = 0.0f;
+  }
+
+  // Power gain = energy of the impulse response; white int16 has RMS 32768/sqrt(3)
+  float energy = 0.0f;
+  for (int i = 0; i < SLOPE_GAIN_PROBE; ++i) {
+    float x = (i == 0) ? 1.0f : 0.0f;
+    for (int j = 0; j < SLOPE_SECTIONS; ++j) {
+      float y = x - s.zero[j] * s.x1[j] + s.pole[j] * s.y1[j];
+      s.x1[j] = x;
+      s.y1[j] = y;
+      x = y;
+    }
+    energy += x * x;
+  }
+  for (int j = 0; j < SLOPE_SECTIONS; ++j) s.x1[j] = s.y1[j] = 0.0f;
+  s.gain = targetRms / (sqrtf(energy) * 18918.6f);
+}
+
+void renderSlopeNoise(SlopeNoise& s, int16_t* out, int n) {
+  uint32_t rng = s.rng;
+  const float g = s.gain;
+  for (int i = 0; i < n; ++i) {
+    float x = (float)randS16(rng) * g;
+    for (int j = 0; j < SLOPE_SECTIONS; ++j) {
+      float y = x - s.zero[j] * s.x1[j] + s.pole[j] * s.y1[j];
+      s.x1[j] = x;
+      s.y1[j] = y;
+      x = y;
+    }
+    out[i] = clampS16((int32_t)x);
+  }
+  s.rng = rng;
+}
+
+/* === Slope check === */
+
+static const int CHECK_BANDS = 6;  // 100 Hz .. 3.2 kHz
+static const int CHECK_SEG = 256;
+static const int CHECK_SEGS = 48;
+
+enum class CheckGen : uint8_t { WHITE, VOSS, KELLET, SLOPE };
+
+// Goertzel power at each band averaged over CHECK_SEGS Hann-windowed segments, then the
+// least-squares slope of dB against octaves
+static float measureSlope(CheckGen gen, float alpha) {
+  static VossPink voss;
+  static KelletPink kellet;
+  static SlopeNoise slope;
+  uint32_t rng = 0x1234567u;
+  vossInit(voss, 0x2468ACEu);
+  kelletInit(kellet, 0x13579BDu);
+  slopeNoiseInit(slope, alpha, 6000.0f, 0x0F1E2D3u);
+
+  float coef[CHECK_BANDS];
+  double power[CHECK_BANDS];
+  float f = 100.0f;
+  for (int b = 0; b < CHECK_BANDS; ++b, f *= 2.0f) {
+    coef[b] = 2.0f * cosf(TAU_F * f / (float)SAMPLE_RATE_HZ);
+    power[b] = 0.0;
+  }
+
+  int16_t seg[CHECK_SEG];
+  float win[CHECK_SEG];
+  for (int s = 0; s < CHECK_SEGS + 4; ++s) {
+    switch (gen) {
+      case CheckGen::WHITE:  renderWhiteNoise(rng, seg, CHECK_SEG); break;
+      case CheckGen::VOSS:   renderVossPink(voss, seg, CHECK_SEG); break;
+      case CheckGen::KELLET: renderKelletPink(kellet, seg, CHECK_SEG); break;
+      case CheckGen::SLOPE:  renderSlopeNoise(slope, seg, CHECK_SEG); break;
+    }
+    if (s < 4) continue;  // let the filters settle
+    for (int i = 0; i < CHECK_SEG; ++i) {
+      win[i] = (0.5f - 0.5f * cosf(TAU_F * (float)i / (float)CHECK_SEG)) * (float)seg[i];
+    }
+    for (int b = 0; b < CHECK_BANDS; ++b) {
+      float q1 = 0.0f, q2 = 0.0f;
+      for (int i = 0; i < CHECK_SEG; ++i) {
+        float q0 = coef[b] * q1 - q2 + win[i];
+        q2 = q1;
+        q1 = q0;
+      }
+      power[b] += (double)(q1 * q1 + q2 * q2 - coef[b] * q1 * q2);
+    }
+  }
+
+  // Fit dB = a + slope * octave
+  float sx = 0, sy = 0, sxx = 0, sxy = 0;
+  for (int b = 0; b < CHECK_BANDS; ++b) {
+    float y = 10.0f * log10f((float)(power[b] / CHECK_SEGS) + 1e-9f);
+    sx += b; sy += y; sxx += b * b; sxy += b * y;
+  }
+  return (CHECK_BANDS * sxy - sx * sy) / (CHECK_BANDS * sxx - sx * sx);
+}
+
+void checkNoiseSlopes() {
+  Serial.println("Noise slope check (dB/octave over 100 Hz - 3.2 kHz, expected -3*alpha):");
+  Serial.printf("  %-22s %+6.2f (expect  +0.00)\n", "white (xorshift)", measureSlope(CheckGen::WHITE, 0.0f));
+  Serial.printf("  %-22s %+6.2f (expect  -3.00)\n", "pink Voss-McCartney", measureSlope(CheckGen::VOSS, 0.0f));
+  Serial.printf("  %-22s %+6.2f (expect  -3.00)\n", "pink Kellet IIR", measureSlope(CheckGen::KELLET, 0.0f));
+  static const float kAlphas[] = {-2.0f, -1.0f, -0.5f, 0.0f, 0.5f, 1.0f, 1.5f, 2.0f};
+  for (size_t i = 0; i < sizeof(kAlphas) / sizeof(kAlphas[0]); ++i) {
+    char label[24];
+    snprintf(label, sizeof(label), "slope alpha %+.1f", kAlphas[i]);
+    Serial.printf("  %-22s %+6.2f (expect %+6.2f)\n", label,
+      measureSlope(CheckGen::SLOPE, kAlphas[i]), -3.0f * kAlphas[i]);
+  }
+}
@@ -0,0 +1,39 @@
+#include "control_rate.h"
+#include "config.h"
+#include <math.h>
+
+static volatile int g_ctrlRate = CTRL_RATE_DEFAULT;
+
+void setControlRate(int k) {
+  if (k < 1) k = 1;
+  if (k > CTRL_RATE_MAX) k = CTRL_RATE_MAX;
+  g_ctrlRate = k;
+}
+
+int getControlRate() {
+  return g_ctrlRate;
+}
+
+void ctrlRampTo(CtrlRamp& r, float target) {
+  int k = g_ctrlRate;
+  r.step = (target - r.value) / (float)k;
+  r.left = k;
+}
+
+void ctrlLfoInit(CtrlLfo& l, float hz, float phase) {
+  l.hz = hz;
+  l.phase = phase;
+  l.ramp.value = sinf(phase);
+  l.ramp.step = 0.0f;
+  l.ramp.left = 0;
+}
+
+float ctrlLfoNext(CtrlLfo& l) {
+  if (ctrlRampDue(l.ramp)) {
+    // Advance K samples of phase and ramp to the sine there
+    l.phase += TAU_F * l.hz * (float)g_ctrlRate / (float)SAMPLE_RATE_HZ;
+    while (l.phase >= TAU_F) l.phase -= TAU_F;
+    ctrlRampTo(l.ramp, sinf(l.phase));
+  }
+  return ctrlRampNext(l.ramp);
+}
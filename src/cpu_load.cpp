@@ -0,0 +1,45 @@
+#include "cpu_load.h"
+#include <Arduino.h>
+
+volatile uint32_t g_loadCycles[(int)LoadSource::COUNT] = {0, 0, 0, 0};
+static uint32_t g_loadStartUs = 0;
+static uint32_t g_loadMhz = 0;  // clock the window was started at
+
+void cpuLoadReset() {
+  for (int i = 0; i < (int)LoadSource::COUNT; ++i) g_loadCycles[i] = 0;
+  g_loadStartUs = micros();
+  g_loadMhz = getCpuFrequencyMhz();
+}
+
+bool cpuLoadCheckFrequency() {
+  if (getCpuFrequencyMhz() == g_loadMhz) return false;
+  cpuLoadReset();
+  return true;
+}
+
+uint32_t getCoreBusyCycles(int core) {
+  return core == 0 ? g_loadCycles[(int)LoadSource::RENDER]
+    : g_loadCycles[(int)LoadSource::AUDIO] + g_loadCycles[(int)LoadSource::ISR] + g_loadCycles[(int)LoadSource::UI];
+}
+
+uint32_t getCpuLoadStartUs() {
+  return g_loadStartUs;
+}
+
+void printCpuDuty(const char* label) {
+  if (cpuLoadCheckFrequency()) {
+    Serial.printf("CPU duty [%s]: clock changed, window restarted at %u MHz\n", label, (unsigned)g_loadMhz);
+    return;
+  }
+  uint32_t elapsedUs = micros() - g_loadStartUs;
+  if (elapsedUs == 0) return;
+  const uint32_t mhz = getCpuFrequencyMhz();
+  const float avail = (float)elapsedUs * (float)mhz;
+  float pct[(int)LoadSource::COUNT];
+  for (int i = 0; i < (int)LoadSource::COUNT; ++i) pct[i] = 100.0f * (float)g_loadCycles[i] / avail;
+  float core1 = pct[(int)LoadSource::AUDIO] + pct[(int)LoadSource::ISR] + pct[(int)LoadSource::UI];
+  Serial.printf("CPU duty @%u MHz [%s]: core0 %.1f%% (render), core1 %.1f%% (isr %.1f%%, audio %.1f%%, ui %.1f%%)\n",
+    (unsigned)mhz, label, pct[(int)LoadSource::RENDER], core1,
+    pct[(int)LoadSource::ISR], pct[(int)LoadSource::AUDIO], pct[(int)LoadSource::UI]);
+  cpuLoadReset();
+}
@@ -0,0 +1,78 @@
+#include "delay_line.h"
+#include "colored_noise.h"  // noiseRand
+#include "config.h"
+#include "profiling.h"
+#include <Arduino.h>
+#include <string.h>
+
+void delayInit(DelayLine& d, int16_t* buf, int bits) {
+  d.buf = buf;
+  d.mask = (1u << bits) - 1u;
+  d.w = 0;
+  memset(buf, 0, (size_t)(1u << bits) * sizeof(int16_t));
+}
+
+/* =========================
+   Benchmark
+   ========================= */
+
+static const int BENCH_BITS = 9;
+static int16_t g_benchLine[1 << BENCH_BITS];
+static volatile int32_t g_benchSink;
+
+void benchDelayLine() {
+  const int BLOCKS = 64;
+  const int N = BLOCKS * AUDIO_BLOCK_SIZE;
+  DelayLine d;
+  delayInit(d, g_benchLine, BENCH_BITS);
+  uint32_t rng = 0x2545F491u;
+  for (int i = 0; i <= (int)d.mask; ++i) delayWrite(d, (int16_t)(noiseRand(rng) >> 16));
+  Serial.printf("Delay line @%u MHz, cycles/sample (write + reads):\n", (unsigned)ESP.getCpuFreqMHz());
+
+  // Integer read at a per-sample float delay (the old phaser)
+  int32_t acc = 0;
+  float dly = 2.0f;
+  uint32_t c0 = cycleNow();
+  for (int i = 0; i < N; ++i) {
+    const int di = (int)dly;
+    const int32_t v = d.buf[(d.w - di) & d.mask];
+    delayWrite(d, (int16_t)v);
+    acc += v;
+    dly += 0.003f;
+    if (dly >= 21.0f) dly = 2.0f;
+  }
+  const float intCost = (float)(cycleNow() - c0) / (float)N;
+
+  // One gliding interpolated tap, retargeted per block
+  DelayTap tap;
+  delayTapSet(tap, 2.0f);
+  c0 = cycleNow();
+  for (int k = 0; k < BLOCKS; ++k) {
+    delayTapGlide(tap, 2.0f + (float)(k % 19), AUDIO_BLOCK_SIZE);
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; ++i) {
+      const int32_t v = delayTapRead(d, tap);
+      delayWrite(d, (int16_t)v);
+      acc += v;
+    }
+  }
+  const float oneCost = (float)(cycleNow() - c0) / (float)N;
+
+  // Three taps (the chorus)
+  DelayTap taps[3];
+  for (int j = 0; j < 3; ++j) delayTapSet(taps[j], 100.0f + 20.0f * (float)j);
+  c0 = cycleNow();
+  for (int k = 0; k < BLOCKS; ++k) {
+    for (int j = 0; j < 3; ++j) delayTapGlide(taps[j], 100.0f + (float)((k + 7 * j) % 50), AUDIO_BLOCK_SIZE);
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; ++i) {
+      const int32_t v = delayTapRead(d, taps[0]) + delayTapRead(d, taps[1]) + delayTapRead(d, taps[2]);
+      delayWrite(d, (int16_t)(v >> 2));
+      acc += v;
+    }
+  }
+  const float threeCost = (float)(cycleNow() - c0) / (float)N;
+  g_benchSink = acc;
+
+  Serial.printf("  integer read, float delay     %6.1f\n", intCost);
+  Serial.printf("  1 interpolated gliding tap    %6.1f\n", oneCost);
+  Serial.printf("  3 interpolated gliding taps   %6.1f\n", threeCost);
+}
@@ -0,0 +1,224 @@
+#include "diagnostics.h"
+#include "app.h"
+#include "audio_synthesis.h"
+#include "config.h"
+#include "cpu_load.h"
+#include "sample_clock.h"
+#include <Arduino.h>
+#include <M5Stack.h>
+
+static TaskHandle_t g_audioTask = nullptr;
+static TaskHandle_t g_renderTask = nullptr;
+static TaskHandle_t g_uiTask = nullptr;
+
+// Frame timing, written by the UI loop only
+static uint32_t g_frameDrawUs = 0;
+static uint32_t g_frameIntervalMs = 0;
+static uint32_t g_lastFrameMs = 0;
+
+// Per reader: the frame draw watermark and the core load baseline (busy cycles at the
+// previous snapshot and when they were read, in the cpu_load window that began at loadStartUs)
+struct DiagWindow {
+  uint32_t frameDrawMaxUs;
+  uint32_t loadStartUs;
+  uint32_t loadUs;
+  uint32_t loadCycles[2];
+};
+static DiagWindow g_windows[(int)DiagReader::COUNT];
+
+static uint32_t g_telemetryMs = TELEMETRY_DEFAULT_MS;
+static uint32_t g_lastTelemetryMs = 0;
+static uint32_t g_telemetryDropped = 0;
+
+void initDiagnostics(TaskHandle_t audio, TaskHandle_t render, TaskHandle_t ui) {
+  g_audioTask = audio;
+  g_renderTask = render;
+  g_uiTask = ui;
+}
+
+void diagNoteFrame(uint32_t drawUs) {
+  uint32_t now = millis();
+  if (g_lastFrameMs) g_frameIntervalMs = now - g_lastFrameMs;
+  g_lastFrameMs = now;
+  g_frameDrawUs = drawUs;
+  for (int i = 0; i < (int)DiagReader::COUNT; ++i) {
+    if (drawUs > g_windows[i].frameDrawMaxUs) g_windows[i].frameDrawMaxUs = drawUs;
+  }
+}
+
+// ESP-IDF reports the high-water mark in bytes (vanilla FreeRTOS uses words)
+static uint32_t stackFree(TaskHandle_t task) {
+  return task ? (uint32_t)uxTaskGetStackHighWaterMark(task) : 0;
+}
+
+// Busy share of each core since the previous snapshot (or since the cpu_load window restarted,
+// for a duty report or a clock change), so the figure never spans two clock rates and the
+// 32-bit sums are only ever differenced over one refresh period
+static void collectCoreBusy(DiagSnapshot& d, DiagWindow& w) {
+  cpuLoadCheckFrequency();
+  const uint32_t startUs = getCpuLoadStartUs();
+  if (startUs != w.loadStartUs) {
+    w.loadStartUs = startUs;
+    w.loadUs = startUs;
+    w.loadCycles[0] = w.loadCycles[1] = 0;
+  }
+  const uint32_t nowUs = micros();
+  const uint32_t cycles[2] = {getCoreBusyCycles(0), getCoreBusyCycles(1)};
+  const float avail = (float)(nowUs - w.loadUs) * (float)getCpuFrequencyMhz();
+  float busy[2];
+  for (int c = 0; c < 2; ++c) {
+    busy[c] = avail > 0.0f ? 100.0f * (float)(cycles[c] - w.loadCycles[c]) / avail : 0.0f;
+    if (busy[c] > 100.0f) busy[c] = 100.0f;
+    w.loadCycles[c] = cycles[c];
+  }
+  w.loadUs = nowUs;
+  d.core0Busy = busy[0];
+  d.core1Busy = busy[1];
+}
+
+void collectDiagnostics(DiagSnapshot& d, DiagReader reader) {
+  DiagWindow& w = g_windows[(int)reader];
+  d.ms = millis();
+  d.freeHeap = ESP.getFreeHeap();
+  d.minFreeHeap = ESP.getMinFreeHeap();
+  d.largestBlock = ESP.getMaxAllocHeap();
+  d.freePsram = ESP.getPsramSize() ? ESP.getFreePsram() : 0;
+  d.audioStackFree = stackFree(g_audioTask);
+  d.renderStackFree = stackFree(g_renderTask);
+  d.uiStackFree = stackFree(g_uiTask);
+  collectCoreBusy(d, w);
+  d.frameDrawUs = g_frameDrawUs;
+  d.frameDrawMaxUs = w.frameDrawMaxUs;
+  d.frameIntervalMs = g_frameIntervalMs;
+  d.underruns = getUnderrunCount();
+  d.sampleClock = getSampleClock();
+  d.avLatencyUs = getAvLatencyUs();
+  d.renderLeadUs = getRenderLeadUs();
+  d.fifoFill = (uint8_t)getFifoFill();
+  d.track = (uint8_t)getCurrentTrack();
+  w.frameDrawMaxUs = 0;  // worst since this reader's last snapshot
+}
+
+/* === Diagnostics page === */
+
+void drawDiagnosticsPage(const DiagSnapshot& d) {
+  M5.Lcd.fillRect(NOISE_X, NOISE_Y, NOISE_W, NOISE_H, TFT_BLACK);
+  M5.Lcd.setTextSize(1);
+  M5.Lcd.setTextColor(TFT_GREEN, TFT_BLACK);
+  int y = NOISE_Y + 4;
+  const int x = NOISE_X + 6;
+  const int line = 12;
+  M5.Lcd.setCursor(x, y);
+  M5.Lcd.printf("DIAGNOSTICS  (A+C to close)   t=%u s", (unsigned)(d.ms / 1000));
+  y += line + 4;
+  M5.Lcd.setTextColor(TFT_WHITE, TFT_BLACK);
+  M5.Lcd.setCursor(x, y);
+  M5.Lcd.printf("Heap free %u  min %u", (unsigned)d.freeHeap, (unsigned)d.minFreeHeap);
+  y += line;
+  M5.Lcd.setCursor(x, y);
+  M5.Lcd.printf("Largest block %u  PSRAM free %u", (unsigned)d.largestBlock, (unsigned)d.freePsram);
+  y += line;
+  M5.Lcd.setCursor(x, y);
+  M5.Lcd.printf("Stack free: audio %u  render %u  ui %u",
+    (unsigned)d.audioStackFree, (unsigned)d.renderStackFree, (unsigned)d.uiStackFree);
+  y += line;
+  M5.Lcd.setCursor(x, y);
+  M5.Lcd.printf("Core0 idle %.1f%%  Core1 idle %.1f%%  @%u MHz",
+    100.0f - d.core0Busy, 100.0f - d.core1Busy, (unsigned)getCpuFrequencyMhz());
+  y += line;
+  M5.Lcd.setCursor(x, y);
+  M5.Lcd.printf("Frame draw %u us (max %u)  every %u ms",
+    (unsigned)d.frameDrawUs, (unsigned)d.frameDrawMaxUs, (unsigned)d.frameIntervalMs);
+  y += line;
+  M5.Lcd.setCursor(x, y);
+  M5.Lcd.printf("Audio: FIFO %u/%d blocks  underruns %u",
+    (unsigned)d.fifoFill, getRenderAhead(), (unsigned)d.underruns);
+  y += line;
+  M5.Lcd.setCursor(x, y);
+  M5.Lcd.printf("Clock %.1f s  lead %.1f ms  A->V %.1f ms", (double)d.sampleClock / SAMPLE_RATE_HZ,
+    d.renderLeadUs / 1000.0f, d.avLatencyUs / 1000.0f);
+  y += line;
+  M5.Lcd.setCursor(x, y);
+  M5.Lcd.printf("Telemetry: %s  dropped %u",
+    g_telemetryMs ? "on" : "off", (unsigned)g_telemetryDropped);
+}
+
+void printDiagnostics() {
+  DiagSnapshot d;
+  collectDiagnostics(d, DiagReader::PAGE);
+  Serial.printf("Heap: free %u, min %u, largest block %u, PSRAM free %u\n",
+    (unsigned)d.freeHeap, (unsigned)d.minFreeHeap, (unsigned)d.largestBlock, (unsigned)d.freePsram);
+  Serial.printf("Stack free (bytes): audioTask %u/%u, renderTask %u/%u, loop %u\n",
+    (unsigned)d.audioStackFree, (unsigned)AUDIO_TASK_STACK_BYTES,
+    (unsigned)d.renderStackFree, (unsigned)RENDER_TASK_STACK_BYTES, (unsigned)d.uiStackFree);
+  Serial.printf("Idle: core0 %.1f%%, core1 %.1f%%; frame %u us (max %u) every %u ms; FIFO %u, underruns %u\n",
+    100.0f - d.core0Busy, 100.0f - d.core1Busy, (unsigned)d.frameDrawUs, (unsigned)d.frameDrawMaxUs,
+    (unsigned)d.frameIntervalMs, (unsigned)d.fifoFill, (unsigned)d.underruns);
+  Serial.printf("Sample clock %llu; render lead %u us; audio -> display %u us\n",
+    (unsigned long long)d.sampleClock, (unsigned)d.renderLeadUs, (unsigned)d.avLatencyUs);
+}
+
+/* === Binary telemetry === */
+
+static inline uint16_t sat16(uint32_t v) {
+  return v > 0xFFFFu ? 0xFFFFu : (uint16_t)v;
+}
+
+void setTelemetryInterval(uint32_t ms) {
+  g_telemetryMs = ms;
+  g_lastTelemetryMs = millis();
+}
+
+uint32_t getTelemetryInterval() {
+  return g_telemetryMs;
+}
+
+uint32_t getTelemetryDropped() {
+  return g_telemetryDropped;
+}
+
+void pollTelemetry() {
+  if (!g_telemetryMs) return;
+  uint32_t now = millis();
+  if (now - g_lastTelemetryMs < g_telemetryMs) return;
+  g_lastTelemetryMs = now;
+
+  // Never wait on the UART: skip this period if the frame would not fit in the TX buffer
+  if (Serial.availableForWrite() < (int)sizeof(TelemetryFrame)) {
+    g_telemetryDropped++;
+    return;
+  }
+
+  DiagSnapshot d;
+  collectDiagnostics(d, DiagReader::TELEMETRY);
+  TelemetryFrame f;
+  f.sync[0] = 0xA5;
+  f.sync[1] = 0x5A;
+  f.version = TELEMETRY_VERSION;
+  f.length = (uint8_t)(sizeof(TelemetryFrame) - 5);  // minus header and checksum
+  f.ms = d.ms;
+  f.freeHeap = d.freeHeap;
+  f.minFreeHeap = d.minFreeHeap;
+  f.largestBlock = d.largestBlock;
+  f.freePsram = d.freePsram;
+  f.audioStackFree = sat16(d.audioStackFree);
+  f.renderStackFree = sat16(d.renderStackFree);
+  f.uiStackFree = sat16(d.uiStackFree);
+  f.core0Busy = sat16((uint32_t)(d.core0Busy * 10.0f + 0.5f));
+  f.core1Busy = sat16((uint32_t)(d.core1Busy * 10.0f + 0.5f));
+  f.frameDrawUs = d.frameDrawUs;
+  f.frameIntervalMs = sat16(d.frameIntervalMs);
+  f.underruns = d.underruns;
+  f.fifoFill = d.fifoFill;
+  f.track = d.track;
+  f.sampleClock = (uint32_t)d.sampleClock;
+  f.avLatencyUs = d.avLatencyUs;
+  f.renderLeadUs = sat16(d.renderLeadUs);
+  f.frameDrawMaxUs = d.frameDrawMaxUs;
+
+  const uint8_t* p = (const uint8_t*)&f;
+  uint8_t sum = 0;
+  for (uint32_t i = 4; i < sizeof(TelemetryFrame) - 1; ++i) sum += p[i];
+  f.checksum = sum;
+  Serial.write(p, sizeof(TelemetryFrame));
+}
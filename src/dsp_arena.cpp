@@ -0,0 +1,72 @@
+#include "dsp_arena.h"
+#include "config.h"
+#include <Arduino.h>
+#include <string.h>
+
+// 17 owner names today (9 generators/tables plus one per insert type); the rest is headroom
+static const int ARENA_OWNERS_MAX = 32;
+
+struct ArenaOwner {
+  const char* name;
+  uint32_t bytes;     // held for the current track
+  uint32_t maxBytes;  // largest ever held
+};
+
+static uint32_t g_arena[DSP_ARENA_BYTES / 4];  // uint32_t for alignment
+static volatile uint32_t g_arenaUsed = 0;
+static volatile uint32_t g_arenaPeak = 0;
+static ArenaOwner g_owners[ARENA_OWNERS_MAX];
+static int g_ownerCount = 0;
+static ArenaOwner g_untracked = {"untracked", 0, 0};  // owners that found the table full
+
+static ArenaOwner* findOwner(const char* name) {
+  for (int i = 0; i < g_ownerCount; ++i) {
+    if (g_owners[i].name == name || strcmp(g_owners[i].name, name) == 0) return &g_owners[i];
+  }
+  if (g_ownerCount >= ARENA_OWNERS_MAX) return nullptr;
+  ArenaOwner& o = g_owners[g_ownerCount++];
+  o.name = name;
+  o.bytes = 0;
+  o.maxBytes = 0;
+  return &o;
+}
+
+void arenaReset() {
+  g_arenaUsed = 0;
+  for (int i = 0; i < g_ownerCount; ++i) g_owners[i].bytes = 0;
+  g_untracked.bytes = 0;
+}
+
+void* arenaAlloc(uint32_t bytes, const char* owner) {
+  bytes = (bytes + 3u) & ~3u;
+  if (g_arenaUsed + bytes > DSP_ARENA_BYTES) return nullptr;
+  void* p = (uint8_t*)g_arena + g_arenaUsed;
+  g_arenaUsed += bytes;
+  if (g_arenaUsed > g_arenaPeak) g_arenaPeak = g_arenaUsed;
+  ArenaOwner* o = findOwner(owner);
+  if (!o) o = &g_untracked;
+  o->bytes += bytes;
+  if (o->bytes > o->maxBytes) o->maxBytes = o->bytes;
+  return p;
+}
+
+uint32_t getArenaUsed() {
+  return g_arenaUsed;
+}
+
+uint32_t getArenaPeak() {
+  return g_arenaPeak;
+}
+
+void printArenaReport() {
+  Serial.printf("DSP arena: %u / %u bytes in use, peak %u\n",
+    (unsigned)g_arenaUsed, (unsigned)DSP_ARENA_BYTES, (unsigned)g_arenaPeak);
+  for (int i = 0; i < g_ownerCount; ++i) {
+    Serial.printf("  %-14s %6u bytes now, %6u max\n", g_owners[i].name,
+      (unsigned)g_owners[i].bytes, (unsigned)g_owners[i].maxBytes);
+  }
+  if (g_untracked.maxBytes) {
+    Serial.printf("  %-14s %6u bytes now, %6u max (owner table full, raise ARENA_OWNERS_MAX)\n",
+      g_untracked.name, (unsigned)g_untracked.bytes, (unsigned)g_untracked.maxBytes);
+  }
+}
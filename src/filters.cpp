@@ -0,0 +1,272 @@
+#include "filters.h"
+#include "colored_noise.h"  // noiseRand
+#include "config.h"
+#include "profiling.h"
+#include <Arduino.h>
+#include <math.h>
+
+// Keep centre frequencies where tan() is well behaved
+static inline float clampHz(float hz) {
+  const float maxHz = 0.45f * (float)SAMPLE_RATE_HZ;
+  if (hz < 10.0f) return 10.0f;
+  return hz > maxHz ? maxHz : hz;
+}
+
+/* === State-variable filter === */
+
+static void svfCompute(Svf& f) {
+  f.g = tanf(0.5f * TAU_F * clampHz(f.hz) / (float)SAMPLE_RATE_HZ);
+  f.k = 1.0f / f.q;
+  f.a1 = 1.0f / (1.0f + f.g * (f.g + f.k));
+  f.a2 = f.g * f.a1;
+  f.a3 = f.g * f.a2;
+}
+
+void svfInit(Svf& f, float hz, float q) {
+  f.hz = hz;
+  f.q = q > 0.05f ? q : 0.05f;
+  svfCompute(f);
+  svfReset(f);
+}
+
+void svfSet(Svf& f, float hz, float q) {
+  if (q < 0.05f) q = 0.05f;
+  if (hz == f.hz && q == f.q) return;
+  f.hz = hz;
+  f.q = q;
+  svfCompute(f);
+}
+
+void svfReset(Svf& f) {
+  f.ic1 = f.ic2 = 0.0f;
+}
+
+void svfProcess(Svf& f, float* buf, int n, SvfMode mode) {
+  // Locals so the compiler keeps the state in registers
+  Svf s = f;
+  switch (mode) {
+    case SvfMode::LOW:   for (int i = 0; i < n; ++i) buf[i] = svfTick(s, buf[i], SvfMode::LOW);   break;
+    case SvfMode::BAND:  for (int i = 0; i < n; ++i) buf[i] = svfTick(s, buf[i], SvfMode::BAND);  break;
+    case SvfMode::HIGH:  for (int i = 0; i < n; ++i) buf[i] = svfTick(s, buf[i], SvfMode::HIGH);  break;
+    case SvfMode::NOTCH: for (int i = 0; i < n; ++i) buf[i] = svfTick(s, buf[i], SvfMode::NOTCH); break;
+  }
+  f.ic1 = s.ic1;
+  f.ic2 = s.ic2;
+}
+
+/* === Biquad === */
+
+static void biquadCompute(Biquad& f) {
+  const float w = TAU_F * clampHz(f.hz) / (float)SAMPLE_RATE_HZ;
+  const float cw = cosf(w);
+  const float alpha = sinf(w) / (2.0f * f.q);
+  float b0, b1, b2;
+  switch (f.type) {
+    case BiquadType::LOWPASS:  b0 = 0.5f * (1.0f - cw); b1 = 1.0f - cw;   b2 = b0;    break;
+    case BiquadType::HIGHPASS: b0 = 0.5f * (1.0f + cw); b1 = -1.0f - cw;  b2 = b0;    break;
+    case BiquadType::BANDPASS: b0 = alpha;              b1 = 0.0f;        b2 = -alpha; break;  // 0 dB peak
+    default:                   b0 = 1.0f;               b1 = -2.0f * cw;  b2 = 1.0f;  break;  // NOTCH
+  }
+  const float inv = 1.0f / (1.0f + alpha);
+  f.b0 = b0 * inv;
+  f.b1 = b1 * inv;
+  f.b2 = b2 * inv;
+  f.a1 = -2.0f * cw * inv;
+  f.a2 = (1.0f - alpha) * inv;
+}
+
+void biquadInit(Biquad& f, BiquadType type, float hz, float q) {
+  f.type = type;
+  f.hz = hz;
+  f.q = q > 0.05f ? q : 0.05f;
+  biquadCompute(f);
+  biquadReset(f);
+}
+
+void biquadSet(Biquad& f, BiquadType type, float hz, float q) {
+  if (q < 0.05f) q = 0.05f;
+  if (type == f.type && hz == f.hz && q == f.q) return;
+  f.type = type;
+  f.hz = hz;
+  f.q = q;
+  biquadCompute(f);
+}
+
+void biquadReset(Biquad& f) {
+  f.z1 = f.z2 = 0.0f;
+}
+
+void biquadProcess(Biquad& f, float* buf, int n) {
+  const float b0 = f.b0, b1 = f.b1, b2 = f.b2, a1 = f.a1, a2 = f.a2;
+  float z1 = f.z1, z2 = f.z2;
+  for (int i = 0; i < n; ++i) {
+    const float x = buf[i];
+    const float y = b0 * x + z1;
+    z1 = b1 * x - a1 * y + z2;
+    z2 = b2 * x - a2 * y;
+    buf[i] = y;
+  }
+  f.z1 = z1;
+  f.z2 = z2;
+}
+
+/* === Formant filter === */
+
+struct Vowel {
+  float hz[FORMANT_BANDS];
+  float gain[FORMANT_BANDS];
+};
+
+// First three formants (adult male) and relative band gains
+static const Vowel kVowels[FORMANT_VOWELS] = {
+  {{700.0f, 1220.0f, 2600.0f}, {0.90f, 0.70f, 0.50f}},  // a
+  {{530.0f, 1840.0f, 2480.0f}, {0.90f, 0.60f, 0.45f}},  // e
+  {{270.0f, 2290.0f, 3010.0f}, {0.90f, 0.45f, 0.40f}},  // i
+  {{570.0f,  840.0f, 2410.0f}, {0.90f, 0.65f, 0.30f}},  // o
+  {{300.0f,  870.0f, 2240.0f}, {0.90f, 0.50f, 0.25f}},  // u
+};
+
+const char* getVowelName(int vowel) {
+  static const char* const kNames[FORMANT_VOWELS] = {"a", "e", "i", "o", "u"};
+  return vowel >= 0 && vowel < FORMANT_VOWELS ? kNames[vowel] : "?";
+}
+
+static void formantCompute(FormantFilter& f) {
+  float v = fmodf(f.vowel, (float)FORMANT_VOWELS);
+  if (v < 0.0f) v += (float)FORMANT_VOWELS;
+  const int i0 = (int)v;
+  const int i1 = (i0 + 1) % FORMANT_VOWELS;
+  const float t = v - (float)i0;
+  for (int b = 0; b < FORMANT_BANDS; ++b) {
+    const float hz = kVowels[i0].hz[b] + t * (kVowels[i1].hz[b] - kVowels[i0].hz[b]);
+    f.gain[b] = kVowels[i0].gain[b] + t * (kVowels[i1].gain[b] - kVowels[i0].gain[b]);
+    svfSet(f.band[b], hz, f.q);
+  }
+}
+
+void formantInit(FormantFilter& f, float vowel, float q) {
+  f.vowel = vowel;
+  f.q = q;
+  for (int b = 0; b < FORMANT_BANDS; ++b) svfInit(f.band[b], kVowels[0].hz[b], q);
+  formantCompute(f);
+}
+
+void formantSetVowel(FormantFilter& f, float vowel) {
+  if (vowel == f.vowel) return;
+  f.vowel = vowel;
+  formantCompute(f);
+}
+
+void formantProcess(FormantFilter& f, float* buf, int n) {
+  // All bands in one pass: three independent recurrences interleave well
+  static_assert(FORMANT_BANDS == 3, "formantProcess is unrolled for three bands");
+  Svf s0 = f.band[0], s1 = f.band[1], s2 = f.band[2];
+  const float g0 = f.gain[0], g1 = f.gain[1], g2 = f.gain[2];
+  for (int i = 0; i < n; ++i) {
+    const float x = buf[i];
+    buf[i] = g0 * svfTick(s0, x, SvfMode::BAND) + g1 * svfTick(s1, x, SvfMode::BAND) +
+             g2 * svfTick(s2, x, SvfMode::BAND);
+  }
+  f.band[0] = s0;
+  f.band[1] = s1;
+  f.band[2] = s2;
+}
+
+/* === Benchmark === */
+
+// The replaced pattern: a Chamberlin SVF whose coefficient is 2*sin(pi*fc/SR), recomputed
+// for every filter on every sample
+static volatile float g_benchHzScale = 1.0f;  // keeps the compiler from folding the sinf
+
+static float chamberlinPerSample(float* low, float* band, const float* hz, int bands, float x) {
+  float v = 0.0f;
+  const float scale = g_benchHzScale;
+  for (int b = 0; b < bands; ++b) {
+    const float f = 2.0f * sinf(0.5f * TAU_F * hz[b] * scale / (float)SAMPLE_RATE_HZ);
+    low[b] += f * band[b];
+    const float high = x - low[b] - 0.2f * band[b];
+    band[b] += f * high;
+    v += band[b];
+  }
+  return v;
+}
+
+static float g_benchBuf[AUDIO_BLOCK_SIZE];
+static uint32_t g_benchRng = 0x9E3779B9u;
+
+static void fillBenchBlock() {
+  for (int i = 0; i < AUDIO_BLOCK_SIZE; ++i) {
+    g_benchBuf[i] = (float)(int32_t)noiseRand(g_benchRng) * (1.0f / 2147483648.0f);
+  }
+}
+
+void benchFilters() {
+  const int BLOCKS = 64;
+  const int N = BLOCKS * AUDIO_BLOCK_SIZE;
+  float* buf = g_benchBuf;
+  const float budget = (float)ESP.getCpuFreqMHz() * 1000000.0f / (float)SAMPLE_RATE_HZ;
+  Serial.printf("Filters @%u MHz (budget %.0f cycles/sample), cycles/sample:\n",
+    (unsigned)ESP.getCpuFreqMHz(), budget);
+
+  // Fill time alone, subtracted from every row
+  uint32_t c0 = cycleNow();
+  for (int k = 0; k < BLOCKS; ++k) fillBenchBlock();
+  const float fillCost = (float)(cycleNow() - c0) / (float)N;
+
+  static Svf svf;
+  svfInit(svf, 1000.0f, 3.0f);
+  c0 = cycleNow();
+  for (int k = 0; k < BLOCKS; ++k) { fillBenchBlock(); svfProcess(svf, buf, AUDIO_BLOCK_SIZE, SvfMode::BAND); }
+  const float svfCost = (float)(cycleNow() - c0) / (float)N - fillCost;
+
+  static Biquad bq;
+  biquadInit(bq, BiquadType::BANDPASS, 1000.0f, 3.0f);
+  c0 = cycleNow();
+  for (int k = 0; k < BLOCKS; ++k) { fillBenchBlock(); biquadProcess(bq, buf, AUDIO_BLOCK_SIZE); }
+  const float bqCost = (float)(cycleNow() - c0) / (float)N - fillCost;
+
+  // Swept SVF: coefficients at control rate (every 16 samples) against every sample
+  c0 = cycleNow();
+  for (int k = 0; k < BLOCKS; ++k) {
+    fillBenchBlock();
+    for (int j = 0; j < AUDIO_BLOCK_SIZE; j += 16) {
+      svfSet(svf, 300.0f + 20.0f * (float)((k * AUDIO_BLOCK_SIZE + j) & 63), 3.0f);
+      svfProcess(svf, buf + j, 16, SvfMode::BAND);
+    }
+  }
+  const float sweepCost = (float)(cycleNow() - c0) / (float)N - fillCost;
+  float low1[1] = {0.0f}, band1[1] = {0.0f};
+  const float hz1[1] = {1000.0f};
+  c0 = cycleNow();
+  for (int k = 0; k < BLOCKS; ++k) {
+    fillBenchBlock();
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; ++i) buf[i] = chamberlinPerSample(low1, band1, hz1, 1, buf[i]);
+  }
+  const float oldOne = (float)(cycleNow() - c0) / (float)N - fillCost;
+
+  // Formant: three bands, morphing once per block, against the per-sample recompute
+  static FormantFilter ff;
+  formantInit(ff, 0.0f, 5.0f);
+  c0 = cycleNow();
+  for (int k = 0; k < BLOCKS; ++k) {
+    fillBenchBlock();
+    formantSetVowel(ff, 0.01f * (float)k);
+    formantProcess(ff, buf, AUDIO_BLOCK_SIZE);
+  }
+  const float formantCost = (float)(cycleNow() - c0) / (float)N - fillCost;
+  float low3[3] = {0, 0, 0}, band3[3] = {0, 0, 0};
+  const float hz3[3] = {700.0f, 1220.0f, 2600.0f};
+  c0 = cycleNow();
+  for (int k = 0; k < BLOCKS; ++k) {
+    fillBenchBlock();
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; ++i) buf[i] = chamberlinPerSample(low3, band3, hz3, 3, buf[i]);
+  }
+  const float oldThree = (float)(cycleNow() - c0) / (float)N - fillCost;
+
+  Serial.printf("  SVF bandpass, fixed           %6.1f\n", svfCost);
+  Serial.printf("  biquad bandpass, fixed        %6.1f\n", bqCost);
+  Serial.printf("  SVF swept, coeffs every 16    %6.1f   vs per-sample sinf %6.1f  (saves %.1f)\n",
+    sweepCost, oldOne, oldOne - sweepCost);
+  Serial.printf("  formant, 3 bands, morphing    %6.1f   vs per-sample sinf %6.1f  (saves %.1f)\n",
+    formantCost, oldThree, oldThree - formantCost);
+}
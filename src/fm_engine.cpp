@@ -0,0 +1,334 @@
+#include "fm_engine.h"
+#include "audio_synthesis.h"  // clampS16
+#include "colored_noise.h"    // noiseRand
+#include "config.h"
+#include "lut.h"
+#include "params.h"
+#include "profiling.h"
+#include <Arduino.h>
+#include <math.h>
+
+static const float FM_PHASE_PER_HZ = 4294967296.0f / (float)SAMPLE_RATE_HZ;
+static const float FM_SILENT = 1e-4f;  // envelope level treated as off (-80 dB)
+
+// modBy[op]: operators modulating op (bit j = op j); carriers: operators summed to the output
+struct FmAlgoSpec {
+  uint8_t modBy[FM_OPS];
+  uint8_t carriers;
+};
+
+static const FmAlgoSpec kAlgos[(int)FmAlgo::COUNT] = {
+  {{0x2, 0x4, 0x8, 0x0}, 0x1},  // STACK
+  {{0x2, 0x0, 0x8, 0x0}, 0x5},  // TWO_PAIRS
+  {{0xE, 0x0, 0x0, 0x0}, 0x1},  // THREE_TO_ONE
+  {{0x6, 0x0, 0x8, 0x0}, 0x1},  // BRANCH
+  {{0x8, 0x8, 0x8, 0x0}, 0x7},  // ONE_TO_THREE
+  {{0x0, 0x0, 0x0, 0x0}, 0xF},  // ADDITIVE
+};
+
+/* === Presets === */
+
+// Two pairs: the old FM Bell pair (440 Hz carrier, 110 Hz modulator, index 2) whose index
+// decays faster than its level, plus a hum an octave down with an inharmonic strike partial
+static const FmPatch kBellPatch = {
+  "bell", FmAlgo::TWO_PAIRS, 0.0f,
+  {
+    {1.00f, 0.55f, 0.002f, 4.0f, 0.0f, 1.0f},
+    {0.25f, 2.00f, 0.002f, 2.5f, 0.0f, 1.0f},
+    {0.50f, 0.35f, 0.002f, 6.0f, 0.0f, 1.5f},
+    {1.40f, 1.20f, 0.001f, 0.8f, 0.0f, 0.5f},
+  }
+};
+
+// The old FM Metallic: one carrier, one modulator, held; ratio and index follow the params
+static const FmPatch kMetalPatch = {
+  "metal", FmAlgo::STACK, 0.0f,
+  {
+    {1.00f, 0.95f, 0.005f, 1.0f, 1.0f, 0.2f},
+    {2.36f, 3.20f, 0.005f, 1.0f, 1.0f, 0.2f},
+    {1.00f, 0.00f, 0.0f,   1.0f, 0.0f, 0.2f},
+    {1.00f, 0.00f, 0.0f,   1.0f, 0.0f, 0.2f},
+  }
+};
+
+const FmPatch& getFmPreset(FmPreset p) {
+  return p == FmPreset::METAL ? kMetalPatch : kBellPatch;
+}
+
+const char* getFmAlgoName(FmAlgo a) {
+  switch (a) {
+    case FmAlgo::STACK:        return "4>3>2>1";
+    case FmAlgo::TWO_PAIRS:    return "2>1 4>3";
+    case FmAlgo::THREE_TO_ONE: return "2+3+4>1";
+    case FmAlgo::BRANCH:       return "4>3>1 2>1";
+    case FmAlgo::ONE_TO_THREE: return "4>1,2,3";
+    case FmAlgo::ADDITIVE:     return "1+2+3+4";
+    default:                   return "?";
+  }
+}
+
+/* === Voice === */
+
+static inline float t60Mul(float seconds) {
+  if (seconds <= 0.0f) return 0.0f;
+  return expf(-6.9078f / (seconds * (float)SAMPLE_RATE_HZ));
+}
+
+static inline uint32_t hzToInc(float hz) {
+  if (hz < 0.0f) hz = 0.0f;
+  if (hz > 0.5f * (float)SAMPLE_RATE_HZ) hz = 0.5f * (float)SAMPLE_RATE_HZ;
+  return (uint32_t)(hz * FM_PHASE_PER_HZ);
+}
+
+void fmVoiceInit(FmVoice& v, const FmPatch& patch) {
+  v.patch = &patch;
+  v.algo = patch.algo;
+  v.pitchHz = 0.0f;
+  v.velocity = 1.0f;
+  for (int k = 0; k < FM_OPS; ++k) {
+    const FmOpSpec& s = patch.op[k];
+    v.ratio[k] = s.ratio;
+    v.level[k] = s.level;
+    v.phase[k] = 0;
+    v.inc[k] = 0;
+    v.stage[k] = FmStage::IDLE;
+    v.env[k] = 0.0f;
+    v.attackInc[k] = s.attackS > 0.0f ? 1.0f / (s.attackS * (float)SAMPLE_RATE_HZ) : 1.0f;
+    v.decayMul[k] = t60Mul(s.decayS);
+    v.releaseMul[k] = t60Mul(s.releaseS);
+  }
+  v.fb[0] = v.fb[1] = 0.0f;
+}
+
+void fmVoiceSetPitch(FmVoice& v, float hz) {
+  v.pitchHz = hz;
+  for (int k = 0; k < FM_OPS; ++k) v.inc[k] = hzToInc(hz * v.ratio[k]);
+}
+
+void fmVoiceSetRatio(FmVoice& v, int op, float ratio) {
+  if (op < 0 || op >= FM_OPS) return;
+  v.ratio[op] = ratio;
+  v.inc[op] = hzToInc(v.pitchHz * ratio);
+}
+
+void fmVoiceSetLevel(FmVoice& v, int op, float level) {
+  if (op < 0 || op >= FM_OPS) return;
+  // 32 rad keeps the summed phase offset well inside the int32 conversion below
+  if (level > 32.0f) level = 32.0f;
+  if (level < 0.0f) level = 0.0f;
+  v.level[op] = level;
+}
+
+void fmNoteOn(FmVoice& v, float hz, float velocity) {
+  fmVoiceSetPitch(v, hz);
+  v.velocity = velocity;
+  for (int k = 0; k < FM_OPS; ++k) v.stage[k] = FmStage::ATTACK;
+}
+
+void fmNoteOff(FmVoice& v) {
+  for (int k = 0; k < FM_OPS; ++k) {
+    if (v.stage[k] != FmStage::IDLE) v.stage[k] = FmStage::RELEASE;
+  }
+}
+
+bool fmVoiceActive(const FmVoice& v) {
+  const uint8_t carriers = kAlgos[(int)v.algo].carriers;
+  for (int k = 0; k < FM_OPS; ++k) {
+    if ((carriers & (1u << k)) && v.stage[k] != FmStage::IDLE) return true;
+  }
+  return false;
+}
+
+// Fill env[0..n) for operator k; returns false when the operator is silent all block
+static bool runEnvelope(FmVoice& v, int k, float* env, int n) {
+  float e = v.env[k];
+  FmStage st = v.stage[k];
+  if (st == FmStage::IDLE) return false;
+  const float sus = v.patch->op[k].sustain;
+  for (int i = 0; i < n; ++i) {
+    switch (st) {
+      case FmStage::ATTACK:
+        e += v.attackInc[k];
+        if (e >= 1.0f) { e = 1.0f; st = FmStage::DECAY; }
+        break;
+      case FmStage::DECAY:
+        e = sus + (e - sus) * v.decayMul[k];
+        break;
+      case FmStage::RELEASE:
+        e *= v.releaseMul[k];
+        break;
+      default:
+        break;
+    }
+    env[i] = e;
+  }
+  // A decayed (or released) operator with nothing left to sustain goes idle
+  if (st != FmStage::ATTACK && e < FM_SILENT && (st == FmStage::RELEASE || sus < FM_SILENT)) {
+    st = FmStage::IDLE;
+    e = 0.0f;
+  }
+  v.env[k] = e;
+  v.stage[k] = st;
+  return true;
+}
+
+void fmRender(FmVoice& v, float* acc, int n) {
+  const float* lut = g_sineLut;
+  if (!lut) return;
+  const FmAlgoSpec& algo = kAlgos[(int)v.algo];
+  float sig[FM_OPS][AUDIO_BLOCK_SIZE];  // enveloped operator outputs, -1..1
+  float env[AUDIO_BLOCK_SIZE];
+  float mod[AUDIO_BLOCK_SIZE];          // phase offset in cycles
+  bool live[FM_OPS];
+
+  for (int k = FM_OPS - 1; k >= 0; --k) {
+    uint32_t p = v.phase[k];
+    const uint32_t inc = v.inc[k];
+    const bool carrier = (algo.carriers >> k) & 1u;
+    const bool used = carrier || ((algo.modBy[0] | algo.modBy[1] | algo.modBy[2]) >> k & 1u);
+    live[k] = used && v.level[k] > 0.0f && runEnvelope(v, k, env, n);
+    if (!live[k]) {
+      v.phase[k] = p + inc * (uint32_t)n;  // keep time so a retrigger stays in tune
+      continue;
+    }
+
+    // Sum the modulators, scaled from radians to cycles
+    bool modulated = false;
+    for (int j = k + 1; j < FM_OPS; ++j) {
+      if (!((algo.modBy[k] >> j) & 1u) || !live[j]) continue;
+      const float g = v.level[j] * (1.0f / TAU_F);
+      const float* s = sig[j];
+      if (!modulated) {
+        for (int i = 0; i < n; ++i) mod[i] = g * s[i];
+        modulated = true;
+      } else {
+        for (int i = 0; i < n; ++i) mod[i] += g * s[i];
+      }
+    }
+
+    float* out = sig[k];
+    if (k == FM_OPS - 1 && v.patch->feedback != 0.0f) {
+      // Self-modulation: serial by nature, averaged over two samples to tame it
+      const float fbg = v.patch->feedback * (0.5f / TAU_F);
+      float f0 = v.fb[0], f1 = v.fb[1];
+      for (int i = 0; i < n; ++i) {
+        p += inc;
+        const uint32_t off = (uint32_t)(int32_t)(fbg * (f0 + f1) * 16777216.0f) << 8;
+        const float s = lutSinU32(lut, p + off);
+        f1 = f0;
+        f0 = s;
+        out[i] = s * env[i];
+      }
+      v.fb[0] = f0;
+      v.fb[1] = f1;
+    } else if (modulated) {
+      for (int i = 0; i < n; ++i) {
+        p += inc;
+        // Cycles -> 2^32 phase via 8.24 fixed point: a +-128 cycle range is plenty
+        const uint32_t off = (uint32_t)(int32_t)(mod[i] * 16777216.0f) << 8;
+        out[i] = lutSinU32(lut, p + off) * env[i];
+      }
+    } else {
+      for (int i = 0; i < n; ++i) {
+        p += inc;
+        out[i] = lutSinU32(lut, p) * env[i];
+      }
+    }
+    v.phase[k] = p;
+
+    if (carrier) {
+      const float g = v.level[k] * v.velocity;
+      for (int i = 0; i < n; ++i) acc[i] += g * out[i];
+    }
+  }
+}
+
+/* === FM Bell / FM Metallic tracks === */
+
+static FmVoice g_bell, g_metal;
+static bool g_bellReady = false, g_metalReady = false;
+static int g_bellToStrike = 0;
+static uint32_t g_bellRng = 0x2545F491u;
+
+static const float BELL_HZ = 440.0f;
+static const float BELL_INTERVAL_S = 3.0f;
+
+static void renderBell(float* acc, int n) {
+  if (!g_bellReady) {
+    fmVoiceInit(g_bell, kBellPatch);
+    g_bellReady = true;
+  }
+  if (g_bellToStrike <= 0) {
+    fmNoteOn(g_bell, BELL_HZ, 0.85f + 0.15f * (float)(noiseRand(g_bellRng) >> 24) / 255.0f);
+    g_bellToStrike = (int)(BELL_INTERVAL_S * (float)SAMPLE_RATE_HZ);
+  }
+  g_bellToStrike -= n;
+  fmRender(g_bell, acc, n);
+}
+
+static void renderMetal(float* acc, int n) {
+  if (!g_metalReady) {
+    fmVoiceInit(g_metal, kMetalPatch);
+    g_metalReady = true;
+  }
+  const float fc = paramValue(ParamId::FM_METAL_CARRIER);
+  const float fm = paramValue(ParamId::FM_METAL_MOD);
+  if (!fmVoiceActive(g_metal)) fmNoteOn(g_metal, fc, 1.0f);
+  // Params glide at block rate; the modulator is set in Hz through its ratio
+  fmVoiceSetPitch(g_metal, fc);
+  fmVoiceSetRatio(g_metal, 1, fm / fc);
+  fmVoiceSetLevel(g_metal, 1, paramValue(ParamId::FM_METAL_INDEX));
+  fmRender(g_metal, acc, n);
+}
+
+void renderFmTrack(NoiseType t, int16_t* out, int n) {
+  float acc[AUDIO_BLOCK_SIZE];
+  for (int i = 0; i < n; ++i) acc[i] = 0.0f;
+  if (t == NoiseType::TONE_FM_METAL) renderMetal(acc, n);
+  else renderBell(acc, n);
+  for (int i = 0; i < n; ++i) out[i] = clampS16((int32_t)(acc[i] * 32767.0f));
+}
+
+/* === Benchmark === */
+
+// Every operator at full level and held, so nothing is skipped
+static const FmPatch kBenchPatch = {
+  "bench", FmAlgo::STACK, 0.0f,
+  {
+    {1.00f, 0.25f, 0.0f, 1.0f, 1.0f, 1.0f},
+    {2.00f, 2.00f, 0.0f, 1.0f, 1.0f, 1.0f},
+    {3.01f, 1.50f, 0.0f, 1.0f, 1.0f, 1.0f},
+    {0.50f, 1.00f, 0.0f, 1.0f, 1.0f, 1.0f},
+  }
+};
+
+void benchFmEngine() {
+  if (!g_sineLut) {
+    Serial.println("fmbench: no sine table attached; select FM Bell or FM Metallic first");
+    return;
+  }
+  static FmVoice v;
+  float acc[AUDIO_BLOCK_SIZE];
+  const int BLOCKS = 64;
+  const float budget = (float)ESP.getCpuFreqMHz() * 1000000.0f / (float)SAMPLE_RATE_HZ;
+  Serial.printf("FM engine @%u MHz (budget %.0f cycles/sample), cycles/sample by operators sounding:\n",
+    (unsigned)ESP.getCpuFreqMHz(), budget);
+  Serial.println("  algorithm        1      2      3      4");
+  for (int a = 0; a < (int)FmAlgo::COUNT; ++a) {
+    Serial.printf("  %-11s", getFmAlgoName((FmAlgo)a));
+    for (int ops = 1; ops <= FM_OPS; ++ops) {
+      fmVoiceInit(v, kBenchPatch);
+      v.algo = (FmAlgo)a;
+      for (int k = ops; k < FM_OPS; ++k) v.level[k] = 0.0f;
+      fmNoteOn(v, 220.0f, 1.0f);
+      uint32_t c0 = cycleNow();
+      for (int b = 0; b < BLOCKS; ++b) {
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; ++i) acc[i] = 0.0f;
+        fmRender(v, acc, AUDIO_BLOCK_SIZE);
+      }
+      Serial.printf(" %6.1f", (float)(cycleNow() - c0) / (float)(BLOCKS * AUDIO_BLOCK_SIZE));
+    }
+    Serial.println();
+  }
+  Serial.println("  (ops that are not carriers and modulate nothing in an algorithm are skipped)");
+}
@@ -0,0 +1,400 @@
+#include "fx_chain.h"
+#include "audio_synthesis.h"  // clampS16
+#include "config.h"
+#include "delay_line.h"
+#include "dsp_arena.h"
+#include "filters.h"
+#include "params.h"
+#include <Arduino.h>
+#include <math.h>
+#include <string.h>
+
+/* =========================
+   Effect state
+   ========================= */
+
+struct BitcrushState {
+  int32_t levels;   // quantization steps across full scale
+  int32_t holdN;    // samples per held value
+  int32_t hold;
+  int16_t held;
+};
+
+struct DownsampleState {
+  float lfo;        // radians, advanced once per block
+  float lfoStep;    // radians per sample
+  int32_t hold;
+  int16_t held;
+};
+
+struct PhaserState {
+  static const int STAGES = 4;
+  static const int BITS = 4;      // 16 samples: stage delays reach 7.25
+  int16_t buf[STAGES][1 << BITS];
+  DelayLine line[STAGES];
+  DelayTap tap[STAGES];
+  float lfo;
+};
+
+struct StutterState {
+  static const int BUF_SZ = 256;
+  int16_t buf[BUF_SZ];
+  int32_t len;
+  int32_t pos;        // capture or playback position
+  int32_t modeLeft;   // samples until a new slice is captured
+  bool capturing;
+};
+
+struct FormantState {
+  FormantFilter filter;
+  float morph;        // 0..1 through all vowels, advanced once per block
+};
+
+struct ChorusState {
+  static const int TAPS = 3;
+  static const int BITS = 9;      // 46 ms
+  int16_t buf[1 << BITS];
+  DelayLine line;
+  DelayTap tap[TAPS];
+  float lfo[TAPS];
+};
+
+struct FlangerState {
+  static const int BITS = 7;      // 11.6 ms
+  int16_t buf[1 << BITS];
+  DelayLine line;
+  DelayTap tap;
+  float lfo;
+};
+
+struct DopplerState {
+  static const int BITS = 11;     // 186 ms, 63 m of air
+  int16_t buf[1 << BITS];
+  DelayLine line;
+  DelayTap tap;
+  float x;            // source position along its path, m
+  float amp;
+};
+
+// Effect state lives in the DSP arena for as long as the track's chain is loaded
+struct FxSlot {
+  FxType type;
+  union {
+    void* mem;
+    BitcrushState* bitcrush;
+    DownsampleState* downsample;
+    PhaserState* phaser;
+    StutterState* stutter;
+    FormantState* formant;
+    ChorusState* chorus;
+    FlangerState* flanger;
+    DopplerState* doppler;
+  };
+};
+
+static uint32_t fxStateBytes(FxType t) {
+  switch (t) {
+    case FxType::BITCRUSH:   return sizeof(BitcrushState);
+    case FxType::DOWNSAMPLE: return sizeof(DownsampleState);
+    case FxType::PHASER:     return sizeof(PhaserState);
+    case FxType::STUTTER:    return sizeof(StutterState);
+    case FxType::FORMANT:    return sizeof(FormantState);
+    case FxType::CHORUS:     return sizeof(ChorusState);
+    case FxType::FLANGER:    return sizeof(FlangerState);
+    case FxType::DOPPLER:    return sizeof(DopplerState);
+    default: return 0;
+  }
+}
+
+static FxSlot g_slots[FX_CHAIN_MAX];
+static int g_slotCount = 0;
+
+/* =========================
+   Per-effect block processors
+   ========================= */
+
+static const float PHASER_MIN_DELAY = 1.0f, PHASER_MAX_DELAY = 5.0f;    // samples
+static const float CHORUS_DELAY_MS = 12.0f;
+static const float FLANGER_MIN_DELAY = 2.0f, FLANGER_MAX_DELAY = 55.0f;  // 0.2..5 ms
+static const float DOPPLER_PATH_M = 40.0f;     // the source runs from -40 m to +40 m
+static const float DOPPLER_CLOSEST_M = 4.0f;   // distance at the point of passing
+static const float SPEED_OF_SOUND = 343.0f;
+
+static float dopplerDelay(float x) {
+  return sqrtf(x * x + DOPPLER_CLOSEST_M * DOPPLER_CLOSEST_M) * ((float)SAMPLE_RATE_HZ / SPEED_OF_SOUND);
+}
+
+static float dopplerAmp(float x) {
+  return 0.35f + 0.65f * DOPPLER_CLOSEST_M / sqrtf(x * x + DOPPLER_CLOSEST_M * DOPPLER_CLOSEST_M);
+}
+
+// Advance a block LFO by n samples and return its value at the end of the block, where the
+// delay taps glide to
+static float blockLfo(float& phase, float hz, int n) {
+  phase += TAU_F * hz * (float)n / (float)SAMPLE_RATE_HZ;
+  if (phase >= TAU_F) phase -= TAU_F;
+  return sinf(phase);
+}
+
+static void resetSlot(FxSlot& s) {
+  switch (s.type) {
+    case FxType::BITCRUSH:
+      s.bitcrush->levels = 8;
+      s.bitcrush->holdN = 8;
+      s.bitcrush->hold = 0;
+      s.bitcrush->held = 0;
+      break;
+    case FxType::DOWNSAMPLE:
+      s.downsample->lfo = 0.0f;
+      s.downsample->lfoStep = TAU_F * 0.15f / (float)SAMPLE_RATE_HZ;
+      s.downsample->hold = 0;
+      s.downsample->held = 0;
+      break;
+    case FxType::PHASER:
+      for (int k = 0; k < PhaserState::STAGES; ++k) {
+        delayInit(s.phaser->line[k], s.phaser->buf[k], PhaserState::BITS);
+        delayTapSet(s.phaser->tap[k], PHASER_MIN_DELAY * (1.0f + 0.15f * (float)k));
+      }
+      s.phaser->lfo = 0.75f * TAU_F;  // start at the shortest delay
+      break;
+    case FxType::STUTTER:
+      memset(s.stutter->buf, 0, sizeof(StutterState::buf));
+      s.stutter->len = 64;
+      s.stutter->pos = 0;
+      s.stutter->modeLeft = 0;
+      s.stutter->capturing = false;
+      break;
+    case FxType::FORMANT:
+      formantInit(s.formant->filter, paramValue(ParamId::FORMANT_VOWEL), 5.0f);
+      s.formant->morph = 0.0f;
+      break;
+    case FxType::CHORUS:
+      delayInit(s.chorus->line, s.chorus->buf, ChorusState::BITS);
+      for (int k = 0; k < ChorusState::TAPS; ++k) {
+        delayTapSet(s.chorus->tap[k], CHORUS_DELAY_MS * 0.001f * (float)SAMPLE_RATE_HZ);
+        s.chorus->lfo[k] = 2.1f * (float)k;
+      }
+      break;
+    case FxType::FLANGER:
+      delayInit(s.flanger->line, s.flanger->buf, FlangerState::BITS);
+      delayTapSet(s.flanger->tap, FLANGER_MIN_DELAY);
+      s.flanger->lfo = 0.75f * TAU_F;  // start at the shortest delay
+      break;
+    case FxType::DOPPLER:
+      delayInit(s.doppler->line, s.doppler->buf, DopplerState::BITS);
+      s.doppler->x = -DOPPLER_PATH_M;
+      delayTapSet(s.doppler->tap, dopplerDelay(s.doppler->x));
+      s.doppler->amp = dopplerAmp(s.doppler->x);
+      break;
+    default:
+      break;
+  }
+}
+
+static void processBitcrush(BitcrushState& st, int16_t* buf, int n) {
+  const int32_t steps = st.levels - 1;
+  for (int i = 0; i < n; ++i) {
+    if (st.hold <= 0) {
+      int32_t x = (int32_t)buf[i] + 32768;               // 0..65535
+      int32_t qi = (x * steps + 32767) / 65535;          // nearest level
+      st.held = clampS16((qi * 65535) / steps - 32768);
+      st.hold = st.holdN;
+    }
+    st.hold--;
+    buf[i] = st.held;
+  }
+}
+
+static void processDownsample(DownsampleState& st, int16_t* buf, int n) {
+  // Hold length swept 2..14 by a 0.15 Hz LFO, evaluated once per block
+  int32_t holdN = 2 + (int32_t)roundf(12.0f * (0.5f + 0.5f * sinf(st.lfo)));
+  st.lfo += st.lfoStep * (float)n;
+  if (st.lfo >= TAU_F) st.lfo -= TAU_F;
+  for (int i = 0; i < n; ++i) {
+    if (st.hold <= 0) {
+      st.held = buf[i];
+      st.hold = holdN;
+    }
+    st.hold--;
+    buf[i] = st.held;
+  }
+}
+
+// Four Schroeder allpasses on short swept delays, mixed with the dry signal: the phase
+// shift cancels the input at a handful of irregularly spaced notches that move with the
+// sweep. v = x + g v[n-D], y = v[n-D] - g v. The stages run at half scale: v reaches
+// x / (1 - g) at low frequencies, and clipping it there would add DC.
+static void processPhaser(PhaserState& st, int16_t* buf, int n) {
+  const float l = 0.5f + 0.5f * blockLfo(st.lfo, 0.3f, n);
+  const float target = PHASER_MIN_DELAY + (PHASER_MAX_DELAY - PHASER_MIN_DELAY) * l;
+  for (int k = 0; k < PhaserState::STAGES; ++k) delayTapGlide(st.tap[k], target * (1.0f + 0.15f * (float)k), n);
+  for (int i = 0; i < n; ++i) {
+    int32_t x = buf[i] >> 1;
+    for (int k = 0; k < PhaserState::STAGES; ++k) {
+      const int32_t del = delayTapRead(st.line[k], st.tap[k]);
+      const int32_t v = clampS16(x + (del >> 1));   // g = 0.5
+      delayWrite(st.line[k], (int16_t)v);
+      x = del - (v >> 1);
+    }
+    buf[i] = clampS16((buf[i] >> 1) + x);
+  }
+}
+
+static void processStutter(StutterState& st, int16_t* buf, int n) {
+  for (int i = 0; i < n; ++i) {
+    if (st.modeLeft <= 0) {
+      // Start capturing a fresh slice of the input
+      st.len = random(18, 120);
+      st.pos = 0;
+      st.capturing = true;
+      st.modeLeft = random((int)(0.05f * SAMPLE_RATE_HZ), (int)(0.25f * SAMPLE_RATE_HZ));
+    }
+    if (st.capturing) {
+      st.buf[st.pos++] = buf[i];
+      if (st.pos >= st.len) {
+        st.capturing = false;
+        st.pos = 0;
+      }
+    } else {
+      buf[i] = st.buf[st.pos];
+      if (++st.pos >= st.len) st.pos = 0;
+    }
+    st.modeLeft--;
+  }
+}
+
+// Vowel = formant.vowel plus a slow cycle through all five at formant.rate; the filter
+// recomputes its coefficients only when the position moves
+static void processFormant(FormantState& st, int16_t* buf, int n) {
+  st.morph += paramValue(ParamId::FORMANT_RATE) * (float)n / (float)SAMPLE_RATE_HZ;
+  if (st.morph >= 1.0f) st.morph -= 1.0f;
+  formantSetVowel(st.filter, paramValue(ParamId::FORMANT_VOWEL) + (float)FORMANT_VOWELS * st.morph);
+  float x[AUDIO_BLOCK_SIZE];
+  while (n > 0) {
+    const int run = n < AUDIO_BLOCK_SIZE ? n : AUDIO_BLOCK_SIZE;
+    for (int i = 0; i < run; ++i) x[i] = (float)buf[i] * (0.7f / 32768.0f);
+    formantProcess(st.filter, x, run);
+    for (int i = 0; i < run; ++i) buf[i] = clampS16((int32_t)(x[i] * 32767.0f));
+    buf += run;
+    n -= run;
+  }
+}
+
+// Three taps around 12 ms, each swept by its own LFO (0.7, 1.05 and 1.4 Hz) by chorus.depth ms
+static void processChorus(ChorusState& st, int16_t* buf, int n) {
+  const float centre = CHORUS_DELAY_MS * 0.001f * (float)SAMPLE_RATE_HZ;
+  const float depth = paramValue(ParamId::CHORUS_DEPTH) * 0.001f * (float)SAMPLE_RATE_HZ;
+  for (int k = 0; k < ChorusState::TAPS; ++k) {
+    delayTapGlide(st.tap[k], centre + depth * blockLfo(st.lfo[k], 0.7f + 0.35f * (float)k, n), n);
+  }
+  for (int i = 0; i < n; ++i) {
+    const int32_t wet = delayTapRead(st.line, st.tap[0]) + delayTapRead(st.line, st.tap[1]) +
+                        delayTapRead(st.line, st.tap[2]);
+    delayWrite(st.line, buf[i]);
+    buf[i] = clampS16((buf[i] * 13107 + wet * 6554) >> 15);  // 0.4 dry + 0.2 per tap
+  }
+}
+
+// 0.15 Hz sweep of a 0.2..5 ms delay; feedback (flanger.feedback) sharpens the comb. The
+// input to the loop is scaled by 1 - |feedback| so the resonances peak at the input level.
+static void processFlanger(FlangerState& st, int16_t* buf, int n) {
+  const float l = 0.5f + 0.5f * blockLfo(st.lfo, 0.15f, n);
+  delayTapGlide(st.tap, FLANGER_MIN_DELAY + (FLANGER_MAX_DELAY - FLANGER_MIN_DELAY) * l, n);
+  const float feedback = paramValue(ParamId::FLANGER_FEEDBACK);
+  const int32_t fb = (int32_t)(feedback * 32768.0f);
+  const int32_t in = (int32_t)((1.0f - fabsf(feedback)) * 32768.0f);
+  for (int i = 0; i < n; ++i) {
+    const int32_t x = buf[i];
+    const int32_t del = delayTapRead(st.line, st.tap);
+    delayWrite(st.line, clampS16((x * in + del * fb) >> 15));
+    buf[i] = clampS16((x + del) >> 1);
+  }
+}
+
+// The source drives past at doppler.speed, DOPPLER_CLOSEST_M from the listener, and starts
+// over at the far end. The delay is the travel time of sound over the current distance, so
+// the pitch shift is the delay's rate of change, as in air; the level falls with distance.
+static void processDoppler(DopplerState& st, int16_t* buf, int n) {
+  st.x += paramValue(ParamId::DOPPLER_SPEED) * (float)n / (float)SAMPLE_RATE_HZ;
+  if (st.x > DOPPLER_PATH_M) st.x -= 2.0f * DOPPLER_PATH_M;  // same distance: no jump in delay
+  delayTapGlide(st.tap, dopplerDelay(st.x), n);
+  const float ampTarget = dopplerAmp(st.x);
+  const float ampStep = (ampTarget - st.amp) / (float)n;
+  float amp = st.amp;
+  for (int i = 0; i < n; ++i) {
+    const int32_t del = delayTapRead(st.line, st.tap);
+    delayWrite(st.line, buf[i]);
+    amp += ampStep;
+    buf[i] = clampS16((int32_t)((float)del * amp));
+  }
+  st.amp = ampTarget;
+}
+
+/* =========================
+   Chain management
+   ========================= */
+
+void initFxChain() {
+  g_slotCount = 0;
+}
+
+void releaseFxChain() {
+  g_slotCount = 0;
+}
+
+void setFxChain(const FxType* types, int count) {
+  int k = 0;
+  for (int i = 0; i < count && k < FX_CHAIN_MAX; ++i) {
+    if (types[i] == FxType::NONE) continue;
+    void* mem = arenaAlloc(fxStateBytes(types[i]), getFxTypeName(types[i]));
+    if (!mem) continue;  // arena full: skip the effect rather than fail the track
+    g_slots[k].type = types[i];
+    g_slots[k].mem = mem;
+    resetSlot(g_slots[k]);
+    ++k;
+  }
+  g_slotCount = k;
+}
+
+void setFxChainForType(NoiseType t) {
+  FxType chain[FX_CHAIN_MAX];
+  int n = getFxChainForType(t, chain);
+  setFxChain(chain, n);
+}
+
+int getFxChain(FxType* out) {
+  for (int i = 0; i < g_slotCount; ++i) out[i] = g_slots[i].type;
+  return g_slotCount;
+}
+
+void processFxChain(int16_t* buf, int n) {
+  for (int k = 0; k < g_slotCount; ++k) {
+    FxSlot& s = g_slots[k];
+    switch (s.type) {
+      case FxType::BITCRUSH:   processBitcrush(*s.bitcrush, buf, n);     break;
+      case FxType::DOWNSAMPLE: processDownsample(*s.downsample, buf, n); break;
+      case FxType::PHASER:     processPhaser(*s.phaser, buf, n);         break;
+      case FxType::STUTTER:    processStutter(*s.stutter, buf, n);       break;
+      case FxType::FORMANT:    processFormant(*s.formant, buf, n);       break;
+      case FxType::CHORUS:     processChorus(*s.chorus, buf, n);         break;
+      case FxType::FLANGER:    processFlanger(*s.flanger, buf, n);       break;
+      case FxType::DOPPLER:    processDoppler(*s.doppler, buf, n);       break;
+      default: break;
+    }
+  }
+}
+
+const char* getFxTypeName(FxType f) {
+  switch (f) {
+    case FxType::NONE:       return "None";
+    case FxType::BITCRUSH:   return "Bitcrush";
+    case FxType::DOWNSAMPLE: return "Downsample";
+    case FxType::PHASER:     return "Phaser";
+    case FxType::STUTTER:    return "Stutter";
+    case FxType::FORMANT:    return "Formant";
+    case FxType::CHORUS:     return "Chorus";
+    case FxType::FLANGER:    return "Flanger";
+    case FxType::DOPPLER:    return "Doppler";
+    default: return "Unknown";
+  }
+}
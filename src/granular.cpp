@@ -0,0 +1,214 @@
+#include "granular.h"
+#include "audio_synthesis.h"  // clampS16, nextSourceSampleS16
+#include "colored_noise.h"    // noiseRand
+#include "config.h"
+#include "dsp_arena.h"
+#include "lut.h"
+#include "params.h"
+#include <Arduino.h>
+#include <math.h>
+
+static const float GRAIN_REF_HZ = 630.0f;    // buffer sources play at their own pitch here
+static const int GRAIN_CAPTURE_PER_BLOCK = 256;  // spread buffer capture over blocks
+static const int GRAIN_MAX_SEMIS = 24;
+
+struct Grain {
+  uint32_t winPos, winInc;  // through the window, 2^32 = whole grain
+  uint32_t pos, inc;        // oscillator phase (2^32 = cycle) or buffer position (2^20 = sample)
+  float amp;
+  int left;                 // samples to go
+  int skip;                 // samples of the current block before the onset
+  bool fromBuffer;
+};
+
+static Grain g_pool[GRAIN_MAX];
+static int g_active = 0;
+static float g_nextOnset = 0.0f;  // samples from the start of the next block
+static uint32_t g_rng = 0x510E527Fu;
+
+static int16_t* g_buf = nullptr;
+static int g_bufFill = 0;
+static int g_bufSource = -1;
+
+static float g_semis[2 * GRAIN_MAX_SEMIS + 2];  // 2^(k/12) for k = -24..25
+static bool g_semisReady = false;
+
+// Counters for printGranular
+static uint32_t g_spawned = 0, g_dropped = 0;
+static int g_peakActive = 0;
+
+const char* getGrainSourceName(GrainSource s) {
+  switch (s) {
+    case GrainSource::SINE:     return "sine";
+    case GrainSource::SUPERSAW: return "supersaw buffer";
+    case GrainSource::PINK:     return "pink buffer";
+    default:                    return "?";
+  }
+}
+
+bool attachGranular() {
+  g_active = 0;
+  g_nextOnset = 0.0f;
+  g_bufSource = -1;
+  if (g_buf) return true;
+  g_buf = (int16_t*)arenaAlloc(GRAIN_BUF_LEN * sizeof(int16_t), "grain buffer");
+  return g_buf != nullptr;
+}
+
+void releaseGranular() {
+  g_buf = nullptr;
+  g_active = 0;
+}
+
+static inline float uniform01(uint32_t& rng) {
+  return (float)((noiseRand(rng) >> 8) + 1u) * (1.0f / 16777216.0f);  // (0, 1]
+}
+
+// 2^(semitones / 12) for |semitones| <= 24, interpolated between whole semitones
+static float semitoneRatio(float semis) {
+  if (!g_semisReady) {
+    for (int k = 0; k < 2 * GRAIN_MAX_SEMIS + 2; ++k) g_semis[k] = powf(2.0f, (float)(k - GRAIN_MAX_SEMIS) / 12.0f);
+    g_semisReady = true;
+  }
+  const float x = semis + (float)GRAIN_MAX_SEMIS;
+  const int i = (int)x;
+  return g_semis[i] + (x - (float)i) * (g_semis[i + 1] - g_semis[i]);
+}
+
+static void spawnGrain(int offset, bool fromBuffer, float sizeSamples, float spread, float pitch) {
+  if (g_active >= GRAIN_MAX) {
+    g_dropped++;
+    return;
+  }
+  Grain& g = g_pool[g_active++];
+  const float len = sizeSamples * (0.75f + 0.5f * uniform01(g_rng));
+  const float ratio = semitoneRatio(spread * (2.0f * uniform01(g_rng) - 1.0f));
+  g.left = len < 2.0f ? 2 : (int)len;
+  g.winPos = 0;
+  g.winInc = (uint32_t)(4294967296.0 / (double)g.left);
+  if (fromBuffer) {
+    g.pos = noiseRand(g_rng);
+    g.inc = (uint32_t)(pitch / GRAIN_REF_HZ * ratio * 1048576.0f);
+  } else {
+    g.pos = 0;
+    g.inc = (uint32_t)(pitch * ratio * (4294967296.0f / (float)SAMPLE_RATE_HZ));
+  }
+  g.amp = 0.5f + 0.5f * uniform01(g_rng);
+  g.skip = offset;
+  g.fromBuffer = fromBuffer;
+  g_spawned++;
+  if (g_active > g_peakActive) g_peakActive = g_active;
+}
+
+// Fill part of the capture buffer from the chosen generator each block
+static void captureStep(GrainSource src) {
+  if ((int)src != g_bufSource) {
+    g_bufSource = (int)src;
+    g_bufFill = 0;
+  }
+  if (g_bufFill >= GRAIN_BUF_LEN) return;
+  const NoiseType from = src == GrainSource::PINK ? NoiseType::NOISE_PINK : NoiseType::TONE_SUPERSAW;
+  const int end = g_bufFill + GRAIN_CAPTURE_PER_BLOCK < GRAIN_BUF_LEN ? g_bufFill + GRAIN_CAPTURE_PER_BLOCK : GRAIN_BUF_LEN;
+  for (int i = g_bufFill; i < end; ++i) g_buf[i] = nextSourceSampleS16(from);
+  g_bufFill = end;
+  if (g_bufFill < GRAIN_BUF_LEN) return;
+
+  // Complete: remove the offset (0.37 s of pink noise carries a lot of it, and every grain
+  // would turn it into a thump) and normalise the peak, like the oscillator's
+  float sum = 0.0f;
+  for (int i = 0; i < GRAIN_BUF_LEN; ++i) sum += (float)g_buf[i];
+  const float mean = sum / (float)GRAIN_BUF_LEN;
+  float peak = 1.0f;
+  for (int i = 0; i < GRAIN_BUF_LEN; ++i) {
+    const float d = fabsf((float)g_buf[i] - mean);
+    if (d > peak) peak = d;
+  }
+  const float scale = 32000.0f / peak;
+  for (int i = 0; i < GRAIN_BUF_LEN; ++i) g_buf[i] = clampS16((int32_t)(((float)g_buf[i] - mean) * scale));
+}
+
+void renderGranular(int16_t* out, int n) {
+  const float* sine = g_sineLut;
+  const float* win = g_grainWindowLut;
+  if (!sine || !win) {  // arena full: stay silent
+    for (int i = 0; i < n; ++i) out[i] = 0;
+    return;
+  }
+  const float density = paramValue(ParamId::GRAIN_DENSITY);
+  const float sizeSamples = paramValue(ParamId::GRAIN_SIZE) * 0.001f * (float)SAMPLE_RATE_HZ;
+  const float spread = paramValue(ParamId::GRAIN_SPREAD);
+  const float pitch = paramValue(ParamId::GRAIN_PITCH);
+  int src = (int)paramValue(ParamId::GRAIN_SOURCE);
+  if (src < 0 || src >= (int)GrainSource::COUNT) src = 0;
+
+  bool fromBuffer = false;
+  if (src != (int)GrainSource::SINE && g_buf) {
+    captureStep((GrainSource)src);
+    fromBuffer = g_bufFill >= GRAIN_BUF_LEN;  // oscillator grains until the buffer is full
+  }
+
+  // Onsets in this block; each draws the gap to the next
+  const float meanGap = (float)SAMPLE_RATE_HZ / density;
+  while (g_nextOnset < (float)n) {
+    spawnGrain(g_nextOnset > 0.0f ? (int)g_nextOnset : 0, fromBuffer, sizeSamples, spread, pitch);
+    g_nextOnset += -logf(uniform01(g_rng)) * meanGap;
+  }
+  g_nextOnset -= (float)n;
+
+  float acc[AUDIO_BLOCK_SIZE];
+  for (int i = 0; i < n; ++i) acc[i] = 0.0f;
+  for (int k = g_active - 1; k >= 0; --k) {
+    Grain& g = g_pool[k];
+    const int start = g.skip;
+    const int run = n - start < g.left ? n - start : g.left;
+    uint32_t wp = g.winPos, p = g.pos;
+    const uint32_t wi = g.winInc, pi = g.inc;
+    const float amp = g.amp;
+    if (g.fromBuffer) {
+      const int16_t* buf = g_buf;
+      for (int i = start; i < start + run; ++i) {
+        const uint32_t j = p >> 20;
+        const float frac = (float)((p >> 4) & 0xFFFFu) * (1.0f / 65536.0f);
+        const float s0 = (float)buf[j], s1 = (float)buf[(j + 1) & (GRAIN_BUF_LEN - 1)];
+        acc[i] += amp * lutGrainWindow(win, wp) * (s0 + frac * (s1 - s0)) * (1.0f / 32768.0f);
+        p += pi;
+        wp += wi;
+      }
+    } else {
+      for (int i = start; i < start + run; ++i) {
+        acc[i] += amp * lutGrainWindow(win, wp) * lutSinU32(sine, p);
+        p += pi;
+        wp += wi;
+      }
+    }
+    g.winPos = wp;
+    g.pos = p;
+    g.skip = 0;
+    g.left -= run;
+    if (g.left <= 0) g = g_pool[--g_active];  // keep the pool dense
+  }
+
+  // Overlapping grains add like random phases: scale by the expected overlap (which the
+  // pool caps at GRAIN_MAX)
+  float overlap = density * sizeSamples / (float)SAMPLE_RATE_HZ;
+  if (overlap > (float)GRAIN_MAX) overlap = (float)GRAIN_MAX;
+  const float gain = 0.45f / sqrtf(1.0f + 0.375f * overlap) * 32767.0f;
+  for (int i = 0; i < n; ++i) out[i] = clampS16((int32_t)(acc[i] * gain));
+}
+
+void printGranular() {
+  int src = (int)getParam(ParamId::GRAIN_SOURCE);
+  if (src < 0 || src >= (int)GrainSource::COUNT) src = 0;
+  Serial.printf("Granular: %s, %.1f onsets/s, %.0f ms grains, +-%.1f semitones around %.0f Hz\n",
+    getGrainSourceName((GrainSource)src), getParam(ParamId::GRAIN_DENSITY), getParam(ParamId::GRAIN_SIZE),
+    getParam(ParamId::GRAIN_SPREAD), getParam(ParamId::GRAIN_PITCH));
+  Serial.printf("  pool %d/%d active, peak %d; %u grains started, %u dropped (pool full)\n",
+    g_active, GRAIN_MAX, g_peakActive, (unsigned)g_spawned, (unsigned)g_dropped);
+  if (src != (int)GrainSource::SINE) {
+    if (g_buf) Serial.printf("  buffer %d/%d samples captured\n", g_bufFill, GRAIN_BUF_LEN);
+    else Serial.println("  no buffer (arena full or track not selected): oscillator grains");
+  }
+  g_peakActive = g_active;
+  g_spawned = 0;
+  g_dropped = 0;
+}
@@ -0,0 +1,55 @@
+#include "loop_cache.h"
+#include "audio_synthesis.h"
+#include "config.h"
+#include "dsp_arena.h"
+
+static int16_t* g_loop = nullptr;  // one period, taken from the DSP arena
+static int g_loopLen = 0;
+static int g_loopPos = 0;
+static const int VERIFY_SAMPLES = 16;
+
+bool prepareLoopCache(NoiseType t) {
+  g_loopLen = 0;
+  int period = getLoopPeriodForType(t);
+  if (period <= 0 || period > LOOP_CACHE_MAX_SAMPLES) return false;
+  g_loop = (int16_t*)arenaAlloc((uint32_t)period * sizeof(int16_t), "loop cache");
+  if (!g_loop) return false;  // no room: synthesise live
+
+  for (int i = 0; i < period; ++i) g_loop[i] = nextSourceSampleS16(t);
+  // The declared period must hold exactly: the following samples have to restart the cycle.
+  int check = period < VERIFY_SAMPLES ? period : VERIFY_SAMPLES;
+  for (int i = 0; i < check; ++i) {
+    if (nextSourceSampleS16(t) != g_loop[i]) {
+      g_loop = nullptr;
+      return false;
+    }
+  }
+
+  g_loopLen = period;
+  g_loopPos = check % period;  // the check consumed the start of the next cycle
+  return true;
+}
+
+void renderLoopCache(int16_t* out, int n) {
+  int pos = g_loopPos;
+  const int len = g_loopLen;
+  while (n > 0) {
+    int run = len - pos;
+    if (run > n) run = n;
+    for (int i = 0; i < run; ++i) out[i] = g_loop[pos + i];
+    out += run;
+    n -= run;
+    pos += run;
+    if (pos >= len) pos = 0;
+  }
+  g_loopPos = pos;
+}
+
+void releaseLoopCache() {
+  g_loop = nullptr;
+  g_loopLen = 0;
+}
+
+int getLoopCachePeriod() {
+  return g_loopLen;
+}
@@ -0,0 +1,93 @@
+#include "lut.h"
+#include "dsp_arena.h"
+#include <Arduino.h>
+#include <math.h>
+
+// Tables live in the DSP arena and are rebuilt after each track switch that needs them
+float* g_sineLut = nullptr;
+float* g_shepardLut = nullptr;
+float* g_grainWindowLut = nullptr;
+
+static uint32_t g_lutBytes = 0;
+static uint32_t g_lutBuildUs = 0;
+
+void ensureSineLut() {
+  if (g_sineLut) return;
+  const uint32_t bytes = (SINE_LUT_SIZE + 1) * sizeof(float);
+  float* lut = (float*)arenaAlloc(bytes, "sine lut");
+  if (!lut) return;
+  uint32_t t0 = micros();
+  for (int i = 0; i <= SINE_LUT_SIZE; ++i) {
+    lut[i] = sinf(TAU_F * (float)i / (float)SINE_LUT_SIZE);
+  }
+  g_sineLut = lut;
+  g_lutBytes += bytes;
+  g_lutBuildUs += micros() - t0;
+}
+
+void ensureShepardLut() {
+  if (g_shepardLut) return;
+  const uint32_t bytes = (SHEPARD_LUT_SIZE + 1) * sizeof(float);
+  float* lut = (float*)arenaAlloc(bytes, "shepard lut");
+  if (!lut) return;
+  uint32_t t0 = micros();
+  const float sigma = 0.55f;  // octaves
+  for (int i = 0; i <= SHEPARD_LUT_SIZE; ++i) {
+    float o = (float)i * SHEPARD_LUT_OCTAVES / (float)SHEPARD_LUT_SIZE - 0.5f * SHEPARD_LUT_OCTAVES;
+    lut[i] = expf(-0.5f * (o * o) / (sigma * sigma));
+  }
+  g_shepardLut = lut;
+  g_lutBytes += bytes;
+  g_lutBuildUs += micros() - t0;
+}
+
+void ensureGrainWindowLut() {
+  if (g_grainWindowLut) return;
+  const uint32_t bytes = (GRAIN_WINDOW_LUT_SIZE + 1) * sizeof(float);
+  float* lut = (float*)arenaAlloc(bytes, "grain window");
+  if (!lut) return;
+  uint32_t t0 = micros();
+  for (int i = 0; i <= GRAIN_WINDOW_LUT_SIZE; ++i) {
+    lut[i] = 0.5f - 0.5f * cosf(TAU_F * (float)i / (float)GRAIN_WINDOW_LUT_SIZE);
+  }
+  g_grainWindowLut = lut;
+  g_lutBytes += bytes;
+  g_lutBuildUs += micros() - t0;
+}
+
+void prepareLutsForType(NoiseType t) {
+  switch (t) {
+    case NoiseType::TONE_SHEPARD:
+    case NoiseType::TONE_SHEPARD_DOWN:
+      ensureSineLut();
+      ensureShepardLut();
+      break;
+    case NoiseType::TONE_FM_BELL:
+    case NoiseType::TONE_FM_METAL:
+    case NoiseType::TONE_VOICES:
+      ensureSineLut();
+      break;
+    case NoiseType::TONE_GRANULAR:
+      ensureSineLut();
+      ensureGrainWindowLut();
+      break;
+    default:
+      break;
+  }
+}
+
+void releaseLuts() {
+  g_sineLut = nullptr;
+  g_shepardLut = nullptr;
+  g_grainWindowLut = nullptr;
+  g_lutBytes = 0;
+  g_lutBuildUs = 0;
+}
+
+uint32_t getLutBytes() {
+  return g_lutBytes;
+}
+
+uint32_t getLutBuildUs() {
+  return g_lutBuildUs;
+}
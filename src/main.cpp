@@ -3,8 +3,15 @@
 #include "config.h"
 #include "types.h"
 #include "audio_synthesis.h"
+#include "audio_master.h"
 #include "visual_rendering.h"
 #include "audio_extras.h"
+#include "app.h"
+#include "serial_commands.h"
+#include "cpu_load.h"
+#include "boot_profile.h"
+#include "diagnostics.h"
+#include "profiling.h"
 #include "driver/dac.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -27,6 +34,26 @@ uint32_t lastVolStepMs = 0;
 // Frame timing
 uint32_t lastFrameMs = 0;
 
+/* Diagnostics page (A+C chord) */
+bool diagPage = false;
+bool chordHeld = false;   // A+C chord in progress: suppress A/C single-button actions
+uint32_t lastDiagMs = 0;
+
+// Profiling report timing
+uint32_t lastProfileMs = 0;
+
+// The UI loop sleeps on a task notification; button edges and timeouts wake it
+TaskHandle_t uiTaskHandle = nullptr;
+
+static void IRAM_ATTR onButtonEdge() {
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(uiTaskHandle, &woken);
+  if (woken) portYIELD_FROM_ISR();
+}
+
+// Extra per-frame CPU time for pipeline stress tests (Serial "load <ms>")
+uint32_t syntheticLoadMs = 0;
+
 // UI Functions
 void render() {
   M5.Lcd.fillScreen(TFT_BLACK);
@@ -49,27 +76,41 @@ void render() {
   M5.Lcd.setTextColor(TFT_WHITE, TFT_BLACK);
   M5.Lcd.setTextSize(1);
   M5.Lcd.setCursor(10, M5.Lcd.height() - 18);
-  M5.Lcd.print("A=Prev (noise)   B=Play/Pause   C=Next (noise)");
+  M5.Lcd.print("A=Prev  B=Play/Pause  C=Next  A+C=Diagnostics");
 
   needsRedraw = false;
 }
 
-void nextTrack() {
-  currentTrack = (currentTrack + 1) % TRACK_COUNT;
+void selectTrack(int index) {
+  currentTrack = ((index % TRACK_COUNT) + TRACK_COUNT) % TRACK_COUNT;
   setAudioNoiseType(getCurrentNoiseType(currentTrack));
   randomizeGraphColor();
   needsRedraw = true;
 }
 
-void prevTrack() {
-  currentTrack = (currentTrack - 1 + TRACK_COUNT) % TRACK_COUNT;
-  setAudioNoiseType(getCurrentNoiseType(currentTrack));
-  randomizeGraphColor();
+int getCurrentTrack() {
+  return currentTrack;
+}
+
+void requestRedraw() {
   needsRedraw = true;
 }
 
+void nextTrack() {
+  selectTrack(currentTrack + 1);
+}
+
+void prevTrack() {
+  selectTrack(currentTrack - 1);
+}
+
 void togglePlay() {
   isPlaying = !isPlaying;
+  if (isPlaying) {
+    notePlayRequested();
+    setCpuFrequencyMhz(CPU_MHZ_PLAYING);
+    cpuLoadReset();
+  }
   setAudioRunning(isPlaying);
   
   if (isPlaying) {
@@ -88,14 +129,31 @@ void togglePlay() {
     }
     dac_output_disable(DAC_CHANNEL_1);
     pinMode(AUDIO_DAC_PIN, INPUT); // high-Z when not playing
+    setCpuFrequencyMhz(CPU_MHZ_IDLE);
+    cpuLoadReset();
   }
   needsRedraw = true;
 }
 
+void setPlaying(bool on) {
+  if (on != isPlaying) togglePlay();
+}
+
+bool getPlaying() {
+  return isPlaying;
+}
+
+void setSyntheticLoadMs(uint32_t ms) {
+  syntheticLoadMs = ms;
+}
+
 // Arduino setup
 void setup() {
+  bootMark("setup entry");
   M5.begin(true, false, true, true); // LCD on, SD off, Serial on, I2C on
+  bootMark("M5.begin");
   M5.Power.begin();
+  bootMark("M5.Power.begin");
 
   Serial.begin(115200);
   Serial.println("M5Stack Noise Player starting...");
@@ -104,32 +162,68 @@ void setup() {
   // LCD setup
   M5.Lcd.setRotation(1);
   M5.Lcd.setBrightness(120);
+  bootMark("LCD setup");
+
+  // Wake loop() on any button edge or Serial input instead of polling
+  uiTaskHandle = xTaskGetCurrentTaskHandle();
+  initSerialCommands(uiTaskHandle);
+  attachInterrupt(digitalPinToInterrupt(BUTTON_A_PIN), onButtonEdge, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(BUTTON_B_PIN), onButtonEdge, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(BUTTON_C_PIN), onButtonEdge, CHANGE);
 
-  // Initialize state
+  // Initialize state (lookup tables are built later, on first use of a track)
   initAudioState();
+  bootMark("initAudioState");
   initVisualState();
+  bootMark("initVisualState");
   initAudioExtras();
+  bootMark("initAudioExtras");
 
   // DAC idle: disable to avoid startup hum
   dac_output_disable(DAC_CHANNEL_1);
   pinMode(AUDIO_DAC_PIN, INPUT); // high-Z when not playing
 
-  // Start audio task on core 1
-  xTaskCreatePinnedToCore(audioTask, "audioTask", 4096, nullptr, 1, nullptr, 1);
+  // Start audio output on core 1 and the render worker on core 0
+  TaskHandle_t audioHandle = nullptr, renderHandle = nullptr;
+  xTaskCreatePinnedToCore(audioTask, "audioTask", AUDIO_TASK_STACK_BYTES, nullptr, 1, &audioHandle, 1);
+  xTaskCreatePinnedToCore(renderTask, "renderTask", RENDER_TASK_STACK_BYTES, nullptr, 1, &renderHandle, 0);
+  initDiagnostics(audioHandle, renderHandle, uiTaskHandle);
 
   // Set initial noise type
   setAudioNoiseType(getCurrentNoiseType(currentTrack));
   randomizeGraphColor();
   lastFrameMs = millis();
   needsRedraw = true;
+  bootMark("tasks started");
+  printBootProfile();
+
+  // Nothing plays until B is pressed: idle at the low clock
+  setCpuFrequencyMhz(CPU_MHZ_IDLE);
+  cpuLoadReset();
 }
 
 // Arduino loop
 void loop() {
+  uint32_t busyStart = cycleNow();
   M5.update();
+  pollSerialCommands();
+  reportFirstSample();
+
+  // A+C together: toggle the diagnostics page. Both releases are swallowed.
+  if (M5.BtnA.isPressed() && M5.BtnC.isPressed() && !chordHeld) {
+    chordHeld = true;
+    diagPage = !diagPage;
+    lastDiagMs = 0;
+    needsRedraw = true;
+    Serial.printf("Diagnostics page %s\n", diagPage ? "ON" : "OFF");
+  }
+  if (chordHeld) {
+    volHoldA = volHoldC = true;
+    if (!M5.BtnA.isPressed() && !M5.BtnC.isPressed()) chordHeld = false;
+  }
 
   // Button A: hold to decrease volume, short release = previous track
-  if (M5.BtnA.pressedFor(300)) {
+  if (M5.BtnA.pressedFor(300) && !chordHeld) {
     volHoldA = true;
     uint32_t nowMs = millis();
     if (nowMs - lastVolStepMs >= 120) {
@@ -166,7 +260,7 @@ void loop() {
   }
 
   // Button C: hold to increase volume, short release = next track
-  if (M5.BtnC.pressedFor(300)) {
+  if (M5.BtnC.pressedFor(300) && !chordHeld) {
     volHoldC = true;
     uint32_t nowMs = millis();
     if (nowMs - lastVolStepMs >= 120) {
@@ -191,11 +285,25 @@ void loop() {
     render();
   }
 
-  // Animate noise frames
+  // Animate noise frames (or refresh the diagnostics page in their place)
   uint32_t now = millis();
-  if (isPlaying) {
+  if (diagPage) {
+    if (lastDiagMs == 0 || now - lastDiagMs >= DIAG_REFRESH_MS) {
+      DiagSnapshot d;
+      collectDiagnostics(d, DiagReader::PAGE);
+      drawDiagnosticsPage(d);
+      lastDiagMs = now;
+    }
+    needsRedraw = false;
+  } else if (isPlaying) {
     if (now - lastFrameMs >= FRAME_INTERVAL_MS) {
+      uint32_t drawStart = micros();
       drawNoiseFrame(getCurrentNoiseType(currentTrack));
+      if (syntheticLoadMs) {
+        uint32_t t0 = millis();
+        while (millis() - t0 < syntheticLoadMs) { }
+      }
+      diagNoteFrame(micros() - drawStart);
       lastFrameMs = now;
     }
   } else {
@@ -206,7 +314,6 @@ void loop() {
       lastTrackShown = currentTrack;
       needsRedraw = false;
     }
-    vTaskDelay(pdMS_TO_TICKS(10));
   }
 
   // Shuffle mode timer
@@ -215,16 +322,34 @@ void loop() {
       int prev = currentTrack;
       int next = random(0, TRACK_COUNT);
       if (next == prev) next = (next + 1) % TRACK_COUNT;
-      currentTrack = next;
-      setAudioNoiseType(getCurrentNoiseType(currentTrack));
-      randomizeGraphColor();
-      needsRedraw = true;
+      selectTrack(next);
       lastShuffleChangeMs = now;
       Serial.printf("Shuffle -> Track %d (%s)\n", currentTrack + 1, 
         getNoiseTypeName(getCurrentNoiseType(currentTrack)));
     }
   }
 
-  // Small yield
-  delay(1);
+  // Periodic audio cost report
+  if (isPlaying && AUDIO_PROFILE_INTERVAL_MS > 0 && now - lastProfileMs >= AUDIO_PROFILE_INTERVAL_MS) {
+    printAudioProfile();
+    printCpuDuty(getNoiseTypeName(getCurrentNoiseType(currentTrack)));
+    lastProfileMs = now;
+  }
+  pollTelemetry();
+
+  // Sleep until a button edge, Serial input or the next thing that is due (frame, shuffle)
+  uint32_t waitMs = UI_IDLE_POLL_MS;
+  if (M5.BtnA.isPressed() || M5.BtnB.isPressed() || M5.BtnC.isPressed()) waitMs = UI_BUTTON_POLL_MS;
+  now = millis();
+  if (diagPage) {
+    uint32_t sinceDiag = now - lastDiagMs;
+    uint32_t toDiag = sinceDiag >= DIAG_REFRESH_MS ? 0 : DIAG_REFRESH_MS - sinceDiag;
+    if (toDiag < waitMs) waitMs = toDiag;
+  } else if (isPlaying) {
+    uint32_t sinceFrame = now - lastFrameMs;
+    uint32_t toFrame = sinceFrame >= FRAME_INTERVAL_MS ? 0 : FRAME_INTERVAL_MS - sinceFrame;
+    if (toFrame < waitMs) waitMs = toFrame;
+  }
+  cpuLoadAdd(LoadSource::UI, cycleNow() - busyStart);
+  if (waitMs > 0) ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs));
 }
@@ -0,0 +1,245 @@
+#include "modal_bank.h"
+#include "audio_synthesis.h"  // clampS16
+#include "colored_noise.h"    // noiseRand
+#include "config.h"
+#include "params.h"
+#include <Arduino.h>
+#include <math.h>
+
+static const float MODAL_QUIET = 1e-5f;  // below this a mode is silent and skipped
+
+void modalInit(ModalBank& m) {
+  m.count = 0;
+  for (int i = 0; i < MODAL_MAX; ++i) {
+    m.a1[i] = m.a2[i] = m.b[i] = 0.0f;
+    m.y1[i] = m.y2[i] = 0.0f;
+    m.hz[i] = m.t60[i] = 0.0f;
+  }
+  m.impulse = 0.0f;
+  m.burstLeft = 0;
+  m.burstLevel = 0.0f;
+  m.rng = 0x3C6EF372u;
+}
+
+void modalSetMode(ModalBank& m, int i, float hz, float t60Sec, float gain) {
+  if (i < 0 || i >= MODAL_MAX) return;
+  if (i >= m.count) m.count = i + 1;
+  m.hz[i] = hz;
+  m.t60[i] = t60Sec;
+  if (hz <= 0.0f || hz >= 0.45f * (float)SAMPLE_RATE_HZ || t60Sec <= 0.0f) {
+    m.a1[i] = m.a2[i] = m.b[i] = 0.0f;
+    return;
+  }
+  const float w = TAU_F * hz / (float)SAMPLE_RATE_HZ;
+  const float r = expf(-6.9078f / (t60Sec * (float)SAMPLE_RATE_HZ));  // -60 dB after t60
+  m.a1[i] = 2.0f * r * cosf(w);
+  m.a2[i] = -r * r;
+  // The impulse response is r^n sin((n+1)w) / sin(w): scaling the input by sin(w) gives
+  // every mode a peak of `gain`, whatever its frequency
+  m.b[i] = gain * sinf(w);
+}
+
+/* === Presets === */
+
+struct ModeSpec {
+  float ratio, t60, gain;
+};
+
+static const ModeSpec kDrumModes[] = {
+  {1.000f, 0.80f, 1.00f}, {1.594f, 0.55f, 0.70f}, {2.136f, 0.45f, 0.55f}, {2.296f, 0.40f, 0.45f},
+  {2.653f, 0.35f, 0.40f}, {2.918f, 0.30f, 0.35f}, {3.156f, 0.28f, 0.30f}, {3.501f, 0.25f, 0.25f},
+  {3.600f, 0.22f, 0.20f}, {4.060f, 0.20f, 0.18f},
+};
+
+static const ModeSpec kBellModes[] = {
+  {0.500f, 6.0f, 0.55f}, {1.000f, 5.0f, 0.80f}, {1.183f, 4.5f, 0.70f}, {1.506f, 4.0f, 0.40f},
+  {2.000f, 3.5f, 1.00f}, {2.514f, 2.5f, 0.50f}, {2.662f, 2.2f, 0.40f}, {3.011f, 2.0f, 0.35f},
+  {4.166f, 1.4f, 0.30f}, {5.433f, 1.0f, 0.20f}, {6.796f, 0.8f, 0.15f},
+};
+
+static const ModeSpec kBarModes[] = {
+  {1.000f, 1.60f, 1.00f}, {2.756f, 0.95f, 0.50f}, {5.404f, 0.60f, 0.30f}, {8.933f, 0.45f, 0.18f},
+  {13.345f, 0.35f, 0.10f},
+};
+
+// Plate modes f_mn ~ (m/a)^2 + (n/b)^2 with aspect b/a = 1.37, struck at (0.31, 0.43): each
+// mode's gain is its shape at the strike point. Built once, sorted; the lowest MODAL_MAX are used.
+static const int PLATE_MN = 8;
+static ModeSpec g_plateModes[PLATE_MN * PLATE_MN];
+static bool g_plateBuilt = false;
+
+static void buildPlateModes() {
+  const float aspect = 1.37f, sx = 0.31f, sy = 0.43f;
+  const float base = 1.0f + 1.0f / (aspect * aspect);
+  int count = 0;
+  for (int mm = 1; mm <= PLATE_MN; ++mm) {
+    for (int nn = 1; nn <= PLATE_MN; ++nn) {
+      const float ratio = ((float)(mm * mm) + (float)(nn * nn) / (aspect * aspect)) / base;
+      const float gain = fabsf(sinf(0.5f * TAU_F * mm * sx) * sinf(0.5f * TAU_F * nn * sy)) / sqrtf(ratio);
+      ModeSpec s = {ratio, 2.4f / sqrtf(ratio), gain};
+      int j = count++;
+      while (j > 0 && g_plateModes[j - 1].ratio > ratio) { g_plateModes[j] = g_plateModes[j - 1]; --j; }
+      g_plateModes[j] = s;
+    }
+  }
+  g_plateBuilt = true;
+}
+
+int modalLoadPreset(ModalBank& m, ModalPreset p, float fundamentalHz) {
+  const ModeSpec* modes = kDrumModes;
+  int count = (int)(sizeof(kDrumModes) / sizeof(kDrumModes[0]));
+  switch (p) {
+    case ModalPreset::BELL:
+      modes = kBellModes;
+      count = (int)(sizeof(kBellModes) / sizeof(kBellModes[0]));
+      break;
+    case ModalPreset::BAR:
+      modes = kBarModes;
+      count = (int)(sizeof(kBarModes) / sizeof(kBarModes[0]));
+      break;
+    case ModalPreset::PLATE:
+      if (!g_plateBuilt) buildPlateModes();
+      modes = g_plateModes;
+      count = MODAL_MAX;
+      break;
+    default:
+      break;
+  }
+  // Normalise by the summed gains: a unit impulse can never push the sum past 1
+  float sum = 0.0f;
+  for (int i = 0; i < count; ++i) sum += modes[i].gain;
+  const float norm = 1.0f / sum;
+  m.count = 0;
+  for (int i = 0; i < count; ++i) {
+    modalSetMode(m, i, fundamentalHz * modes[i].ratio, modes[i].t60, modes[i].gain * norm);
+  }
+  for (int i = count; i < MODAL_MAX; ++i) m.y1[i] = m.y2[i] = 0.0f;
+  return count;
+}
+
+const char* getModalPresetName(ModalPreset p) {
+  switch (p) {
+    case ModalPreset::DRUM:  return "drum";
+    case ModalPreset::BELL:  return "bell";
+    case ModalPreset::BAR:   return "bar";
+    case ModalPreset::PLATE: return "plate";
+    default:                 return "?";
+  }
+}
+
+/* === Excitation and rendering === */
+
+void modalStrike(ModalBank& m, float velocity) {
+  m.impulse += velocity;
+}
+
+void modalBurst(ModalBank& m, float velocity, int samples) {
+  if (samples < 1) samples = 1;
+  m.burstLeft = samples;
+  m.burstLevel = velocity / sqrtf((float)samples);  // similar energy for any length
+}
+
+void modalRender(ModalBank& m, float* acc, int n) {
+  // Shared excitation for this block; most blocks have none
+  float x[AUDIO_BLOCK_SIZE];
+  bool excited = m.impulse != 0.0f || m.burstLeft > 0;
+  if (excited) {
+    for (int i = 0; i < n; ++i) x[i] = 0.0f;
+    x[0] = m.impulse;
+    m.impulse = 0.0f;
+    uint32_t rng = m.rng;
+    const int burst = m.burstLeft < n ? m.burstLeft : n;
+    for (int i = 0; i < burst; ++i) {
+      x[i] += m.burstLevel * ((float)((int32_t)(noiseRand(rng) >> 16) - 32768) * (1.0f / 32768.0f));
+    }
+    m.burstLeft -= burst;
+    m.rng = rng;
+  }
+
+  for (int k = 0; k < m.count; ++k) {
+    float y1 = m.y1[k], y2 = m.y2[k];
+    const float a1 = m.a1[k], a2 = m.a2[k];
+    if (excited) {
+      const float b = m.b[k];
+      for (int i = 0; i < n; ++i) {
+        const float y = a1 * y1 + a2 * y2 + b * x[i];
+        y2 = y1;
+        y1 = y;
+        acc[i] += y;
+      }
+    } else {
+      if (fabsf(y1) + fabsf(y2) < MODAL_QUIET) continue;
+      for (int i = 0; i < n; ++i) {
+        const float y = a1 * y1 + a2 * y2;
+        y2 = y1;
+        y1 = y;
+        acc[i] += y;
+      }
+      if (fabsf(y1) + fabsf(y2) < MODAL_QUIET) y1 = y2 = 0.0f;  // no denormal tails
+    }
+    m.y1[k] = y1;
+    m.y2[k] = y2;
+  }
+}
+
+/* === Modal Drum track === */
+
+static ModalBank g_track;
+static int g_trackPreset = -1;
+static float g_trackPitch = 0.0f;
+static int g_toStrike = 0;
+static uint32_t g_strikeRng = 0x9E3779B9u;
+
+// How each preset is struck: seconds between strikes (so it can ring out), impulse level and
+// a noise burst for the stick. Levels peak at roughly -3 dBFS from 40 Hz to 1 kHz.
+struct StrikeSpec {
+  float interval, impulse, burst;
+  int burstSamples;
+};
+
+static const StrikeSpec kStrikes[(int)ModalPreset::COUNT] = {
+  {0.8f, 0.9f, 0.6f, 40},  // DRUM
+  {3.0f, 1.2f, 0.0f, 0},   // BELL
+  {0.9f, 0.9f, 0.2f, 8},   // BAR
+  {2.5f, 1.4f, 0.0f, 0},   // PLATE
+};
+
+void renderModalTrack(int16_t* out, int n) {
+  int preset = (int)paramValue(ParamId::MODAL_PRESET);
+  if (preset < 0 || preset >= (int)ModalPreset::COUNT) preset = 0;
+  const float pitch = paramValue(ParamId::MODAL_PITCH);
+  if (preset != g_trackPreset || pitch != g_trackPitch) {
+    // Coefficients only change here (STEP parameters), never per sample
+    if (g_trackPreset < 0) modalInit(g_track);
+    modalLoadPreset(g_track, (ModalPreset)preset, pitch);
+    g_trackPreset = preset;
+    g_trackPitch = pitch;
+  }
+  if (g_toStrike <= 0) {
+    // Slightly varied velocity so repeats do not sound identical
+    const StrikeSpec& st = kStrikes[g_trackPreset];
+    const float vel = 0.8f + 0.2f * (float)(noiseRand(g_strikeRng) >> 24) / 255.0f;
+    modalStrike(g_track, st.impulse * vel);
+    if (st.burstSamples > 0) modalBurst(g_track, st.burst * vel, st.burstSamples);
+    g_toStrike = (int)(st.interval * (float)SAMPLE_RATE_HZ);
+  }
+  g_toStrike -= n;
+
+  float acc[AUDIO_BLOCK_SIZE];
+  for (int i = 0; i < n; ++i) acc[i] = 0.0f;
+  modalRender(g_track, acc, n);
+  for (int i = 0; i < n; ++i) out[i] = clampS16((int32_t)(acc[i] * 32767.0f));
+}
+
+void printModalTrack() {
+  if (g_trackPreset < 0) {
+    Serial.println("Modal: not started (select the Modal Drum track)");
+    return;
+  }
+  Serial.printf("Modal: %s at %.1f Hz, %d modes\n", getModalPresetName((ModalPreset)g_trackPreset),
+    g_trackPitch, g_track.count);
+  for (int i = 0; i < g_track.count; ++i) {
+    Serial.printf("  %2d: %7.1f Hz  T60 %.2f s%s\n", i, g_track.hz[i], g_track.t60[i],
+      g_track.b[i] == 0.0f ? "  (muted)" : "");
+  }
+}
@@ -0,0 +1,165 @@
+#include "osc_bank.h"
+#include "audio_synthesis.h"  // clampS16
+#include "colored_noise.h"    // noiseRand
+#include "profiling.h"
+#include "string_bank.h"      // midiNoteToHz
+#include <Arduino.h>
+#include <math.h>
+
+static const float PHASE_PER_HZ = (float)(OSC_PHASE_ONE / SAMPLE_RATE_HZ);  // 256
+
+static inline uint32_t hzToInc(float hz) {
+  if (hz < 0.0f) hz = 0.0f;
+  if (hz > 0.5f * (float)SAMPLE_RATE_HZ) hz = 0.5f * (float)SAMPLE_RATE_HZ;
+  return (uint32_t)(hz * PHASE_PER_HZ + 0.5f);
+}
+
+// sin(2*pi*ph) for ph in [0, 1), without branches or tables so it vectorizes
+static inline float sinCycles(float ph) {
+  const float x = ph - 0.5f;                   // sin(2*pi*ph) = -sin(2*pi*x)
+  const float z = 0.25f - fabsf(fabsf(x) - 0.25f);  // fold |x| onto [0, 1/4]
+  const float w = TAU_F * z, w2 = w * w;
+  const float s = w * (1.0f + w2 * (-1.0f / 6.0f + w2 * (1.0f / 120.0f +
+    w2 * (-1.0f / 5040.0f + w2 * (1.0f / 362880.0f)))));
+  return copysignf(s, -x);
+}
+
+void oscBankInit(OscBank& b, OscWave wave, int count) {
+  if (count < 0) count = 0;
+  if (count > OSC_BANK_MAX) count = OSC_BANK_MAX;
+  b.wave = wave;
+  b.count = count;
+  for (int v = 0; v < OSC_BANK_MAX; ++v) {
+    b.phase[v] = 0;
+    b.inc[v] = 0;
+    b.gain[v] = 0.0f;
+  }
+}
+
+void oscBankSetVoice(OscBank& b, int v, float hz, float gain) {
+  if (v < 0 || v >= b.count) return;
+  b.inc[v] = hzToInc(hz);
+  b.gain[v] = gain;
+}
+
+void oscBankSetFreq(OscBank& b, int v, float hz) {
+  if (v < 0 || v >= b.count) return;
+  b.inc[v] = hzToInc(hz);
+}
+
+void oscBankSetRatios(OscBank& b, float baseHz, const float* ratios) {
+  for (int v = 0; v < b.count; ++v) b.inc[v] = hzToInc(baseHz * ratios[v]);
+}
+
+void oscBankSetHarmonics(OscBank& b, float f0, int firstHarmonic, float level) {
+  for (int v = 0; v < b.count; ++v) {
+    const int h = firstHarmonic + v;
+    b.inc[v] = hzToInc(f0 * (float)h);
+    b.gain[v] = h > 0 ? level / (float)h : 0.0f;
+  }
+}
+
+void oscBankSetChord(OscBank& b, const uint8_t* notes, int count, float gain) {
+  if (count > OSC_BANK_MAX) count = OSC_BANK_MAX;
+  b.count = count;
+  for (int v = 0; v < count; ++v) {
+    b.inc[v] = hzToInc(midiNoteToHz(notes[v]));
+    b.gain[v] = gain;
+  }
+}
+
+void oscBankRandomizePhases(OscBank& b, uint32_t& rng) {
+  for (int v = 0; v < b.count; ++v) b.phase[v] = noiseRand(rng) % OSC_PHASE_ONE;
+}
+
+void oscBankRender(OscBank& b, float* acc, int n) {
+  float ph[AUDIO_BLOCK_SIZE];
+  const float toCycles = 1.0f / (float)OSC_PHASE_ONE;
+  const OscWave wave = b.wave;
+  for (int v = 0; v < b.count; ++v) {
+    // Phase ramp: a cheap integer scan (phases stay below 2^22, exact in a float)
+    uint32_t p = b.phase[v];
+    const uint32_t inc = b.inc[v];
+    for (int i = 0; i < n; ++i) {
+      p += inc;
+      if (p >= OSC_PHASE_ONE) p -= OSC_PHASE_ONE;
+      ph[i] = (float)(int32_t)p * toCycles;
+    }
+    b.phase[v] = p;
+
+    // Waveform: independent per sample
+    const float g = b.gain[v];
+    if (g == 0.0f) continue;
+    switch (wave) {
+      case OscWave::SINE:
+        for (int i = 0; i < n; ++i) acc[i] += g * sinCycles(ph[i]);
+        break;
+      case OscWave::SAW:
+        for (int i = 0; i < n; ++i) acc[i] += g * (2.0f * ph[i] - 1.0f);
+        break;
+      case OscWave::SQUARE:
+        for (int i = 0; i < n; ++i) acc[i] += ph[i] < 0.5f ? g : -g;
+        break;
+    }
+  }
+}
+
+void oscBankRenderS16(OscBank& b, int16_t* out, int n, float scale) {
+  float acc[AUDIO_BLOCK_SIZE];
+  while (n > 0) {
+    const int run = n < AUDIO_BLOCK_SIZE ? n : AUDIO_BLOCK_SIZE;
+    for (int i = 0; i < run; ++i) acc[i] = 0.0f;
+    oscBankRender(b, acc, run);
+    for (int i = 0; i < run; ++i) out[i] = clampS16((int32_t)(acc[i] * scale));
+    out += run;
+    n -= run;
+  }
+}
+
+/* === Benchmark === */
+
+// The pre-bank pattern: per sample, loop over scalar phases and call sinf
+static void renderScalarSines(float* phase, const float* step, int count, float* acc, int n) {
+  for (int i = 0; i < n; ++i) {
+    float sum = 0.0f;
+    for (int v = 0; v < count; ++v) {
+      phase[v] += step[v];
+      if (phase[v] >= TAU_F) phase[v] -= TAU_F;
+      sum += sinf(phase[v]);
+    }
+    acc[i] = sum;
+  }
+}
+
+void benchOscBank() {
+  static OscBank bank;
+  static float scalarPhase[OSC_BANK_MAX], scalarStep[OSC_BANK_MAX];
+  float acc[AUDIO_BLOCK_SIZE];
+  const int BLOCKS = 64;
+  const float budget = (float)ESP.getCpuFreqMHz() * 1000000.0f / (float)SAMPLE_RATE_HZ;
+  Serial.printf("Oscillator bank @%u MHz (budget %.0f cycles/sample), cycles/sample:\n",
+    (unsigned)ESP.getCpuFreqMHz(), budget);
+  Serial.println("  voices    sine     saw  square  | scalar sinf");
+  for (int count = 1; count <= OSC_BANK_MAX; count <<= 1) {
+    float perSample[3];
+    for (int w = 0; w < 3; ++w) {
+      oscBankInit(bank, (OscWave)w, count);
+      for (int v = 0; v < count; ++v) oscBankSetVoice(bank, v, 110.0f * (1.0f + 0.01f * v), 1.0f / count);
+      uint32_t c0 = cycleNow();
+      for (int k = 0; k < BLOCKS; ++k) {
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; ++i) acc[i] = 0.0f;
+        oscBankRender(bank, acc, AUDIO_BLOCK_SIZE);
+      }
+      perSample[w] = (float)(cycleNow() - c0) / (float)(BLOCKS * AUDIO_BLOCK_SIZE);
+    }
+    for (int v = 0; v < count; ++v) {
+      scalarPhase[v] = 0.0f;
+      scalarStep[v] = TAU_F * 110.0f * (1.0f + 0.01f * v) / (float)SAMPLE_RATE_HZ;
+    }
+    uint32_t c0 = cycleNow();
+    for (int k = 0; k < BLOCKS; ++k) renderScalarSines(scalarPhase, scalarStep, count, acc, AUDIO_BLOCK_SIZE);
+    const float scalar = (float)(cycleNow() - c0) / (float)(BLOCKS * AUDIO_BLOCK_SIZE);
+    Serial.printf("  %6d  %6.1f  %6.1f  %6.1f  | %7.1f   (sine %.1f/voice, %4.1f%% of budget)\n", count,
+      perSample[0], perSample[1], perSample[2], scalar, perSample[0] / count, 100.0f * perSample[0] / budget);
+  }
+}
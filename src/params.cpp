@@ -0,0 +1,154 @@
+#include "params.h"
+#include <Arduino.h>
+#include <atomic>
+#include <string.h>
+
+static const ParamInfo kParams[PARAM_COUNT] = {
+  {"tone.freq",       NoiseType::TONE_SINE,          false, ParamKind::FLOAT, 20.0f, 4000.0f, 440.0f},
+  {"am.rate",         NoiseType::TONE_AM_TREMOLO,    false, ParamKind::FLOAT, 0.1f,  40.0f,   5.0f},
+  {"am.depth",        NoiseType::TONE_AM_TREMOLO,    false, ParamKind::FLOAT, 0.0f,  1.0f,    0.8f},
+  {"supersaw.freq",   NoiseType::TONE_SUPERSAW,      false, ParamKind::FLOAT, 20.0f, 1000.0f, 110.0f},
+  {"pwm.freq",        NoiseType::TONE_PWM,           false, ParamKind::FLOAT, 20.0f, 1000.0f, 110.0f},
+  {"pwm.rate",        NoiseType::TONE_PWM,           false, ParamKind::FLOAT, 0.05f, 20.0f,   2.0f},
+  {"iso.carrier",     NoiseType::TONE_ISOCHRONIC,    false, ParamKind::FLOAT, 50.0f, 2000.0f, 440.0f},
+  {"iso.gate",        NoiseType::TONE_ISOCHRONIC,    false, ParamKind::FLOAT, 0.5f,  40.0f,   9.0f},
+  {"combo.f1",        NoiseType::TONE_COMBINATION_TONES, false, ParamKind::FLOAT, 100.0f, 4000.0f, 700.0f},
+  {"combo.f2",        NoiseType::TONE_COMBINATION_TONES, false, ParamKind::FLOAT, 100.0f, 4000.0f, 880.0f},
+  {"combo.drive",     NoiseType::TONE_COMBINATION_TONES, false, ParamKind::FLOAT, 0.5f,   5.0f,    1.8f},
+  {"infra.freq",      NoiseType::TONE_INFRASOUND,    false, ParamKind::FLOAT, 5.0f,  40.0f,   12.0f},
+  {"infra.level",     NoiseType::TONE_INFRASOUND,    false, ParamKind::FLOAT, 0.0f,  1.0f,    0.35f},
+  {"somatic.freq",    NoiseType::TONE_SOMATIC_BASS,  false, ParamKind::FLOAT, 25.0f, 150.0f,  55.0f},
+  {"somatic.period",  NoiseType::TONE_SOMATIC_BASS,  false, ParamKind::STEP,  0.1f,  4.0f,    0.6f},
+  {"howl.center",     NoiseType::TONE_FEEDBACK_HOWL, false, ParamKind::FLOAT, 300.0f, 4500.0f, 2500.0f},
+  {"howl.sweep",      NoiseType::TONE_FEEDBACK_HOWL, false, ParamKind::FLOAT, 0.0f,  2000.0f, 800.0f},
+  {"fmmetal.carrier", NoiseType::TONE_FM_METAL,      false, ParamKind::FLOAT, 20.0f, 2000.0f, 330.0f},
+  {"fmmetal.mod",     NoiseType::TONE_FM_METAL,      false, ParamKind::FLOAT, 20.0f, 3000.0f, 780.0f},
+  {"fmmetal.index",   NoiseType::TONE_FM_METAL,      false, ParamKind::FLOAT, 0.0f,  10.0f,   3.2f},
+  {"pink.method",     NoiseType::NOISE_PINK,         false, ParamKind::STEP,  0.0f,  1.0f,    0.0f},
+  {"tilt.alpha",      NoiseType::NOISE_TILT,         false, ParamKind::STEP,  -2.0f, 2.0f,    0.5f},
+  {"seq.bpm",         NoiseType::RHYTHM_EUCLIDEAN,   true,  ParamKind::FLOAT, 30.0f, 300.0f,  120.0f},
+  {"modal.preset",    NoiseType::TONE_MODAL_DRUM,    false, ParamKind::STEP,  0.0f,  3.0f,    0.0f},
+  {"modal.pitch",     NoiseType::TONE_MODAL_DRUM,    false, ParamKind::STEP,  40.0f, 1000.0f, 180.0f},
+  {"grain.density",   NoiseType::TONE_GRANULAR,      false, ParamKind::FLOAT, 1.0f,  500.0f,  40.0f},
+  {"grain.size",      NoiseType::TONE_GRANULAR,      false, ParamKind::FLOAT, 5.0f,  250.0f,  120.0f},
+  {"grain.spread",    NoiseType::TONE_GRANULAR,      false, ParamKind::FLOAT, 0.0f,  24.0f,   20.0f},
+  {"grain.pitch",     NoiseType::TONE_GRANULAR,      false, ParamKind::FLOAT, 50.0f, 2000.0f, 630.0f},
+  {"grain.source",    NoiseType::TONE_GRANULAR,      false, ParamKind::STEP,  0.0f,  2.0f,    0.0f},
+  {"formant.vowel",   NoiseType::FX_FORMANT,         false, ParamKind::FLOAT, 0.0f,  4.0f,    0.0f},
+  {"formant.rate",    NoiseType::FX_FORMANT,         false, ParamKind::FLOAT, 0.0f,  2.0f,    0.05f},
+  {"chorus.depth",    NoiseType::TONE_CHORUS,        false, ParamKind::FLOAT, 0.0f,  8.0f,    3.0f},
+  {"flanger.feedback", NoiseType::FX_PHASER,         false, ParamKind::FLOAT, -0.9f, 0.9f,    0.6f},
+  {"doppler.speed",   NoiseType::FX_DOPPLER,         false, ParamKind::FLOAT, 5.0f,  80.0f,   40.0f},
+  {"bytebeat.rate",   NoiseType::TONE_BYTEBEAT,      false, ParamKind::STEP,  1000.0f, 11025.0f, 8000.0f},
+  {"voice.steal",     NoiseType::TONE_VOICES,        false, ParamKind::STEP,  0.0f,  1.0f,    0.0f},
+  {"voice.demo",      NoiseType::TONE_VOICES,        false, ParamKind::BOOL,  0.0f,  1.0f,    1.0f},
+  {"reverb.send",     NoiseType::FX_GATED_REVERB,    true,  ParamKind::BOOL,  0.0f,  1.0f,    0.0f},
+  {"reverb.size",     NoiseType::FX_GATED_REVERB,    true,  ParamKind::STEP,  0.25f, 1.0f,    0.70f},
+  {"reverb.decay",    NoiseType::FX_GATED_REVERB,    true,  ParamKind::STEP,  0.0f,  1.0f,    0.60f},
+  {"reverb.mix",      NoiseType::FX_GATED_REVERB,    true,  ParamKind::STEP,  0.0f,  1.0f,    0.30f},
+};
+
+// Fraction of the remaining distance covered per block (~20 ms glide at 64-sample blocks)
+static const float PARAM_GLIDE = 0.25f;
+
+/* UI side */
+static float g_uiValue[PARAM_COUNT];
+
+/* Audio side */
+static float g_target[PARAM_COUNT];
+static float g_current[PARAM_COUNT];
+static bool g_gliding[PARAM_COUNT];
+
+/* SPSC queue: loop() produces, audioTask consumes */
+struct ParamMsg {
+  uint8_t id;
+  float value;
+};
+static const uint32_t PARAM_QUEUE_LEN = 32;  // power of two
+static ParamMsg g_queue[PARAM_QUEUE_LEN];
+static std::atomic<uint32_t> g_qHead(0);  // next slot to write (producer)
+static std::atomic<uint32_t> g_qTail(0);  // next slot to read (consumer)
+
+void initParams() {
+  for (int i = 0; i < PARAM_COUNT; ++i) {
+    g_uiValue[i] = kParams[i].defV;
+    g_target[i] = kParams[i].defV;
+    g_current[i] = kParams[i].defV;
+    g_gliding[i] = false;
+  }
+  g_qHead.store(0);
+  g_qTail.store(0);
+}
+
+const ParamInfo& getParamInfo(ParamId id) {
+  return kParams[(int)id];
+}
+
+const char* getParamName(ParamId id) {
+  return kParams[(int)id].name;
+}
+
+bool findParam(const char* name, ParamId* out) {
+  for (int i = 0; i < PARAM_COUNT; ++i) {
+    if (strcmp(kParams[i].name, name) == 0) {
+      *out = (ParamId)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool setParam(ParamId id, float v) {
+  const ParamInfo& p = kParams[(int)id];
+  if (v < p.minV) v = p.minV;
+  if (v > p.maxV) v = p.maxV;
+  if (p.kind == ParamKind::BOOL) v = (v >= 0.5f) ? 1.0f : 0.0f;
+
+  uint32_t head = g_qHead.load(std::memory_order_relaxed);
+  uint32_t tail = g_qTail.load(std::memory_order_acquire);
+  if (head - tail >= PARAM_QUEUE_LEN) return false;
+  g_queue[head & (PARAM_QUEUE_LEN - 1)].id = (uint8_t)id;
+  g_queue[head & (PARAM_QUEUE_LEN - 1)].value = v;
+  g_qHead.store(head + 1, std::memory_order_release);
+  g_uiValue[(int)id] = v;
+  return true;
+}
+
+float getParam(ParamId id) {
+  return g_uiValue[(int)id];
+}
+
+bool applyPendingParams() {
+  bool changed = false;
+  uint32_t tail = g_qTail.load(std::memory_order_relaxed);
+  uint32_t head = g_qHead.load(std::memory_order_acquire);
+  while (tail != head) {
+    const ParamMsg& m = g_queue[tail & (PARAM_QUEUE_LEN - 1)];
+    int i = m.id;
+    if (i < PARAM_COUNT) {
+      g_target[i] = m.value;
+      if (kParams[i].kind == ParamKind::FLOAT) g_gliding[i] = true;
+      else g_current[i] = m.value;
+      changed = true;
+    }
+    ++tail;
+  }
+  g_qTail.store(tail, std::memory_order_release);
+
+  for (int i = 0; i < PARAM_COUNT; ++i) {
+    if (!g_gliding[i]) continue;
+    float d = g_target[i] - g_current[i];
+    float eps = (kParams[i].maxV - kParams[i].minV) * 1e-5f;
+    if (d < eps && d > -eps) {
+      g_current[i] = g_target[i];
+      g_gliding[i] = false;
+    } else {
+      g_current[i] += d * PARAM_GLIDE;
+    }
+  }
+  return changed;
+}
+
+float paramValue(ParamId id) {
+  return g_current[(int)id];
+}
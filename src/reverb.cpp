@@ -0,0 +1,144 @@
+#include "reverb.h"
+#include "audio_synthesis.h"  // clampS16
+#include "config.h"
+#include "dsp_arena.h"
+#include <Arduino.h>
+#include <string.h>
+
+const ReverbParams REVERB_ROOM  = {0.70f, 0.60f, 0.40f, 0.30f, false, 0.0f, 0.0f};
+const ReverbParams REVERB_GATED = {1.00f, 0.75f, 0.25f, 0.85f, true, 0.03f, 0.18f};
+
+static const int COMB_COUNT = 4;
+static const int COMB_LEN = 512;     // power of two
+static const int ALLPASS_COUNT = 2;
+static const int ALLPASS_LEN = 128;  // power of two
+
+// Comb lengths at size 1.0 (mutually prime, Freeverb ratios scaled to 11,025 Hz)
+static const uint16_t kCombMax[COMB_COUNT] = {449, 421, 397, 367};
+static const uint16_t kAllpassLen[ALLPASS_COUNT] = {113, 83};
+
+// Delay lines live in the DSP arena while a track uses the reverb
+struct ReverbLines {
+  int16_t comb[COMB_COUNT][COMB_LEN];
+  int16_t allpass[ALLPASS_COUNT][ALLPASS_LEN];
+};
+
+struct ReverbState {
+  int32_t combFilt[COMB_COUNT];
+  uint32_t w;
+  // Derived fixed-point parameters (Q15)
+  uint16_t combLen[COMB_COUNT];
+  int32_t feedback;
+  int32_t damp;
+  int32_t wet;
+  int32_t dry;
+  bool gate;
+  int32_t gateThresh;
+  int32_t gateHold;
+  // Gate state
+  int32_t inEnv;
+  int32_t quietFor;
+  int32_t gateGain;  // Q15, ramps to avoid a click when the gate shuts
+};
+
+static ReverbState g_rv;
+static ReverbLines* g_rvLines = nullptr;
+static ReverbParams g_rvParams = REVERB_ROOM;
+
+static inline float clamp01(float v) {
+  if (v < 0.0f) return 0.0f;
+  if (v > 1.0f) return 1.0f;
+  return v;
+}
+
+void setReverbParams(const ReverbParams& p) {
+  g_rvParams = p;
+  float size = p.size;
+  if (size < 0.25f) size = 0.25f;
+  if (size > 1.0f) size = 1.0f;
+  for (int c = 0; c < COMB_COUNT; ++c) g_rv.combLen[c] = (uint16_t)((float)kCombMax[c] * size);
+  g_rv.feedback = (int32_t)((0.70f + 0.27f * clamp01(p.decay)) * 32768.0f);
+  g_rv.damp = (int32_t)(clamp01(p.damping) * 0.9f * 32768.0f);
+  g_rv.wet = (int32_t)(clamp01(p.mix) * 32768.0f);
+  g_rv.dry = 32768 - g_rv.wet;
+  g_rv.gate = p.gate;
+  g_rv.gateThresh = (int32_t)(clamp01(p.gateThreshold) * 32767.0f);
+  g_rv.gateHold = (int32_t)(p.gateHoldSec * (float)SAMPLE_RATE_HZ);
+}
+
+ReverbParams getReverbParams() {
+  return g_rvParams;
+}
+
+void clearReverb() {
+  if (g_rvLines) memset(g_rvLines, 0, sizeof(ReverbLines));
+  for (int c = 0; c < COMB_COUNT; ++c) g_rv.combFilt[c] = 0;
+  g_rv.w = 0;
+  g_rv.inEnv = 0;
+  g_rv.quietFor = 0;
+  g_rv.gateGain = 32768;
+}
+
+void initReverb() {
+  g_rvLines = nullptr;
+  clearReverb();
+  setReverbParams(REVERB_ROOM);
+}
+
+bool attachReverb() {
+  if (g_rvLines) return true;
+  g_rvLines = (ReverbLines*)arenaAlloc(sizeof(ReverbLines), "reverb");
+  clearReverb();
+  return g_rvLines != nullptr;
+}
+
+void releaseReverb() {
+  g_rvLines = nullptr;
+}
+
+void processReverb(int16_t* buf, int n) {
+  if (!g_rvLines) return;
+  ReverbState& r = g_rv;
+  ReverbLines& l = *g_rvLines;
+  const int32_t fb = r.feedback, damp = r.damp, wet = r.wet, dry = r.dry;
+  uint32_t w = r.w;
+
+  for (int i = 0; i < n; ++i) {
+    int32_t x = buf[i];
+    int32_t in = x >> 2;  // headroom for four summed combs
+
+    int32_t acc = 0;
+    for (int c = 0; c < COMB_COUNT; ++c) {
+      int32_t y = l.comb[c][(w - r.combLen[c]) & (COMB_LEN - 1)];
+      r.combFilt[c] = y + (((r.combFilt[c] - y) * damp) >> 15);
+      l.comb[c][w & (COMB_LEN - 1)] = clampS16(in + ((r.combFilt[c] * fb) >> 15));
+      acc += y;
+    }
+    acc >>= 1;
+
+    for (int a = 0; a < ALLPASS_COUNT; ++a) {
+      int32_t bo = l.allpass[a][(w - kAllpassLen[a]) & (ALLPASS_LEN - 1)];
+      l.allpass[a][w & (ALLPASS_LEN - 1)] = clampS16(acc + (bo >> 1));
+      acc = bo - acc;
+    }
+    w++;
+
+    if (r.gate) {
+      int32_t ax = x < 0 ? -x : x;
+      r.inEnv = (ax > r.inEnv) ? ax : r.inEnv - (r.inEnv >> 7);
+      if (r.inEnv > r.gateThresh) r.quietFor = 0;
+      else if (r.quietFor <= r.gateHold) r.quietFor++;
+      int32_t target = (r.quietFor > r.gateHold) ? 0 : 32768;
+      r.gateGain += (target - r.gateGain) >> 4;
+      if (target == 32768 && r.gateGain > 32760) r.gateGain = 32768;
+      acc = (acc * r.gateGain) >> 15;
+    }
+
+    buf[i] = clampS16((x * dry + acc * wet) >> 15);
+  }
+  r.w = w;
+}
+
+uint32_t getReverbMemoryBytes() {
+  return (uint32_t)(sizeof(ReverbState) + sizeof(ReverbLines));
+}
@@ -0,0 +1,185 @@
+#include "sample_clock.h"
+#include "config.h"
+#include <Arduino.h>
+#include <atomic>
+#include "esp_timer.h"
+
+// Anchor published by the output stage, behind a sequence counter (odd = being written).
+// There is one writer at a time: the sample ISR in pipeline mode, audioTask otherwise.
+struct ClockAnchor {
+  uint64_t samples;
+  int64_t us;
+  uint64_t runSamples;  // where the current run started, for the rate estimate
+  int64_t runUs;
+  bool running;
+};
+
+static volatile ClockAnchor g_anchor = {0, 0, 0, 0, false};
+static std::atomic<uint32_t> g_anchorSeq(0);
+
+static uint64_t g_renderClock = 0;  // render side only
+
+// Display latency, written by the UI loop only
+static uint32_t g_avLatencyUs = 0;  // running average
+static uint32_t g_avLatencyMinUs = UINT32_MAX;
+static uint32_t g_avLatencyMaxUs = 0;
+static uint32_t g_avFrames = 0;      // frames in the min/max window
+static bool g_avSeeded = false;
+
+static const uint32_t US_PER_S = 1000000UL;
+
+static void readAnchor(ClockAnchor& a) {
+  uint32_t s0, s1;
+  do {
+    s0 = g_anchorSeq.load(std::memory_order_acquire);
+    a.samples = g_anchor.samples;
+    a.us = g_anchor.us;
+    a.runSamples = g_anchor.runSamples;
+    a.runUs = g_anchor.runUs;
+    a.running = g_anchor.running;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    s1 = g_anchorSeq.load(std::memory_order_relaxed);
+  } while ((s0 & 1u) || s0 != s1);
+}
+
+static inline void IRAM_ATTR beginWrite() {
+  g_anchorSeq.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+static inline void IRAM_ATTR endWrite() {
+  g_anchorSeq.fetch_add(1, std::memory_order_release);
+}
+
+// Interpolated playhead, never past one block beyond the anchor (the next anchor)
+static uint64_t clockAt(const ClockAnchor& a, int64_t us) {
+  if (!a.running || us <= a.us) return a.samples;
+  uint64_t ahead = (uint64_t)(us - a.us) * SAMPLE_RATE_HZ / US_PER_S;
+  if (ahead > (uint64_t)AUDIO_BLOCK_SIZE) ahead = AUDIO_BLOCK_SIZE;
+  return a.samples + ahead;
+}
+
+/* Audio side */
+
+void IRAM_ATTR sampleClockAdvance(uint32_t samples) {
+  const int64_t now = esp_timer_get_time();
+  beginWrite();
+  if (!g_anchor.running) {
+    // First block of a run: the clock resumes from the held value
+    g_anchor.runSamples = g_anchor.samples;
+    // 32-bit divide: the 64-bit libgcc helper is not in IRAM
+    g_anchor.runUs = now - (int64_t)(samples * US_PER_S / SAMPLE_RATE_HZ);
+    g_anchor.running = true;
+  }
+  g_anchor.samples = g_anchor.samples + samples;
+  g_anchor.us = now;
+  endWrite();
+}
+
+void sampleClockStop() {
+  ClockAnchor a;
+  readAnchor(a);
+  if (!a.running) return;
+  // Freeze at what readers may already have seen, so the clock stays monotonic
+  const int64_t now = esp_timer_get_time();
+  const uint64_t held = clockAt(a, now);
+  beginWrite();
+  g_anchor.samples = held;
+  g_anchor.us = now;
+  g_anchor.running = false;
+  endWrite();
+}
+
+void sampleClockSyncRender() {
+  ClockAnchor a;
+  readAnchor(a);
+  g_renderClock = a.samples;
+}
+
+void sampleClockBlockRendered(uint32_t samples) {
+  g_renderClock += samples;
+}
+
+uint64_t getRenderClock() {
+  return g_renderClock;
+}
+
+/* Any core */
+
+uint64_t getSampleClock() {
+  ClockAnchor a;
+  readAnchor(a);
+  return clockAt(a, esp_timer_get_time());
+}
+
+bool sampleClockRunning() {
+  ClockAnchor a;
+  readAnchor(a);
+  return a.running;
+}
+
+int64_t sampleClockToUs(uint64_t clock) {
+  ClockAnchor a;
+  readAnchor(a);
+  const int64_t ds = (int64_t)(clock - a.samples);
+  return a.us + ds * (int64_t)US_PER_S / SAMPLE_RATE_HZ;
+}
+
+uint64_t sampleClockAtUs(int64_t us) {
+  ClockAnchor a;
+  readAnchor(a);
+  if (us >= a.us) return clockAt(a, us);
+  const uint64_t back = (uint64_t)(a.us - us) * SAMPLE_RATE_HZ / US_PER_S;
+  return back < a.samples ? a.samples - back : 0;
+}
+
+/* Display */
+
+void sampleClockNoteFrame(uint64_t shownClock) {
+  if (!sampleClockRunning()) return;
+  const int64_t lat = esp_timer_get_time() - sampleClockToUs(shownClock);
+  const uint32_t us = lat > 0 ? (uint32_t)lat : 0;
+  // ~8-frame average: steady enough to steer visuals, quick to follow a load change
+  g_avLatencyUs = g_avSeeded ? g_avLatencyUs + ((int32_t)(us - g_avLatencyUs) >> 3) : us;
+  g_avSeeded = true;
+  if (us < g_avLatencyMinUs) g_avLatencyMinUs = us;
+  if (us > g_avLatencyMaxUs) g_avLatencyMaxUs = us;
+  g_avFrames++;
+}
+
+uint64_t getDisplayClock() {
+  return getSampleClock() + (uint64_t)g_avLatencyUs * SAMPLE_RATE_HZ / US_PER_S;
+}
+
+uint32_t getAvLatencyUs() {
+  return g_avLatencyUs;
+}
+
+uint32_t getRenderLeadUs() {
+  const uint64_t now = getSampleClock();
+  const uint64_t r = g_renderClock;
+  return r > now ? (uint32_t)((r - now) * US_PER_S / SAMPLE_RATE_HZ) : 0;
+}
+
+void printSampleClock() {
+  ClockAnchor a;
+  readAnchor(a);
+  const uint64_t now = clockAt(a, esp_timer_get_time());
+  Serial.printf("Sample clock: %llu (%.3f s of audio), %s\n", (unsigned long long)now,
+    (double)now / SAMPLE_RATE_HZ, a.running ? "running" : "held");
+  if (a.running && a.us > a.runUs) {
+    const double rate = (double)(a.samples - a.runSamples) * 1e6 / (double)(a.us - a.runUs);
+    Serial.printf("  rate %.2f Hz against esp_timer (%+.0f ppm), run started at %.3f s\n",
+      rate, (rate / SAMPLE_RATE_HZ - 1.0) * 1e6, a.runUs / 1e6);
+  }
+  Serial.printf("  render lead %u us (rendered -> DAC)\n", (unsigned)getRenderLeadUs());
+  if (g_avFrames) {
+    Serial.printf("  audio -> display %u us avg, %u min, %u max over %u frames\n",
+      (unsigned)g_avLatencyUs, (unsigned)g_avLatencyMinUs, (unsigned)g_avLatencyMaxUs, (unsigned)g_avFrames);
+    g_avLatencyMinUs = UINT32_MAX;
+    g_avLatencyMaxUs = 0;
+    g_avFrames = 0;
+  } else {
+    Serial.println("  audio -> display: no frames drawn while playing");
+  }
+}
@@ -0,0 +1,263 @@
+#include "sequencer.h"
+#include "audio_synthesis.h"  // clampS16
+#include "colored_noise.h"    // noiseRand
+#include "config.h"
+#include "params.h"
+#include "sample_clock.h"
+#include "string_bank.h"
+#include <Arduino.h>
+#include <math.h>
+
+static_assert(euclidMask(6, 16, 0) == 0x4949u, "E(6,16) = x..x..x.x..x..x.");
+static_assert(euclidMask(3, 8, 0) == 0x49u, "E(3,8) = x..x..x.");
+static_assert(euclidMask(3, 8, 1) == 0xA4u, "rotation advances the pattern: ..x..x.x");
+
+static const int SEQ_HISTORY = 8;  // > steps per render-ahead window at any sane tempo
+
+struct SeqLane {
+  SeqLaneConfig cfg;
+  uint32_t mask;
+  uint32_t next16;          // samples until the next step, 16.16
+  uint8_t pos;              // next step to play
+  // Recent steps with their sample-clock time (low 32 bits), newest at hist[histW - 1]
+  volatile uint32_t histAt[SEQ_HISTORY];
+  volatile uint8_t histStep[SEQ_HISTORY];
+  volatile uint32_t histW;
+  // Voice state
+  float ph, phStep, env;
+};
+
+static const uint32_t SEQ_MIN_STEP16 = 16u << 16;  // at most 4 events per lane per block
+
+static SeqLane g_lanes[SEQ_LANES];
+static uint32_t g_seqRng = 0x243F6A88u;
+
+// Pattern edits from the UI: one 32-bit word per lane (k | n << 8 | rot << 16 | valid bit)
+static volatile uint32_t g_stagedPattern[SEQ_LANES];
+static uint32_t g_appliedPattern[SEQ_LANES];
+static const uint32_t PATTERN_VALID = 0x80000000u;
+static volatile uint8_t g_stagedVoice[SEQ_LANES];  // SeqVoice + 1, 0 = no change
+static bool g_pluckReady = false;
+
+static const SeqLaneConfig kLaneOff = {0, 0, 0, 1.0f, SeqVoice::BLIP, 440.0f, 0.99f, 0.0f};
+
+static void setLane(int i, const SeqLaneConfig& c) {
+  SeqLane& l = g_lanes[i];
+  l.cfg = c;
+  l.mask = c.steps ? euclidMask(c.pulses, c.steps, c.rotation) : 0;
+  l.next16 = 0;  // first step on the next sample
+  l.pos = 0;
+  l.histW = 0;
+  l.ph = 0.0f;
+  l.phStep = TAU_F * c.freqHz / (float)SAMPLE_RATE_HZ;
+  l.env = 0.0f;
+  g_appliedPattern[i] = g_stagedPattern[i] = 0;
+  g_stagedVoice[i] = 0;
+}
+
+void seqLoadForType(NoiseType t) {
+  g_pluckReady = false;  // the string bank is detached on every track switch
+  for (int i = 0; i < SEQ_LANES; ++i) setLane(i, kLaneOff);
+  switch (t) {
+    case NoiseType::RHYTHM_EUCLIDEAN:
+      // 16ths at 120 BPM (125 ms steps)
+      setLane(0, {6, 16, 0, 4.0f, SeqVoice::BLIP, 1000.0f, 0.995f, 1.0f});
+      break;
+    case NoiseType::RHYTHM_EUCLIDEAN_7_16:
+      setLane(0, {7, 16, 0, 4.0f, SeqVoice::BLIP, 1600.0f, 0.994f, 1.0f});
+      break;
+    case NoiseType::RHYTHM_POLY_3_4:
+      // Three against four per two beats: every 1/3 s and every 1/4 s at 120 BPM
+      setLane(0, {1, 1, 0, 1.5f, SeqVoice::BLIP, 1200.0f, 0.994f, 0.5f});
+      setLane(1, {1, 1, 0, 2.0f, SeqVoice::BLIP, 1200.0f, 0.994f, 0.5f});
+      break;
+    default:
+      break;
+  }
+}
+
+void seqSetPattern(int lane, int pulses, int steps, int rotation) {
+  if (lane < 0 || lane >= SEQ_LANES) return;
+  if (steps < 0) steps = 0;
+  if (steps > SEQ_MAX_STEPS) steps = SEQ_MAX_STEPS;
+  if (pulses < 0) pulses = 0;
+  if (pulses > steps) pulses = steps;
+  if (rotation < 0) rotation = 0;
+  if (steps) rotation %= steps;
+  g_stagedPattern[lane] = PATTERN_VALID | (uint32_t)pulses | ((uint32_t)steps << 8) | ((uint32_t)rotation << 16);
+}
+
+void seqSetVoice(int lane, SeqVoice v) {
+  if (lane < 0 || lane >= SEQ_LANES) return;
+  g_stagedVoice[lane] = (uint8_t)v + 1;
+}
+
+static void applyPattern(int i, uint32_t w) {
+  SeqLane& l = g_lanes[i];
+  g_appliedPattern[i] = w;
+  int k = w & 0xFF, n = (w >> 8) & 0xFF, rot = (w >> 16) & 0xFF;
+  if (l.cfg.steps == 0 && n > 0) {
+    // Turning on an empty lane: borrow lane 0's timing and voice
+    SeqLaneConfig c = g_lanes[0].cfg.steps ? g_lanes[0].cfg : kLaneOff;
+    c.level = c.level > 0.0f ? c.level : 0.5f;
+    l.cfg = c;
+    l.phStep = TAU_F * c.freqHz / (float)SAMPLE_RATE_HZ;
+    l.next16 = g_lanes[0].next16;
+  }
+  l.cfg.pulses = (uint8_t)k;
+  l.cfg.steps = (uint8_t)n;
+  l.cfg.rotation = (uint8_t)rot;
+  l.mask = n ? euclidMask(k, n, rot) : 0;
+  if (l.pos >= n) l.pos = 0;
+}
+
+static void applyStagedPatterns() {
+  for (int i = 0; i < SEQ_LANES; ++i) {
+    SeqLane& l = g_lanes[i];
+    uint32_t w = g_stagedPattern[i];
+    if (w != g_appliedPattern[i]) applyPattern(i, w);
+    uint8_t v = g_stagedVoice[i];
+    if (v) {
+      l.cfg.voice = (SeqVoice)(v - 1);
+      l.env = 0.0f;
+      g_stagedVoice[i] = 0;
+    }
+  }
+}
+
+static void triggerLane(SeqLane& l, uint32_t at) {
+  uint8_t p = l.pos;
+  const uint32_t w = l.histW;
+  l.histAt[w % SEQ_HISTORY] = at;
+  l.histStep[w % SEQ_HISTORY] = p;
+  l.histW = w + 1;
+  l.pos = (uint8_t)((p + 1) % l.cfg.steps);
+  if (!(l.mask & (1u << p))) return;
+  if (l.cfg.voice == SeqVoice::PLUCK) {
+    pluckString(l.cfg.freqHz, (uint8_t)(l.cfg.level * 127.0f));
+  } else {
+    l.env = l.cfg.level;
+    l.ph = 0.0f;  // blips start at a zero crossing, so coincident lanes add up coherently
+  }
+}
+
+// Sum the decaying lane voices over a run with no events
+static void renderLaneVoices(int16_t* out, int n) {
+  for (int i = 0; i < n; ++i) out[i] = 0;
+  for (int li = 0; li < SEQ_LANES; ++li) {
+    SeqLane& l = g_lanes[li];
+    if (l.env < 1e-4f || l.cfg.voice == SeqVoice::PLUCK) continue;
+    float env = l.env, ph = l.ph;
+    const float d = l.cfg.decay;
+    if (l.cfg.voice == SeqVoice::NOISE) {
+      uint32_t rng = g_seqRng;
+      for (int i = 0; i < n; ++i) {
+        float w = (float)((int32_t)(noiseRand(rng) >> 16) - 32768);
+        out[i] = clampS16(out[i] + (int32_t)(env * w));
+        env *= d;
+      }
+      g_seqRng = rng;
+    } else {
+      const float step = l.phStep;
+      for (int i = 0; i < n; ++i) {
+        ph += step;
+        if (ph >= TAU_F) ph -= TAU_F;
+        out[i] = clampS16(out[i] + (int32_t)(env * sinf(ph) * 32767.0f));
+        env *= d;
+      }
+    }
+    l.env = env;
+    l.ph = ph;
+  }
+}
+
+struct SeqEvent {
+  int offset;
+  int lane;
+};
+
+void renderSequencer(int16_t* out, int n) {
+  applyStagedPatterns();
+
+  // Collect this block's step events, in time order
+  SeqEvent ev[SEQ_LANES * 4];
+  int count = 0;
+  const float bpm = paramValue(ParamId::SEQ_BPM);
+  for (int li = 0; li < SEQ_LANES; ++li) {
+    SeqLane& l = g_lanes[li];
+    if (l.cfg.steps == 0) continue;
+    uint32_t stepLen16 = (uint32_t)((float)SAMPLE_RATE_HZ * 60.0f * 65536.0f / (bpm * l.cfg.stepsPerBeat));
+    if (stepLen16 < SEQ_MIN_STEP16) stepLen16 = SEQ_MIN_STEP16;
+    while ((l.next16 >> 16) < (uint32_t)n && count < (int)(sizeof(ev) / sizeof(ev[0]))) {
+      int off = (int)(l.next16 >> 16);
+      int j = count++;
+      while (j > 0 && ev[j - 1].offset > off) { ev[j] = ev[j - 1]; --j; }
+      ev[j].offset = off;
+      ev[j].lane = li;
+      l.next16 += stepLen16;
+    }
+    l.next16 -= (uint32_t)n << 16;
+  }
+
+  // Render runs between events; plucks go through the string bank on the same timeline
+  const uint32_t blockAt = (uint32_t)getRenderClock();
+  int cursor = 0;
+  int16_t strings[AUDIO_BLOCK_SIZE];
+  bool plucks = false;
+  for (int li = 0; li < SEQ_LANES; ++li) plucks |= g_lanes[li].cfg.voice == SeqVoice::PLUCK && g_lanes[li].cfg.steps;
+  if (plucks && !g_pluckReady) {
+    // First pluck lane on this track: take the string bank and silence its own pattern
+    plucks = g_pluckReady = attachStringBank();
+    setPluckPattern(nullptr, 0, 0);
+  }
+  plucks = plucks && g_pluckReady;
+  for (int e = 0; e <= count; ++e) {
+    int end = e < count ? ev[e].offset : n;
+    while (cursor < end) {
+      int run = end - cursor;
+      if (run > AUDIO_BLOCK_SIZE) run = AUDIO_BLOCK_SIZE;
+      renderLaneVoices(out + cursor, run);
+      if (plucks) {
+        renderStringBank(strings, run);
+        for (int i = 0; i < run; ++i) out[cursor + i] = clampS16(out[cursor + i] + strings[i]);
+      }
+      cursor += run;
+    }
+    if (e < count) triggerLane(g_lanes[ev[e].lane], blockAt + (uint32_t)ev[e].offset);
+  }
+}
+
+int seqLaneSteps(int lane) {
+  return (lane >= 0 && lane < SEQ_LANES) ? g_lanes[lane].cfg.steps : 0;
+}
+
+uint32_t seqLaneMask(int lane) {
+  return (lane >= 0 && lane < SEQ_LANES) ? g_lanes[lane].mask : 0;
+}
+
+int seqLaneStepAt(int lane, uint64_t clock) {
+  if (lane < 0 || lane >= SEQ_LANES) return -1;
+  const SeqLane& l = g_lanes[lane];
+  // Steps rendered ahead of the DAC are skipped until the clock reaches them
+  const uint32_t w = l.histW;
+  const uint32_t now = (uint32_t)clock;
+  for (uint32_t i = 0; i < (uint32_t)SEQ_HISTORY && i < w; ++i) {
+    const uint32_t slot = (w - 1 - i) % SEQ_HISTORY;
+    if ((int32_t)(now - l.histAt[slot]) >= 0) return l.histStep[slot];
+  }
+  return -1;
+}
+
+void printSequencer() {
+  Serial.printf("Sequencer: %.1f BPM\n", getParam(ParamId::SEQ_BPM));
+  for (int li = 0; li < SEQ_LANES; ++li) {
+    const SeqLane& l = g_lanes[li];
+    if (!l.cfg.steps) continue;
+    char pat[SEQ_MAX_STEPS + 1];
+    for (int i = 0; i < l.cfg.steps; ++i) pat[i] = (l.mask >> i) & 1u ? 'x' : '.';
+    pat[l.cfg.steps] = 0;
+    static const char* kVoiceNames[] = {"blip", "noise", "pluck"};
+    Serial.printf("  lane %d: E(%d,%d) rot %d, %.2f steps/beat, %s  %s\n", li, l.cfg.pulses, l.cfg.steps,
+      l.cfg.rotation, l.cfg.stepsPerBeat, kVoiceNames[(int)l.cfg.voice], pat);
+  }
+}
@@ -0,0 +1,329 @@
+#include "serial_commands.h"
+#include "app.h"
+#include "audio_master.h"
+#include "audio_synthesis.h"
+#include "bytebeat.h"
+#include "config.h"
+#include "control_rate.h"
+#include "colored_noise.h"
+#include "cpu_load.h"
+#include "delay_line.h"
+#include "diagnostics.h"
+#include "dsp_arena.h"
+#include "filters.h"
+#include "fm_engine.h"
+#include "granular.h"
+#include "modal_bank.h"
+#include "osc_bank.h"
+#include "params.h"
+#include "sample_clock.h"
+#include "sequencer.h"
+#include "spectral_noise.h"
+#include "types.h"
+#include "voice_manager.h"
+#include <Arduino.h>
+#include <atomic>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_timer.h"
+
+static const int LINE_MAX = 160;  // room for "bb <formula>"
+static char g_line[LINE_MAX];
+static int g_lineLen = 0;
+
+// Arrival of the oldest unparsed bytes: set by the UART event task when the driver hands bytes
+// over (FIFO full or a few idle character times), taken by pollSerialCommands. Low 32 bits of
+// esp_timer with bit 0 set, 0 = nothing new.
+static std::atomic<uint32_t> g_rxStampUs(0);
+static TaskHandle_t g_uiTask = nullptr;
+
+static void printParam(ParamId id) {
+  const ParamInfo& p = getParamInfo(id);
+  Serial.printf("  %-16s = %.3f  [%.3f .. %.3f]%s\n", p.name, getParam(id), p.minV, p.maxV,
+    p.global ? "  (global)" : "");
+}
+
+static void listParams(bool all) {
+  NoiseType cur = getCurrentNoiseType(getCurrentTrack());
+  for (int i = 0; i < PARAM_COUNT; ++i) {
+    const ParamInfo& p = getParamInfo((ParamId)i);
+    if (all || p.global || p.owner == cur) printParam((ParamId)i);
+  }
+}
+
+static void printHelp() {
+  Serial.println("Commands: help | list [all] | get <name> | set <name> <value> | track <1..N>");
+  Serial.println("          play | pause | vol <0..100> | dither <none|tpdf|shaped>");
+  Serial.println("          ctrl <1..256> (control-rate K) | bench (pauses audio)");
+  Serial.println("          pipeline [on|off] | ahead <1..7> (blocks) | load <ms> (per frame) | duty | mem");
+  Serial.println("          diag | telemetry <ms|off> (binary frames, see diagnostics.h) | noisecheck | clock | oscbench | fmbench | filterbench | delaybench | modal | grain");
+  Serial.println("          spec [<point> <dB> | preset <flat|notch|shelf|band> | frame <64..512> | overlap <2|4> | bench]");
+  Serial.println("          bb [<formula> | preset <n> | file <path> [n] | bench] (Bytebeat track)");
+  Serial.println("          note <hz> [vel 1..127] [sine|saw|square|fm|pluck] | note off <hz> | note panic | voices");
+  Serial.println("          (Voices track; raw MIDI note on/off and program change bytes are accepted too)");
+  Serial.println("          seq [<lane> <k> <n> [rot] | <lane> voice <blip|noise|pluck>] (tempo: set seq.bpm)");
+}
+
+static void handleSpectral(const char* a1, const char* a2) {
+  if (a1 && strcmp(a1, "bench") == 0) {
+    benchSpectralNoise();
+    return;
+  }
+  if (a1 && a2) {
+    SpectralConfig c;
+    getSpectralConfig(c);
+    if (strcmp(a1, "preset") == 0) {
+      bool found = false;
+      for (int i = 0; i < (int)SpectralPreset::COUNT; ++i) {
+        if (strcmp(a2, getSpectralPresetName((SpectralPreset)i)) == 0) {
+          setSpectralPreset((SpectralPreset)i);
+          found = true;
+        }
+      }
+      if (!found) Serial.printf("Unknown preset: %s\n", a2);
+    } else if (strcmp(a1, "frame") == 0) {
+      c.frame = atoi(a2);
+      setSpectralConfig(c);
+    } else if (strcmp(a1, "overlap") == 0) {
+      c.overlap = atoi(a2);
+      setSpectralConfig(c);
+    } else {
+      setSpectralPoint(atoi(a1), (float)atof(a2));
+    }
+  }
+  printSpectralConfig();
+}
+
+// rest is the unsplit remainder of the line: formulas may contain spaces
+static void handleBytebeat(char* rest) {
+  while (*rest == ' ' || *rest == '\t') rest++;
+  char err[64];
+  bool ok = true;
+  if (!*rest) {
+    printBytebeat();
+    return;
+  } else if (strcmp(rest, "bench") == 0) {
+    benchBytebeat();
+    return;
+  } else if (strncmp(rest, "preset", 6) == 0) {
+    const char* f = getBytebeatPreset(atoi(rest + 6));
+    if (!f) {
+      Serial.printf("Preset must be 0..%d\n", getBytebeatPresetCount() - 1);
+      return;
+    }
+    ok = setBytebeatFormula(f, err, sizeof(err));
+  } else if (strncmp(rest, "file ", 5) == 0) {
+    char* path = strtok(rest + 5, " \t");
+    char* index = strtok(nullptr, " \t");
+    ok = path && loadBytebeatFile(path, index ? atoi(index) : 0, err, sizeof(err));
+    if (!path) strcpy(err, "usage: bb file <path> [n]");
+  } else {
+    ok = setBytebeatFormula(rest, err, sizeof(err));
+  }
+  if (ok) printBytebeat();
+  else Serial.printf("Bytebeat: %s\n", err);
+}
+
+static void handleNote(const char* a1, const char* a2, const char* a3) {
+  if (!a1) {
+    Serial.println("Usage: note <hz> [vel] [gen] | note off <hz> | note panic");
+    return;
+  }
+  bool ok;
+  if (strcmp(a1, "panic") == 0) {
+    ok = voicePanic();
+  } else if (strcmp(a1, "off") == 0 && a2) {
+    ok = voiceNoteOff(voiceKeyForHz(strtof(a2, nullptr)));
+  } else {
+    const float hz = strtof(a1, nullptr);
+    VoiceGen gen = VoiceGen::SINE;
+    if (a3 && !findVoiceGen(a3, &gen)) {
+      Serial.printf("Unknown generator: %s\n", a3);
+      return;
+    }
+    ok = voiceNoteOn(voiceKeyForHz(hz), hz, a2 ? (uint8_t)atoi(a2) : 100, gen);
+  }
+  if (!ok) Serial.println("Note queue full, retry");
+  if (getCurrentNoiseType(getCurrentTrack()) != NoiseType::TONE_VOICES) {
+    Serial.printf("Notes play on the Voices track (track %d)\n", TRACK_COUNT);
+  }
+}
+
+// Edits are staged and picked up by the audio side at its next block
+static void handleSequencer(const char* a1, const char* a2, const char* a3, const char* a4) {
+  if (!a1 || !a2) {
+    printSequencer();
+    return;
+  }
+  int lane = atoi(a1);
+  if (lane < 0 || lane >= SEQ_LANES) {
+    Serial.printf("Lane must be 0..%d\n", SEQ_LANES - 1);
+  } else if (strcmp(a2, "voice") == 0 && a3) {
+    static const char* kVoices[] = {"blip", "noise", "pluck"};
+    for (int i = 0; i < 3; ++i) {
+      if (strcmp(a3, kVoices[i]) == 0) {
+        seqSetVoice(lane, (SeqVoice)i);
+        Serial.printf("Lane %d voice: %s\n", lane, kVoices[i]);
+        return;
+      }
+    }
+    Serial.printf("Unknown voice: %s\n", a3);
+  } else if (a3) {
+    seqSetPattern(lane, atoi(a2), atoi(a3), a4 ? atoi(a4) : 0);
+    Serial.printf("Lane %d: E(%d,%d) rot %d\n", lane, atoi(a2), atoi(a3), a4 ? atoi(a4) : 0);
+  } else {
+    Serial.println("Usage: seq <lane> <k> <n> [rot]");
+  }
+}
+
+static void handleLine(char* line) {
+  char* end = line + strlen(line);
+  char* cmd = strtok(line, " \t");
+  if (!cmd) return;
+  if (strcmp(cmd, "bb") == 0) {
+    char* rest = cmd + strlen(cmd);
+    handleBytebeat(rest < end ? rest + 1 : rest);
+    return;
+  }
+  char* a1 = strtok(nullptr, " \t");
+  char* a2 = strtok(nullptr, " \t");
+  char* a3 = strtok(nullptr, " \t");
+  char* a4 = strtok(nullptr, " \t");
+
+  if (strcmp(cmd, "help") == 0) {
+    printHelp();
+  } else if (strcmp(cmd, "list") == 0) {
+    listParams(a1 && strcmp(a1, "all") == 0);
+  } else if (strcmp(cmd, "get") == 0 && a1) {
+    ParamId id;
+    if (findParam(a1, &id)) printParam(id);
+    else Serial.printf("Unknown parameter: %s\n", a1);
+  } else if (strcmp(cmd, "set") == 0 && a1 && a2) {
+    ParamId id;
+    if (!findParam(a1, &id)) {
+      Serial.printf("Unknown parameter: %s\n", a1);
+    } else if (!setParam(id, strtof(a2, nullptr))) {
+      Serial.println("Parameter queue full, retry");
+    } else {
+      printParam(id);
+    }
+  } else if (strcmp(cmd, "track") == 0 && a1) {
+    int n = atoi(a1);
+    if (n < 1 || n > TRACK_COUNT) {
+      Serial.printf("Track must be 1..%d\n", TRACK_COUNT);
+    } else {
+      selectTrack(n - 1);
+      Serial.printf("Track %d (%s)\n", n, getNoiseTypeName(getCurrentNoiseType(n - 1)));
+    }
+  } else if (strcmp(cmd, "play") == 0) {
+    setPlaying(true);
+  } else if (strcmp(cmd, "pause") == 0) {
+    setPlaying(false);
+  } else if (strcmp(cmd, "vol") == 0 && a1) {
+    setMasterGain(strtof(a1, nullptr) / 100.0f);
+    requestRedraw();
+  } else if (strcmp(cmd, "dither") == 0 && a1) {
+    if (strcmp(a1, "none") == 0) setDitherMode(DitherMode::NONE);
+    else if (strcmp(a1, "tpdf") == 0) setDitherMode(DitherMode::TPDF);
+    else if (strcmp(a1, "shaped") == 0) setDitherMode(DitherMode::TPDF_SHAPED);
+    Serial.printf("Dither: %s\n", getDitherModeName(getDitherMode()));
+  } else if (strcmp(cmd, "ctrl") == 0) {
+    if (a1) setControlRate(atoi(a1));
+    Serial.printf("Control rate: every %d samples\n", getControlRate());
+  } else if (strcmp(cmd, "bench") == 0) {
+    // Generators are not re-entrant: stop the audio task before driving them from here
+    bool wasPlaying = getPlaying();
+    setPlaying(false);
+    delay(20);
+    benchControlRate();
+    setPlaying(wasPlaying);
+  } else if (strcmp(cmd, "pipeline") == 0) {
+    if (a1) {
+      // The mode is switched by audioTask while paused
+      bool wasPlaying = getPlaying();
+      setPlaying(false);
+      setAudioPipeline(strcmp(a1, "on") == 0);
+      delay(30);
+      setPlaying(wasPlaying);
+    }
+    Serial.printf("Pipeline %s, render-ahead %d blocks, underruns %u samples\n",
+      getAudioPipeline() ? "on" : "off", getRenderAhead(), (unsigned)getUnderrunCount());
+  } else if (strcmp(cmd, "ahead") == 0 && a1) {
+    setRenderAhead(atoi(a1));
+    Serial.printf("Render-ahead: %d blocks (%.1f ms)\n", getRenderAhead(),
+      1000.0f * getRenderAhead() * AUDIO_BLOCK_SIZE / (float)SAMPLE_RATE_HZ);
+  } else if (strcmp(cmd, "load") == 0 && a1) {
+    setSyntheticLoadMs((uint32_t)atoi(a1));
+    Serial.printf("Synthetic display load: %d ms per frame\n", atoi(a1));
+  } else if (strcmp(cmd, "duty") == 0) {
+    printCpuDuty(getPlaying() ? getNoiseTypeName(getCurrentNoiseType(getCurrentTrack())) : "paused");
+  } else if (strcmp(cmd, "mem") == 0) {
+    printArenaReport();
+  } else if (strcmp(cmd, "spec") == 0) {
+    handleSpectral(a1, a2);
+  } else if (strcmp(cmd, "seq") == 0) {
+    handleSequencer(a1, a2, a3, a4);
+  } else if (strcmp(cmd, "note") == 0) {
+    handleNote(a1, a2, a3);
+  } else if (strcmp(cmd, "voices") == 0) {
+    printVoices();
+  } else if (strcmp(cmd, "noisecheck") == 0) {
+    checkNoiseSlopes();
+  } else if (strcmp(cmd, "modal") == 0) {
+    printModalTrack();
+  } else if (strcmp(cmd, "grain") == 0) {
+    printGranular();
+  } else if (strcmp(cmd, "filterbench") == 0) {
+    benchFilters();
+  } else if (strcmp(cmd, "delaybench") == 0) {
+    benchDelayLine();
+  } else if (strcmp(cmd, "fmbench") == 0) {
+    benchFmEngine();
+  } else if (strcmp(cmd, "oscbench") == 0) {
+    benchOscBank();
+  } else if (strcmp(cmd, "clock") == 0) {
+    printSampleClock();
+  } else if (strcmp(cmd, "diag") == 0) {
+    printDiagnostics();
+  } else if (strcmp(cmd, "telemetry") == 0 && a1) {
+    uint32_t ms = strcmp(a1, "off") == 0 ? 0 : (uint32_t)atoi(a1);
+    setTelemetryInterval(ms);
+    if (ms) Serial.printf("Telemetry: every %u ms\n", (unsigned)ms);
+    else Serial.println("Telemetry: off");
+  } else {
+    Serial.printf("Unknown command: %s (try 'help')\n", cmd);
+  }
+}
+
+static void onSerialReceive() {
+  uint32_t none = 0;
+  g_rxStampUs.compare_exchange_strong(none, (uint32_t)esp_timer_get_time() | 1u);
+  if (g_uiTask) xTaskNotifyGive(g_uiTask);
+}
+
+void initSerialCommands(TaskHandle_t ui) {
+  g_uiTask = ui;
+  Serial.onReceive(onSerialReceive);
+}
+
+void pollSerialCommands() {
+  const uint32_t stamp = g_rxStampUs.exchange(0);
+  if (stamp) {
+    const int64_t now = esp_timer_get_time();
+    voiceSetInputArrival(now - (int64_t)(uint32_t)((uint32_t)now - stamp));
+  }
+  while (Serial.available() > 0) {
+    int c = Serial.read();
+    if (c < 0) break;
+    if (voiceMidiByte((uint8_t)c)) continue;  // MIDI bytes never reach the text line
+    if (c == '\r') continue;
+    if (c == '\n') {
+      g_line[g_lineLen] = '\0';
+      handleLine(g_line);
+      g_lineLen = 0;
+    } else if (g_lineLen < LINE_MAX - 1) {
+      g_line[g_lineLen++] = (char)c;
+    }
+  }
+  voiceSetInputArrival(0);
+}
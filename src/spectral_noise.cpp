@@ -0,0 +1,300 @@
+#include "spectral_noise.h"
+#include "audio_synthesis.h"  // clampS16
+#include "colored_noise.h"    // noiseRand
+#include "config.h"
+#include "dsp_arena.h"
+#include "profiling.h"
+#include <Arduino.h>
+#include <atomic>
+#include <math.h>
+#include <stdlib.h>
+
+static const float SPECTRAL_LO_HZ = 40.0f;
+static const float SPECTRAL_HI_HZ = 5000.0f;
+static const float SPECTRAL_DB_MIN = -60.0f;
+static const float SPECTRAL_DB_MAX = 24.0f;
+static const float SPECTRAL_TARGET_RMS = 9000.0f;
+
+// One synthesis engine. Buffers are sized for SPECTRAL_FRAME_MAX whatever the frame size.
+struct SpectralEngine {
+  float* re;     // frame spectrum / time signal
+  float* im;
+  float* ola;    // overlap-add accumulator, one frame long
+  float* mag;    // per-bin magnitude incl. output gain, frame/2 + 1 entries
+  float* cosT;   // cos(2*pi*k / SPECTRAL_FRAME_MAX)
+  float* win;    // sine window for the current frame size
+  int frame, overlap, hop, pos;
+  uint32_t rng;
+};
+
+static const uint32_t SPECTRAL_ENGINE_FLOATS = 6 * SPECTRAL_FRAME_MAX;
+
+/* === Staged configuration (seqlock: odd sequence = UI is writing) === */
+
+static SpectralConfig g_staged = {SPECTRAL_FRAME_DEFAULT, SPECTRAL_OVERLAP_DEFAULT, {0}};
+static std::atomic<uint32_t> g_stagedSeq(0);
+static uint32_t g_appliedSeq = 0xFFFFFFFFu;  // audio side
+static SpectralConfig g_active;              // audio side
+
+static SpectralEngine g_spec;
+static bool g_specAttached = false;
+
+float spectralPointHz(int i) {
+  return SPECTRAL_LO_HZ * powf(SPECTRAL_HI_HZ / SPECTRAL_LO_HZ, (float)i / (float)(SPECTRAL_POINTS - 1));
+}
+
+static void clampConfig(SpectralConfig& c) {
+  int f = 64;
+  while (f < c.frame && f < SPECTRAL_FRAME_MAX) f <<= 1;
+  c.frame = f;
+  c.overlap = c.overlap >= 4 ? 4 : 2;
+  for (int i = 0; i < SPECTRAL_POINTS; ++i) {
+    if (c.db[i] < SPECTRAL_DB_MIN) c.db[i] = SPECTRAL_DB_MIN;
+    if (c.db[i] > SPECTRAL_DB_MAX) c.db[i] = SPECTRAL_DB_MAX;
+  }
+}
+
+void getSpectralConfig(SpectralConfig& c) {
+  c = g_staged;  // only the UI writes g_staged, so its own reads need no lock
+}
+
+void setSpectralConfig(const SpectralConfig& c) {
+  SpectralConfig v = c;
+  clampConfig(v);
+  g_stagedSeq.fetch_add(1, std::memory_order_acq_rel);
+  g_staged = v;
+  g_stagedSeq.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void setSpectralPoint(int i, float db) {
+  if (i < 0 || i >= SPECTRAL_POINTS) return;
+  SpectralConfig c;
+  getSpectralConfig(c);
+  c.db[i] = db;
+  setSpectralConfig(c);
+}
+
+void setSpectralPreset(SpectralPreset p) {
+  SpectralConfig c;
+  getSpectralConfig(c);
+  for (int i = 0; i < SPECTRAL_POINTS; ++i) {
+    float hz = spectralPointHz(i);
+    float db = 0.0f;
+    switch (p) {
+      case SpectralPreset::NOTCH:     db = (hz > 700.0f && hz < 1400.0f) ? -30.0f : 0.0f; break;
+      case SpectralPreset::LOW_SHELF: db = hz < 200.0f ? 12.0f : 0.0f; break;
+      case SpectralPreset::BAND:      db = (hz >= 250.0f && hz <= 900.0f) ? 0.0f : -24.0f; break;
+      default: break;
+    }
+    c.db[i] = db;
+  }
+  setSpectralConfig(c);
+}
+
+const char* getSpectralPresetName(SpectralPreset p) {
+  switch (p) {
+    case SpectralPreset::FLAT:      return "flat";
+    case SpectralPreset::NOTCH:     return "notch";
+    case SpectralPreset::LOW_SHELF: return "shelf";
+    case SpectralPreset::BAND:      return "band";
+    default: return "?";
+  }
+}
+
+/* === Engine === */
+
+static void engineBind(SpectralEngine& e, float* mem) {
+  e.re = mem;
+  e.im = mem + SPECTRAL_FRAME_MAX;
+  e.ola = mem + 2 * SPECTRAL_FRAME_MAX;
+  e.mag = mem + 3 * SPECTRAL_FRAME_MAX;
+  e.cosT = mem + 4 * SPECTRAL_FRAME_MAX;
+  e.win = mem + 5 * SPECTRAL_FRAME_MAX;
+  for (int k = 0; k < SPECTRAL_FRAME_MAX; ++k) e.cosT[k] = cosf(TAU_F * (float)k / (float)SPECTRAL_FRAME_MAX);
+  e.frame = e.overlap = 0;
+  e.hop = e.pos = 0;
+  e.rng = 0x510E527Fu;
+}
+
+// sin(2*pi*k / SPECTRAL_FRAME_MAX) = cos of a quarter turn earlier
+static inline float tableSin(const SpectralEngine& e, int k) {
+  return e.cosT[(k - SPECTRAL_FRAME_MAX / 4) & (SPECTRAL_FRAME_MAX - 1)];
+}
+
+// Interpolate the dB curve onto the bins and fold in the output gain
+static void engineConfigure(SpectralEngine& e, const SpectralConfig& c) {
+  if (c.frame != e.frame || c.overlap != e.overlap) {
+    e.frame = c.frame;
+    e.overlap = c.overlap;
+    e.hop = c.frame / c.overlap;
+    e.pos = e.hop;  // synthesise a frame on the next sample
+    for (int i = 0; i < e.frame; ++i) {
+      e.win[i] = sinf(0.5f * TAU_F * ((float)i + 0.5f) / (float)e.frame);
+      e.ola[i] = 0.0f;
+    }
+  }
+  const int half = e.frame / 2;
+  const float logLo = log2f(SPECTRAL_LO_HZ);
+  const float span = log2f(SPECTRAL_HI_HZ / SPECTRAL_LO_HZ);
+  float power = 0.0f;
+  e.mag[0] = 0.0f;  // no DC
+  e.mag[half] = 0.0f;
+  for (int k = 1; k < half; ++k) {
+    float hz = (float)k * (float)SAMPLE_RATE_HZ / (float)e.frame;
+    float x = (log2f(hz) - logLo) / span * (float)(SPECTRAL_POINTS - 1);
+    float db;
+    if (x <= 0.0f) db = c.db[0];
+    else if (x >= (float)(SPECTRAL_POINTS - 1)) db = c.db[SPECTRAL_POINTS - 1];
+    else {
+      int i = (int)x;
+      float frac = x - (float)i;
+      db = c.db[i] + frac * (c.db[i + 1] - c.db[i]);
+    }
+    float m = powf(10.0f, db * 0.05f);
+    e.mag[k] = m;
+    power += m * m;
+  }
+  // Random-phase frame variance is 2*sum(m^2); overlapping sine windows add overlap/2 of it
+  float g = power > 0.0f ? SPECTRAL_TARGET_RMS / sqrtf(power * (float)e.overlap) : 0.0f;
+  for (int k = 1; k < half; ++k) e.mag[k] *= g;
+}
+
+// In-place radix-2 inverse FFT (no 1/N scaling)
+static void inverseFft(SpectralEngine& e) {
+  const int n = e.frame;
+  float* re = e.re;
+  float* im = e.im;
+  for (int i = 1, j = 0; i < n; ++i) {
+    int bit = n >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if (i < j) {
+      float t = re[i]; re[i] = re[j]; re[j] = t;
+      t = im[i]; im[i] = im[j]; im[j] = t;
+    }
+  }
+  for (int len = 2; len <= n; len <<= 1) {
+    const int step = SPECTRAL_FRAME_MAX / len;
+    const int halfLen = len >> 1;
+    for (int i = 0; i < n; i += len) {
+      for (int k = 0; k < halfLen; ++k) {
+        float wr = e.cosT[k * step];
+        float wi = tableSin(e, k * step);  // +j: inverse transform
+        int a = i + k, b = a + halfLen;
+        float tr = re[b] * wr - im[b] * wi;
+        float ti = re[b] * wi + im[b] * wr;
+        re[b] = re[a] - tr;
+        im[b] = im[a] - ti;
+        re[a] += tr;
+        im[a] += ti;
+      }
+    }
+  }
+}
+
+// Shift out the hop just played and add a new windowed random-phase frame
+static void engineSynthesize(SpectralEngine& e) {
+  const int n = e.frame;
+  const int half = n / 2;
+  for (int i = 0; i < n - e.hop; ++i) e.ola[i] = e.ola[i + e.hop];
+  for (int i = n - e.hop; i < n; ++i) e.ola[i] = 0.0f;
+
+  uint32_t rng = e.rng;
+  e.re[0] = e.im[0] = 0.0f;
+  e.re[half] = e.im[half] = 0.0f;
+  for (int k = 1; k < half; ++k) {
+    int ph = (int)(noiseRand(rng) >> 16) & (SPECTRAL_FRAME_MAX - 1);
+    float m = e.mag[k];
+    float r = m * e.cosT[ph], q = m * tableSin(e, ph);
+    e.re[k] = r;     e.im[k] = q;
+    e.re[n - k] = r; e.im[n - k] = -q;  // Hermitian: real output
+  }
+  e.rng = rng;
+  inverseFft(e);
+  for (int i = 0; i < n; ++i) e.ola[i] += e.re[i] * e.win[i];
+  e.pos = 0;
+}
+
+static void engineRender(SpectralEngine& e, int16_t* out, int n) {
+  for (int i = 0; i < n; ++i) {
+    if (e.pos >= e.hop) {
+      // Frame boundary: pick up a complete staged configuration if it changed
+      uint32_t seq = g_stagedSeq.load(std::memory_order_acquire);
+      if (seq != g_appliedSeq && !(seq & 1u)) {
+        SpectralConfig c = g_staged;
+        if (g_stagedSeq.load(std::memory_order_acquire) == seq) {
+          g_active = c;
+          g_appliedSeq = seq;
+          engineConfigure(e, g_active);
+        }
+      }
+      if (e.frame == 0) {  // not configured yet (UI mid-write): retry next sample
+        out[i] = 0;
+        continue;
+      }
+      engineSynthesize(e);
+    }
+    out[i] = clampS16((int32_t)e.ola[e.pos++]);
+  }
+}
+
+bool attachSpectralNoise() {
+  if (g_specAttached) return true;
+  float* mem = (float*)arenaAlloc(SPECTRAL_ENGINE_FLOATS * sizeof(float), "spectral");
+  if (!mem) return false;
+  engineBind(g_spec, mem);
+  g_appliedSeq = 0xFFFFFFFFu;  // force configuration from the staged curve
+  g_specAttached = true;
+  return true;
+}
+
+void releaseSpectralNoise() {
+  g_specAttached = false;
+}
+
+void renderSpectralNoise(int16_t* out, int n) {
+  if (!g_specAttached) {
+    for (int i = 0; i < n; ++i) out[i] = 0;
+    return;
+  }
+  engineRender(g_spec, out, n);
+}
+
+void printSpectralConfig() {
+  SpectralConfig c;
+  getSpectralConfig(c);
+  Serial.printf("Spectral noise: frame %d, overlap %d (hop %d samples, %.1f ms)\n",
+    c.frame, c.overlap, c.frame / c.overlap, 1000.0f * (float)(c.frame / c.overlap) / (float)SAMPLE_RATE_HZ);
+  for (int i = 0; i < SPECTRAL_POINTS; ++i) {
+    Serial.printf("  %2d %6.0f Hz %+6.1f dB\n", i, spectralPointHz(i), c.db[i]);
+  }
+}
+
+void benchSpectralNoise() {
+  float* mem = (float*)malloc(SPECTRAL_ENGINE_FLOATS * sizeof(float));
+  if (!mem) {
+    Serial.println("Spectral bench: out of memory");
+    return;
+  }
+  SpectralEngine e;
+  engineBind(e, mem);
+  SpectralConfig c;
+  getSpectralConfig(c);
+  const float budget = (float)ESP.getCpuFreqMHz() * 1000000.0f / (float)SAMPLE_RATE_HZ;
+  Serial.printf("Spectral bench @%u MHz (budget %.0f cycles/sample):\n", (unsigned)ESP.getCpuFreqMHz(), budget);
+  const int FRAMES = 32;
+  for (int frame = 64; frame <= SPECTRAL_FRAME_MAX; frame <<= 1) {
+    for (int overlap = 2; overlap <= 4; overlap += 2) {
+      c.frame = frame;
+      c.overlap = overlap;
+      engineConfigure(e, c);
+      uint32_t c0 = cycleNow();
+      for (int f = 0; f < FRAMES; ++f) engineSynthesize(e);
+      uint32_t perFrame = (cycleNow() - c0) / FRAMES;
+      float perSample = (float)perFrame / (float)e.hop;
+      Serial.printf("  frame %3d overlap %d: %6u cycles/frame, %5.1f cycles/sample (%4.1f%% of budget)\n",
+        frame, overlap, (unsigned)perFrame, perSample, 100.0f * perSample / budget);
+    }
+  }
+  free(mem);
+}
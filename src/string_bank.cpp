@@ -0,0 +1,221 @@
+#include "string_bank.h"
+#include "audio_synthesis.h"  // clampS16
+#include "config.h"
+#include "dsp_arena.h"
+#include <Arduino.h>
+#include <math.h>
+
+static const uint32_t STRING_MASK = STRING_BUF_LEN - 1;
+static const int EXCITE_LEN = STRING_BUF_LEN;
+
+struct KsString {
+  int16_t* buf;        // ring buffer (arena)
+  uint32_t w;          // write index
+  uint32_t delay;      // integer part of the loop delay
+  int32_t apCoef;      // allpass coefficient, Q15
+  int32_t apX1, apY1;  // allpass state
+  int32_t prev;        // previous loop sample for the averaging filter
+  int32_t loss;        // per-period loss, Q15
+  int32_t exciteLeft;  // samples of excitation still to inject
+  uint32_t excitePos;
+  int32_t exciteGain;  // Q15
+  int32_t exciteMean;  // mean of the injected window, removed so no DC circulates
+  uint32_t age;        // pluck order for voice stealing
+  bool active;
+  int32_t quiet;       // consecutive near-silent samples
+};
+
+// Ring buffers and excitation tables only exist while the Karplus track is selected
+struct StringMem {
+  int16_t buf[STRING_VOICES][STRING_BUF_LEN];
+  int16_t excite[EXCITE_LEN];
+  int32_t exciteSum[2 * EXCITE_LEN + 1];  // prefix sums over two wraps of the table
+};
+
+static KsString g_strings[STRING_VOICES];
+static StringMem* g_stringMem = nullptr;
+static int16_t* g_excite = nullptr;
+static int32_t* g_exciteSum = nullptr;
+static uint32_t g_pluckSerial = 0;
+
+// Pattern playback
+static const PluckEvent* g_pattern = nullptr;
+static int g_patternLen = 0;
+static int g_patternIdx = 0;
+static int g_stepSamples = 0;
+static int g_toNextStep = 0;
+
+float midiNoteToHz(uint8_t note) {
+  return 440.0f * powf(2.0f, ((float)note - 69.0f) / 12.0f);
+}
+
+static void resetStrings() {
+  for (int v = 0; v < STRING_VOICES; ++v) {
+    KsString& s = g_strings[v];
+    s.buf = g_stringMem ? g_stringMem->buf[v] : nullptr;
+    if (s.buf) memset(s.buf, 0, STRING_BUF_LEN * sizeof(int16_t));
+    s.w = 0;
+    s.delay = 64;
+    s.apCoef = 0;
+    s.apX1 = s.apY1 = 0;
+    s.prev = 0;
+    s.loss = 32604;  // 0.995
+    s.exciteLeft = 0;
+    s.excitePos = 0;
+    s.exciteGain = 0;
+    s.exciteMean = 0;
+    s.age = 0;
+    s.active = false;
+    s.quiet = 0;
+  }
+}
+
+void initStringBank() {
+  g_stringMem = nullptr;
+  g_excite = nullptr;
+  g_exciteSum = nullptr;
+  resetStrings();
+  g_pattern = nullptr;
+  g_patternLen = 0;
+}
+
+bool attachStringBank() {
+  if (g_stringMem) return true;
+  g_stringMem = (StringMem*)arenaAlloc(sizeof(StringMem), "strings");
+  if (!g_stringMem) return false;
+  g_excite = g_stringMem->excite;
+  g_exciteSum = g_stringMem->exciteSum;
+  // Excitation: white noise softened by a one-pole lowpass, generated off the audio path
+  int32_t lp = 0, sum = 0;
+  for (int i = 0; i < EXCITE_LEN; ++i) {
+    int32_t x = random(-32768, 32768);
+    lp += (x - lp) >> 1;
+    g_excite[i] = clampS16(lp);
+    sum += g_excite[i];
+  }
+  int32_t mean = sum / EXCITE_LEN;
+  for (int i = 0; i < EXCITE_LEN; ++i) g_excite[i] = clampS16(g_excite[i] - mean);
+  g_exciteSum[0] = 0;
+  for (int i = 0; i < 2 * EXCITE_LEN; ++i) g_exciteSum[i + 1] = g_exciteSum[i] + g_excite[i & (EXCITE_LEN - 1)];
+  resetStrings();
+  return true;
+}
+
+void releaseStringBank() {
+  g_stringMem = nullptr;
+  g_excite = nullptr;
+  g_exciteSum = nullptr;
+  resetStrings();
+}
+
+uint32_t getStringBankBytes() {
+  return sizeof(StringMem);
+}
+
+void pluckString(float freqHz, uint8_t velocity) {
+  if (!g_stringMem) return;
+  if (freqHz < 25.0f) freqHz = 25.0f;
+  if (freqHz > SAMPLE_RATE_HZ * 0.25f) freqHz = SAMPLE_RATE_HZ * 0.25f;
+
+  // Prefer a free voice, otherwise steal the oldest pluck
+  int pick = 0;
+  uint32_t oldest = 0xFFFFFFFFu;
+  for (int v = 0; v < STRING_VOICES; ++v) {
+    if (!g_strings[v].active) { pick = v; oldest = 0; break; }
+    if (g_strings[v].age < oldest) { oldest = g_strings[v].age; pick = v; }
+  }
+  KsString& s = g_strings[pick];
+
+  // Total loop delay = N (ring) + 0.5 (averaging filter) + frac (allpass).
+  // Keep frac in [0.1, 1.1) where the first-order allpass is well behaved.
+  float d = (float)SAMPLE_RATE_HZ / freqHz - 0.5f;
+  int n = (int)(d - 0.1f);
+  if (n < 2) n = 2;
+  if (n > STRING_BUF_LEN - 2) n = STRING_BUF_LEN - 2;
+  float frac = d - (float)n;
+  float c = (1.0f - frac) / (1.0f + frac);
+
+  s.delay = (uint32_t)n;
+  s.apCoef = (int32_t)(c * 32768.0f);
+  s.exciteLeft = n + 1;
+  s.excitePos = (uint32_t)random(0, EXCITE_LEN);
+  s.exciteMean = (g_exciteSum[s.excitePos + n + 1] - g_exciteSum[s.excitePos]) / (n + 1);
+  s.exciteGain = (int32_t)velocity * 200;  // 127 -> ~0.78
+  // Brighter/longer sustain for low strings, slightly faster damping up high
+  s.loss = (freqHz < 200.0f) ? 32670 : (freqHz < 500.0f ? 32620 : 32540);
+  s.age = ++g_pluckSerial;
+  s.active = true;
+  s.quiet = 0;
+}
+
+void setPluckPattern(const PluckEvent* events, int count, int stepSamples) {
+  g_pattern = events;
+  g_patternLen = count;
+  g_patternIdx = 0;
+  g_stepSamples = stepSamples;
+  g_toNextStep = 0;
+}
+
+static void renderStrings(int16_t* out, int n) {
+  for (int i = 0; i < n; ++i) out[i] = 0;
+  if (!g_stringMem) return;
+  for (int v = 0; v < STRING_VOICES; ++v) {
+    KsString& s = g_strings[v];
+    if (!s.active) continue;
+    uint32_t w = s.w;
+    const uint32_t delay = s.delay;
+    const int32_t c = s.apCoef, loss = s.loss;
+    int32_t apX1 = s.apX1, apY1 = s.apY1, prev = s.prev;
+    int32_t peak = 0;
+    for (int i = 0; i < n; ++i) {
+      int32_t y = s.buf[(w - delay) & STRING_MASK];
+      // Two-point average with loss (Q15)
+      // (rounded shifts: plain >> floors, and the bias would circulate as DC)
+      int32_t lp = ((y + prev) * loss + 32768) >> 16;
+      prev = y;
+      // First-order allpass: ap = c*lp + x1 - c*y1
+      int32_t ap = ((c * (lp - apY1) + 16384) >> 15) + apX1;
+      apX1 = lp;
+      apY1 = ap;
+      if (s.exciteLeft > 0) {
+        ap += ((g_excite[s.excitePos & (EXCITE_LEN - 1)] - s.exciteMean) * s.exciteGain) >> 15;
+        s.excitePos++;
+        s.exciteLeft--;
+      }
+      s.buf[w & STRING_MASK] = clampS16(ap);
+      w++;
+      int32_t o = out[i] + (y >> 1);
+      out[i] = clampS16(o);
+      int32_t ay = y < 0 ? -y : y;
+      if (ay > peak) peak = ay;
+    }
+    s.w = w;
+    s.apX1 = apX1; s.apY1 = apY1; s.prev = prev;
+    // Retire strings that have rung out so they cost nothing
+    if (peak < 16 && s.exciteLeft == 0) {
+      s.quiet += n;
+      if (s.quiet > (int32_t)STRING_BUF_LEN) s.active = false;
+    } else {
+      s.quiet = 0;
+    }
+  }
+}
+
+void renderStringBank(int16_t* out, int n) {
+  int done = 0;
+  while (done < n) {
+    int chunk = n - done;
+    if (g_pattern && g_patternLen > 0) {
+      if (g_toNextStep <= 0) {
+        const PluckEvent& e = g_pattern[g_patternIdx];
+        if (e.note) pluckString(midiNoteToHz(e.note), e.velocity);
+        g_patternIdx = (g_patternIdx + 1) % g_patternLen;
+        g_toNextStep = g_stepSamples;
+      }
+      if (chunk > g_toNextStep) chunk = g_toNextStep;
+      g_toNextStep -= chunk;
+    }
+    renderStrings(out + done, chunk);
+    done += chunk;
+  }
+}
@@ -49,6 +49,10 @@ NoiseType getCurrentNoiseType(int trackIndex) {
     case 43: return NoiseType::FX_DOPPLER;
     case 44: return NoiseType::FX_GATED_REVERB;
     case 45: return NoiseType::FX_ALIASING_BUZZ;
+    case 46: return NoiseType::NOISE_TILT;
+    case 47: return NoiseType::NOISE_SPECTRAL;
+    case 48: return NoiseType::TONE_BYTEBEAT;
+    case 49: return NoiseType::TONE_VOICES;
     default: return NoiseType::NOISE_WHITE;
   }
 }
@@ -102,6 +106,10 @@ const char* getNoiseTypeName(NoiseType t) {
     case NoiseType::FX_DOPPLER:            return "Doppler";
     case NoiseType::FX_GATED_REVERB:       return "Gated Reverb";
     case NoiseType::FX_ALIASING_BUZZ:      return "Aliasing Buzz";
+    case NoiseType::NOISE_TILT:            return "Tilt Noise";
+    case NoiseType::NOISE_SPECTRAL:        return "Spectral Noise";
+    case NoiseType::TONE_BYTEBEAT:         return "Bytebeat";
+    case NoiseType::TONE_VOICES:           return "Voices";
     default: return "Unknown";
   }
 }
@@ -135,7 +143,7 @@ float getGainForType(NoiseType t) {
     case NoiseType::RHYTHM_EUCLIDEAN_7_16: return 0.60f;
     case NoiseType::RHYTHM_POLY_3_4:       return 0.60f;
     case NoiseType::TONE_RING_MOD:         return 0.60f;
-    case NoiseType::TONE_CHORUS:           return 0.55f;
+    case NoiseType::TONE_CHORUS:           return 0.75f;
     case NoiseType::FX_SAMPLE_HOLD:        return 0.55f;
     case NoiseType::FX_FORMANT:            return 0.60f;
     case NoiseType::TONE_SYNC:             return 0.60f;
@@ -151,10 +159,52 @@ float getGainForType(NoiseType t) {
     case NoiseType::TONE_FEEDBACK_HOWL:    return 0.60f;
     case NoiseType::TONE_FM_METAL:         return 0.55f;
     case NoiseType::FX_STUTTER:            return 0.55f;
-    case NoiseType::FX_PHASER:             return 0.60f;
+    case NoiseType::FX_PHASER:             return 1.00f;
     case NoiseType::FX_DOPPLER:            return 0.60f;
     case NoiseType::FX_GATED_REVERB:       return 0.60f;
     case NoiseType::FX_ALIASING_BUZZ:      return 0.55f;
+    case NoiseType::NOISE_TILT:            return 0.60f;
+    case NoiseType::NOISE_SPECTRAL:        return 0.60f;
+    case NoiseType::TONE_BYTEBEAT:         return 0.50f;
+    case NoiseType::TONE_VOICES:           return 0.90f;
     default: return 0.65f;
   }
 }
+
+int getFxChainForType(NoiseType t, FxType* out) {
+  switch (t) {
+    case NoiseType::FX_BITCRUSH:      out[0] = FxType::BITCRUSH;   return 1;
+    case NoiseType::FX_FORMANT:       out[0] = FxType::FORMANT;    return 1;
+    case NoiseType::FX_STUTTER:       out[0] = FxType::STUTTER;    return 1;
+    case NoiseType::TONE_CHORUS:      out[0] = FxType::CHORUS;     return 1;
+    case NoiseType::FX_PHASER:        out[0] = FxType::PHASER;  out[1] = FxType::FLANGER; return 2;
+    case NoiseType::FX_DOPPLER:       out[0] = FxType::DOPPLER;    return 1;
+    case NoiseType::FX_ALIASING_BUZZ: out[0] = FxType::DOWNSAMPLE; return 1;
+    default: return 0;
+  }
+}
+
+static int gcdInt(int a, int b) {
+  while (b) { int r = a % b; a = b; b = r; }
+  return a;
+}
+
+// A sum of integer-Hz partials repeats every SAMPLE_RATE_HZ / gcd(SAMPLE_RATE_HZ, gcd of partials)
+static int periodForHz(int hz) {
+  return SAMPLE_RATE_HZ / gcdInt(SAMPLE_RATE_HZ, hz);
+}
+
+int getLoopPeriodForType(NoiseType t) {
+  switch (t) {
+    case NoiseType::TONE_MISSING_FUND:  return periodForHz(180);                   // 245
+    case NoiseType::TONE_EAR_RESONANCE: return periodForHz(3000);                  // 147
+    case NoiseType::TONE_NEAR_NYQUIST:  return periodForHz(5000);                  // 441
+    case NoiseType::TONE_SYNC:          return periodForHz(110);                   // master resets slave: 2205
+    case NoiseType::TONE_RING_MOD:      return periodForHz(gcdInt(220, 60));       // 2205
+    case NoiseType::TONE_ACOUSTIC_BEAT: return periodForHz(gcdInt(440, 446));      // 11025 (1 s)
+    case NoiseType::TONE_CHORUS:        return periodForHz(220);                   // 2205
+    case NoiseType::FX_PHASER:          return periodForHz(110);                   // 2205
+    case NoiseType::FX_DOPPLER:         return periodForHz(660);                   // 735
+    default: return 0;
+  }
+}
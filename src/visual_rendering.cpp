@@ -2,6 +2,8 @@
 #include "config.h"
 #include "types.h"
 #include "audio_synthesis.h"
+#include "sequencer.h"
+#include "sample_clock.h"
 #include <M5Stack.h>
 #include <math.h>
 
@@ -194,36 +196,37 @@ void drawBandpassNoiseVisualFrame() {
   M5.Lcd.endWrite();
 }
 
+// One row of cells per active sequencer lane. The highlighted step is the one heard when
+// this frame reaches the panel (audio clock plus the measured display latency).
 void drawEuclidVisualFrame() {
-  static uint32_t lastStepMs = 0;
-  static int stepIdx = 0;
-  static const bool pat[16] = {1,0,0,1,0,0,1,0,1,0,0,1,0,1,0,0};
-
-  uint32_t now = millis();
-  if (now - lastStepMs >= 125) {
-    lastStepMs = now;
-    stepIdx = (stepIdx + 1) & 15;
-  }
-
   M5.Lcd.fillRect(NOISE_X, NOISE_Y, NOISE_W, NOISE_H, TFT_BLACK);
-
-  int cols = 16;
-  int pad = 3;
-  int w = (NOISE_W - (cols + 1) * pad) / cols;
-  if (w < 4) w = 4;
-  int h = NOISE_H - 2 * pad;
-  if (h < 12) h = 12;
-
-  for (int i = 0; i < cols; ++i) {
-    int x = NOISE_X + pad + i * (w + pad);
-    int y = NOISE_Y + pad;
-    uint16_t fill = TFT_DARKGREY;
-    if (pat[i]) fill = TFT_CYAN;
-    if (i == stepIdx) {
-      fill = pat[i] ? TFT_YELLOW : TFT_NAVY;
+  const uint64_t shownAt = getDisplayClock();
+
+  int lanes = 0;
+  for (int li = 0; li < SEQ_LANES; ++li) if (seqLaneSteps(li)) ++lanes;
+  if (!lanes) return;
+
+  const int pad = 3;
+  int h = (NOISE_H - (lanes + 1) * pad) / lanes;
+  if (h < 6) h = 6;
+  int row = 0;
+  for (int li = 0; li < SEQ_LANES; ++li) {
+    const int cols = seqLaneSteps(li);
+    if (!cols) continue;
+    const uint32_t mask = seqLaneMask(li);
+    const int stepIdx = seqLaneStepAt(li, shownAt);
+    int w = (NOISE_W - (cols + 1) * pad) / cols;
+    if (w < 2) w = 2;
+    const int y = NOISE_Y + pad + row * (h + pad);
+    for (int i = 0; i < cols; ++i) {
+      const bool on = (mask >> i) & 1u;
+      int x = NOISE_X + pad + i * (w + pad);
+      uint16_t fill = on ? TFT_CYAN : TFT_DARKGREY;
+      if (i == stepIdx) fill = on ? TFT_YELLOW : TFT_NAVY;
+      M5.Lcd.fillRect(x, y, w, h, fill);
+      M5.Lcd.drawRect(x, y, w, h, TFT_BLACK);
     }
-    M5.Lcd.fillRect(x, y, w, h, fill);
-    M5.Lcd.drawRect(x, y, w, h, TFT_BLACK);
+    ++row;
   }
 }
 
@@ -401,8 +404,12 @@ void drawWaveformFrame(NoiseType t) {
 
 void drawNoiseFrame(NoiseType t) {
   g_visualType = t;
+  // The scope's newest sample is the one at the DAC now; once the frame is pushed, its age
+  // is the audio-to-display latency
+  const uint64_t shownAt = getSampleClock();
   // Always render the oscilloscope waveform so paused frames represent the real audio waveform.
   drawWaveformFrame(t);
+  if (isPlaying) sampleClockNoteFrame(shownAt);
 }
 
 void setVisualType(NoiseType type) {
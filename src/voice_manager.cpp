@@ -0,0 +1,600 @@
+#include "voice_manager.h"
+#include "audio_synthesis.h"  // clampS16
+#include "config.h"
+#include "fm_engine.h"
+#include "lut.h"
+#include "params.h"
+#include "sample_clock.h"
+#include "string_bank.h"
+#include <Arduino.h>
+#include <atomic>
+#include <math.h>
+#include <string.h>
+#include "esp_timer.h"
+
+static const float VOICE_PHASE_PER_HZ = 4294967296.0f / (float)SAMPLE_RATE_HZ;
+// Per voice at full velocity. 8 voices in phase at the attack peak (0.8) plus the string bank
+// at full scale (2x, 0.2) stay within +-1, so a full chord never reaches clampS16.
+static const float VOICE_LEVEL = 0.1f;
+static const float VOICE_SILENT = 1e-4f;  // -80 dB
+static const float VOICE_MIN_HZ = 20.0f;
+static const float VOICE_MAX_HZ = SAMPLE_RATE_HZ * 0.45f;
+
+// Envelope of the oscillator generators (FM and plucks bring their own)
+static const float ENV_ATTACK_S = 0.005f;
+static const float ENV_DECAY_S = 0.6f;    // T60 towards sustain
+static const float ENV_SUSTAIN = 0.5f;
+static const float ENV_RELEASE_S = 0.25f;  // T60
+
+// Demo: after DEMO_IDLE_S without events the track plays its own progression
+static const float DEMO_IDLE_S = 3.0f;
+static const int DEMO_STEP_SAMPLES = SAMPLE_RATE_HZ * 16 / 100;  // 160 ms
+static const int DEMO_HOLD_STEPS = 9;  // arpeggio notes overlap enough to need stealing
+static const uint16_t DEMO_KEY = 0xF000;
+
+enum class VoiceStage : uint8_t { OFF = 0, ATTACK, DECAY, RELEASE };
+
+struct Voice {
+  VoiceGen gen;
+  VoiceStage stage;   // oscillator generators
+  bool active;
+  uint16_t key;
+  float amp;          // VOICE_LEVEL * velocity
+  float env;
+  uint32_t phase;
+  uint32_t inc;
+  uint32_t age;       // note-on serial
+  int32_t holdLeft;   // samples until an automatic note-off, < 0 = wait for one
+  FmVoice fm;
+};
+
+enum class VoiceEventType : uint8_t { NOTE_ON = 0, NOTE_OFF, PANIC };
+
+struct VoiceEvent {
+  VoiceEventType type;
+  VoiceGen gen;
+  uint8_t velocity;
+  uint16_t key;
+  float hz;
+  int64_t us;         // arrival, esp_timer
+  uint32_t waitUs;    // arrival to parse, part of the queueing time
+};
+
+static Voice g_voices[VOICE_MAX];
+static uint32_t g_noteSerial = 0;
+static bool g_stringsReady = false;
+static float g_attackInc = 0.0f;
+static float g_decayMul = 0.0f;
+static float g_releaseMul = 0.0f;
+
+// UI -> audio, single producer / single consumer
+static VoiceEvent g_events[VOICE_EVENT_QUEUE];
+static std::atomic<uint32_t> g_evHead(0);
+static std::atomic<uint32_t> g_evTail(0);
+
+// Demo state (audio side)
+static uint32_t g_idleSamples = 0;
+static int32_t g_demoToNext = 0;
+static uint32_t g_demoStep = 0;
+
+// Status seen by printVoices. The audio side owns the live copy and publishes it once per
+// block under a seqlock (odd sequence = being written); the UI only reads the published one
+// and asks for the latency window to restart through g_statsResetReq.
+struct VoiceStatus {
+  struct {
+    bool active;
+    VoiceGen gen;
+    uint8_t stage;    // VoiceStage, or the FM carrier's FmStage (same order)
+    uint16_t key;
+    float hz;
+    float level;
+  } voice[VOICE_MAX];
+  uint32_t steals;    // since boot
+  uint32_t latCount;  // latency window, since the last report
+  uint32_t latMinUs;
+  uint32_t latMaxUs;
+  uint64_t latSumUs;
+  uint64_t waitSumUs;   // arrival to parse
+  uint32_t waitMaxUs;
+  uint64_t queueSumUs;  // parse to render
+};
+
+static VoiceStatus g_status;  // audio side
+static VoiceStatus g_statusPub;
+static std::atomic<uint32_t> g_statusSeq(0);
+static std::atomic<uint32_t> g_statsResetReq(0);
+static uint32_t g_statsResetSeen = 0;  // audio side
+static int32_t g_publishIn = 0;        // audio side, samples until the next publish
+
+static uint32_t g_drops = 0;  // UI side: events refused by a full queue
+static int64_t g_inputUs = 0;  // UI side: arrival of the input being parsed, 0 = stamp on push
+
+static const char* const kGenNames[(int)VoiceGen::COUNT] = {"sine", "saw", "square", "fm", "pluck"};
+
+const char* getVoiceGenName(VoiceGen g) {
+  return (int)g < (int)VoiceGen::COUNT ? kGenNames[(int)g] : "?";
+}
+
+bool findVoiceGen(const char* name, VoiceGen* out) {
+  for (int i = 0; i < (int)VoiceGen::COUNT; ++i) {
+    if (strcmp(name, kGenNames[i]) == 0) {
+      *out = (VoiceGen)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+/* =========================
+   UI side: event queue
+   ========================= */
+
+static bool pushEvent(VoiceEventType type, uint16_t key, float hz, uint8_t velocity, VoiceGen gen) {
+  uint32_t head = g_evHead.load(std::memory_order_relaxed);
+  uint32_t tail = g_evTail.load(std::memory_order_acquire);
+  if (head - tail >= VOICE_EVENT_QUEUE) {
+    g_drops++;
+    return false;
+  }
+  VoiceEvent& e = g_events[head & (VOICE_EVENT_QUEUE - 1)];
+  e.type = type;
+  e.gen = gen;
+  e.velocity = velocity;
+  e.key = key;
+  e.hz = hz;
+  const int64_t now = esp_timer_get_time();
+  e.us = g_inputUs && g_inputUs <= now ? g_inputUs : now;
+  e.waitUs = (uint32_t)(now - e.us);
+  g_evHead.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+void voiceSetInputArrival(int64_t us) {
+  g_inputUs = us;
+}
+
+bool voiceNoteOn(uint16_t key, float hz, uint8_t velocity, VoiceGen gen) {
+  if (velocity == 0) return voiceNoteOff(key);
+  if (velocity > 127) velocity = 127;
+  return pushEvent(VoiceEventType::NOTE_ON, key, hz, velocity, gen);
+}
+
+bool voiceNoteOff(uint16_t key) {
+  return pushEvent(VoiceEventType::NOTE_OFF, key, 0.0f, 0, VoiceGen::SINE);
+}
+
+bool voicePanic() {
+  return pushEvent(VoiceEventType::PANIC, 0, 0.0f, 0, VoiceGen::SINE);
+}
+
+uint16_t voiceKeyForHz(float hz) {
+  if (hz < 0.0f) hz = 0.0f;
+  if (hz > 32767.0f) hz = 32767.0f;
+  return (uint16_t)(0x8000u | (uint32_t)(hz + 0.5f));
+}
+
+/* =========================
+   UI side: MIDI parser
+   ========================= */
+
+static uint8_t g_midiStatus = 0;  // 0 = not inside a message
+static uint8_t g_midiNeed = 0;
+static uint8_t g_midiCount = 0;
+static uint8_t g_midiData[2];
+static bool g_midiSysex = false;
+// Generator per channel, set by program change; channels 1..5 start on each generator
+static VoiceGen g_chanGen[16] = {
+  VoiceGen::SINE, VoiceGen::SAW, VoiceGen::SQUARE, VoiceGen::FM, VoiceGen::PLUCK,
+  VoiceGen::SINE, VoiceGen::SAW, VoiceGen::SQUARE, VoiceGen::FM, VoiceGen::PLUCK,
+  VoiceGen::SINE, VoiceGen::SAW, VoiceGen::SQUARE, VoiceGen::FM, VoiceGen::PLUCK,
+  VoiceGen::SINE,
+};
+
+static void dispatchMidi(uint8_t status, const uint8_t* d) {
+  const uint8_t ch = status & 0x0F;
+  const uint16_t key = (uint16_t)((ch << 8) | d[0]);
+  switch (status & 0xF0) {
+    case 0x90:
+      voiceNoteOn(key, midiNoteToHz(d[0]), d[1], g_chanGen[ch]);
+      break;
+    case 0x80:
+      voiceNoteOff(key);
+      break;
+    case 0xC0:
+      g_chanGen[ch] = (VoiceGen)(d[0] % (int)VoiceGen::COUNT);
+      break;
+    case 0xB0:
+      if (d[0] == 120 || d[0] == 123) voicePanic();  // all sound off, all notes off
+      break;
+    default:
+      break;
+  }
+}
+
+bool voiceMidiByte(uint8_t b) {
+  if (b >= 0xF8) return true;  // real-time bytes may appear anywhere
+  if (b >= 0x80) {
+    g_midiSysex = (b == 0xF0);
+    g_midiCount = 0;
+    if (b >= 0xF0) {
+      // System common: swallow the data bytes of song position / select and MTC
+      g_midiNeed = (b == 0xF2) ? 2 : (b == 0xF1 || b == 0xF3) ? 1 : 0;
+    } else {
+      const uint8_t hi = b & 0xF0;
+      g_midiNeed = (hi == 0xC0 || hi == 0xD0) ? 1 : 2;
+    }
+    g_midiStatus = g_midiNeed ? b : 0;
+    return true;
+  }
+  if (g_midiSysex) return true;
+  if (!g_midiStatus) return false;
+  g_midiData[g_midiCount++] = b;
+  if (g_midiCount < g_midiNeed) return true;
+  if (g_midiStatus < 0xF0) dispatchMidi(g_midiStatus, g_midiData);
+  g_midiStatus = 0;
+  return true;
+}
+
+/* =========================
+   Audio side: allocation
+   ========================= */
+
+static float voiceLevel(const Voice& v) {
+  if (v.gen == VoiceGen::FM) return v.fm.env[0] * v.fm.velocity;
+  return v.env * v.amp;
+}
+
+// Level a steal is judged by: a note still in its attack counts at the level it is rising
+// to, or a burst of note-ons would keep stealing the one that has just started
+static float stealLevel(const Voice& v) {
+  if (v.gen == VoiceGen::FM) return v.fm.stage[0] == FmStage::ATTACK ? v.fm.velocity : voiceLevel(v);
+  return v.stage == VoiceStage::ATTACK ? v.amp : voiceLevel(v);
+}
+
+// A free voice, else the one to steal under the current policy
+static Voice& allocVoice() {
+  for (int i = 0; i < VOICE_MAX; ++i) {
+    if (!g_voices[i].active) return g_voices[i];
+  }
+  g_status.steals++;
+  int pick = 0;
+  if ((VoiceSteal)(int)paramValue(ParamId::VOICE_STEAL) == VoiceSteal::OLDEST) {
+    bool pickReleased = false;
+    for (int i = 0; i < VOICE_MAX; ++i) {
+      const Voice& v = g_voices[i];
+      const bool released = v.gen == VoiceGen::FM ? v.fm.stage[0] == FmStage::RELEASE : v.stage == VoiceStage::RELEASE;
+      if (released != pickReleased ? released : v.age < g_voices[pick].age) {
+        pick = i;
+        pickReleased = released;
+      }
+    }
+  } else {
+    float quietest = stealLevel(g_voices[0]);
+    for (int i = 1; i < VOICE_MAX; ++i) {
+      const float l = stealLevel(g_voices[i]);
+      if (l < quietest) { quietest = l; pick = i; }
+    }
+  }
+  return g_voices[pick];
+}
+
+static void noteOn(uint16_t key, float hz, uint8_t velocity, VoiceGen gen, int32_t holdSamples) {
+  if (hz < VOICE_MIN_HZ) hz = VOICE_MIN_HZ;
+  if (hz > VOICE_MAX_HZ) hz = VOICE_MAX_HZ;
+  if (gen == VoiceGen::PLUCK) {
+    // The string bank keeps its own pool and rings out; note-offs do not apply
+    pluckString(hz, velocity);
+    return;
+  }
+
+  // A repeated key retriggers its voice rather than stacking a second one
+  Voice* v = nullptr;
+  for (int i = 0; i < VOICE_MAX && !v; ++i) {
+    if (g_voices[i].active && g_voices[i].key == key) v = &g_voices[i];
+  }
+  if (!v) v = &allocVoice();
+
+  const float vel = (float)velocity / 127.0f;
+  if (gen == VoiceGen::FM) {
+    if (!v->active || v->gen != VoiceGen::FM) fmVoiceInit(v->fm, getFmPreset(FmPreset::BELL));
+    fmNoteOn(v->fm, hz, VOICE_LEVEL * 1.4f * vel);
+    v->stage = VoiceStage::OFF;
+  } else {
+    // Attack starts from the current level, so a retrigger or a steal between oscillator
+    // voices does not step
+    if (!v->active || v->gen == VoiceGen::FM) {
+      v->env = 0.0f;
+      v->phase = 0;
+    }
+    v->stage = VoiceStage::ATTACK;
+  }
+  v->gen = gen;
+  v->active = true;
+  v->key = key;
+  v->amp = VOICE_LEVEL * vel;
+  v->inc = (uint32_t)(hz * VOICE_PHASE_PER_HZ);
+  v->age = ++g_noteSerial;
+  v->holdLeft = holdSamples;
+}
+
+static void noteOff(Voice& v) {
+  if (v.gen == VoiceGen::FM) fmNoteOff(v.fm);
+  else v.stage = VoiceStage::RELEASE;
+  v.holdLeft = -1;
+}
+
+static void recordLatency(int64_t arrivalUs, uint32_t waitUs) {
+  if (!sampleClockRunning()) return;
+  const int64_t renderUs = esp_timer_get_time();
+  const int64_t heardUs = sampleClockToUs(getRenderClock());
+  if (heardUs < arrivalUs) return;
+  const uint32_t lat = (uint32_t)(heardUs - arrivalUs);
+  VoiceStatus& s = g_status;
+  s.latCount++;
+  s.latSumUs += lat;
+  s.waitSumUs += waitUs;
+  if (waitUs > s.waitMaxUs) s.waitMaxUs = waitUs;
+  s.queueSumUs += (uint64_t)(renderUs - arrivalUs) - waitUs;
+  if (lat < s.latMinUs) s.latMinUs = lat;
+  if (lat > s.latMaxUs) s.latMaxUs = lat;
+}
+
+static void resetLatencyWindow() {
+  g_status.latCount = 0;
+  g_status.latSumUs = 0;
+  g_status.waitSumUs = 0;
+  g_status.waitMaxUs = 0;
+  g_status.queueSumUs = 0;
+  g_status.latMinUs = 0xFFFFFFFFu;
+  g_status.latMaxUs = 0;
+}
+
+static void publishStatus() {
+  for (int i = 0; i < VOICE_MAX; ++i) {
+    const Voice& v = g_voices[i];
+    const bool fm = v.gen == VoiceGen::FM;
+    g_status.voice[i].active = v.active;
+    g_status.voice[i].gen = v.gen;
+    g_status.voice[i].stage = fm ? (uint8_t)v.fm.stage[0] : (uint8_t)v.stage;
+    g_status.voice[i].key = v.key;
+    g_status.voice[i].hz = fm ? v.fm.pitchHz : (float)v.inc / VOICE_PHASE_PER_HZ;
+    g_status.voice[i].level = voiceLevel(v);
+  }
+  g_statusSeq.fetch_add(1, std::memory_order_acq_rel);
+  g_statusPub = g_status;
+  g_statusSeq.fetch_add(1, std::memory_order_acq_rel);
+}
+
+// Events take effect at sample 0 of the block being rendered
+static void applyEvents() {
+  uint32_t tail = g_evTail.load(std::memory_order_relaxed);
+  const uint32_t head = g_evHead.load(std::memory_order_acquire);
+  while (tail != head) {
+    const VoiceEvent& e = g_events[tail & (VOICE_EVENT_QUEUE - 1)];
+    switch (e.type) {
+      case VoiceEventType::NOTE_ON:
+        noteOn(e.key, e.hz, e.velocity, e.gen, -1);
+        recordLatency(e.us, e.waitUs);
+        break;
+      case VoiceEventType::NOTE_OFF:
+        for (int i = 0; i < VOICE_MAX; ++i) {
+          if (g_voices[i].active && g_voices[i].key == e.key) noteOff(g_voices[i]);
+        }
+        break;
+      case VoiceEventType::PANIC:
+        for (int i = 0; i < VOICE_MAX; ++i) {
+          if (g_voices[i].active) noteOff(g_voices[i]);
+        }
+        break;
+    }
+    g_idleSamples = 0;
+    ++tail;
+  }
+  g_evTail.store(tail, std::memory_order_release);
+}
+
+/* =========================
+   Audio side: demo
+   ========================= */
+
+// Am - F - C - G, one bar of 16 steps each; the arpeggio changes generator every bar
+static const uint8_t kDemoRoots[4] = {45, 41, 48, 43};
+static const uint8_t kDemoThird[4] = {3, 4, 4, 4};
+static const VoiceGen kDemoArpGen[4] = {VoiceGen::SAW, VoiceGen::FM, VoiceGen::PLUCK, VoiceGen::SINE};
+static const uint8_t kDemoArp[16] = {0, 1, 2, 3, 4, 5, 4, 3, 1, 2, 3, 4, 5, 6, 5, 4};
+
+static void demoStep() {
+  const uint32_t bar = (g_demoStep / 16) & 3;
+  const uint32_t s = g_demoStep % 16;
+  const uint8_t root = kDemoRoots[bar];
+  if (s == 0) {
+    noteOn(DEMO_KEY, midiNoteToHz((uint8_t)(root - 12)), 100, VoiceGen::SQUARE, 15 * DEMO_STEP_SAMPLES);
+  }
+  // Chord tone k: root, third, fifth, stacked up by octaves
+  const uint8_t k = kDemoArp[s];
+  const uint8_t interval[3] = {0, kDemoThird[bar], 7};
+  const uint8_t note = (uint8_t)(root + 12 + interval[k % 3] + 12 * (k / 3));
+  noteOn((uint16_t)(DEMO_KEY + 1 + s), midiNoteToHz(note), (s % 4) == 0 ? 110 : 80, kDemoArpGen[bar],
+    DEMO_HOLD_STEPS * DEMO_STEP_SAMPLES);
+  g_demoStep++;
+}
+
+static void runDemo(int n) {
+  if (paramValue(ParamId::VOICE_DEMO) < 0.5f || g_idleSamples < (uint32_t)(DEMO_IDLE_S * SAMPLE_RATE_HZ)) {
+    g_idleSamples += (uint32_t)n;
+    g_demoToNext = 0;
+    return;
+  }
+  if (g_demoToNext <= 0) {
+    demoStep();
+    g_demoToNext += DEMO_STEP_SAMPLES;
+  }
+  g_demoToNext -= n;
+}
+
+/* =========================
+   Audio side: rendering
+   ========================= */
+
+static inline float polyBlep(float t, float dt) {
+  if (t < dt) {
+    const float x = t / dt;
+    return x + x - x * x - 1.0f;
+  }
+  if (t > 1.0f - dt) {
+    const float x = (t - 1.0f) / dt;
+    return x * x + x + x + 1.0f;
+  }
+  return 0.0f;
+}
+
+static void renderOscVoice(Voice& v, float* acc, int n) {
+  const float* lut = g_sineLut;
+  if (v.gen == VoiceGen::SINE && !lut) return;
+  const float dt = (float)v.inc * (1.0f / 4294967296.0f);
+  const float sustain = ENV_SUSTAIN;
+  float env = v.env;
+  uint32_t phase = v.phase;
+  for (int i = 0; i < n; ++i) {
+    switch (v.stage) {
+      case VoiceStage::ATTACK:
+        env += g_attackInc;
+        if (env >= 1.0f) { env = 1.0f; v.stage = VoiceStage::DECAY; }
+        break;
+      case VoiceStage::DECAY:
+        env = sustain + (env - sustain) * g_decayMul;
+        break;
+      case VoiceStage::RELEASE:
+        env *= g_releaseMul;
+        break;
+      default:
+        env = 0.0f;
+        break;
+    }
+    float w;
+    if (v.gen == VoiceGen::SINE) {
+      w = lutSinU32(lut, phase);
+    } else {
+      const float t = (float)phase * (1.0f / 4294967296.0f);
+      if (v.gen == VoiceGen::SAW) {
+        w = 2.0f * t - 1.0f - polyBlep(t, dt);
+      } else {
+        const float t2 = (float)(phase + 0x80000000u) * (1.0f / 4294967296.0f);
+        w = (t < 0.5f ? 1.0f : -1.0f) + polyBlep(t, dt) - polyBlep(t2, dt);
+      }
+    }
+    acc[i] += w * env * v.amp;
+    phase += v.inc;
+  }
+  v.env = env;
+  v.phase = phase;
+  if (v.stage == VoiceStage::RELEASE && env < VOICE_SILENT) {
+    v.stage = VoiceStage::OFF;
+    v.active = false;
+  }
+}
+
+bool attachVoices() {
+  g_attackInc = 1.0f / (ENV_ATTACK_S * (float)SAMPLE_RATE_HZ);
+  g_decayMul = expf(-6.9078f / (ENV_DECAY_S * (float)SAMPLE_RATE_HZ));
+  g_releaseMul = expf(-6.9078f / (ENV_RELEASE_S * (float)SAMPLE_RATE_HZ));
+  for (int i = 0; i < VOICE_MAX; ++i) {
+    g_voices[i].active = false;
+    g_voices[i].stage = VoiceStage::OFF;
+    g_voices[i].gen = VoiceGen::SINE;
+    g_voices[i].env = 0.0f;
+    g_voices[i].phase = 0;
+  }
+  // Events queued while another track played are stale
+  g_evTail.store(g_evHead.load(std::memory_order_acquire), std::memory_order_release);
+  g_idleSamples = 0;
+  g_demoToNext = 0;
+  g_demoStep = 0;
+  resetLatencyWindow();
+  g_publishIn = 0;
+  g_stringsReady = attachStringBank();
+  setPluckPattern(nullptr, 0, 0);
+  return g_stringsReady;
+}
+
+void releaseVoices() {
+  g_stringsReady = false;
+}
+
+void renderVoices(int16_t* out, int n) {
+  const uint32_t resetReq = g_statsResetReq.load(std::memory_order_acquire);
+  if (resetReq != g_statsResetSeen) {
+    resetLatencyWindow();
+    g_statsResetSeen = resetReq;
+  }
+  applyEvents();
+  runDemo(n);
+
+  float acc[AUDIO_BLOCK_SIZE];
+  if (g_stringsReady) {
+    renderStringBank(out, n);
+    for (int i = 0; i < n; ++i) acc[i] = (float)out[i] * (VOICE_LEVEL * 2.0f / 32768.0f);
+  } else {
+    for (int i = 0; i < n; ++i) acc[i] = 0.0f;
+  }
+
+  for (int k = 0; k < VOICE_MAX; ++k) {
+    Voice& v = g_voices[k];
+    if (!v.active) continue;
+    if (v.holdLeft >= 0) {
+      v.holdLeft -= n;
+      if (v.holdLeft < 0) noteOff(v);
+    }
+    if (v.gen == VoiceGen::FM) {
+      fmRender(v.fm, acc, n);
+      if (!fmVoiceActive(v.fm)) v.active = false;
+    } else {
+      renderOscVoice(v, acc, n);
+    }
+  }
+  for (int i = 0; i < n; ++i) out[i] = clampS16((int32_t)(acc[i] * 32767.0f));
+
+  // Once per block, also when rendered a sample at a time
+  g_publishIn -= n;
+  if (g_publishIn <= 0) {
+    publishStatus();
+    g_publishIn = AUDIO_BLOCK_SIZE;
+  }
+}
+
+/* =========================
+   Status
+   ========================= */
+
+void printVoices() {
+  static const char* const kStages[] = {"off", "attack", "decay", "release"};
+  Serial.printf("Voices: %d-voice pool, steal %s, demo %s\n", VOICE_MAX,
+    (int)getParam(ParamId::VOICE_STEAL) ? "oldest" : "quietest", getParam(ParamId::VOICE_DEMO) >= 0.5f ? "on" : "off");
+  VoiceStatus s;
+  uint32_t s0, s1;
+  do {
+    s0 = g_statusSeq.load(std::memory_order_acquire);
+    s = g_statusPub;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    s1 = g_statusSeq.load(std::memory_order_relaxed);
+  } while ((s0 & 1u) || s0 != s1);
+
+  for (int i = 0; i < VOICE_MAX; ++i) {
+    if (!s.voice[i].active) continue;
+    Serial.printf("  %d: %-6s key %04x  %7.1f Hz  level %.3f  %s\n", i, getVoiceGenName(s.voice[i].gen),
+      (unsigned)s.voice[i].key, s.voice[i].hz, s.voice[i].level, kStages[s.voice[i].stage & 3]);
+  }
+  Serial.printf("  steals %u, dropped events %u\n", (unsigned)s.steals, (unsigned)g_drops);
+  if (s.latCount) {
+    const uint32_t avg = (uint32_t)(s.latSumUs / s.latCount);
+    const uint32_t wait = (uint32_t)(s.waitSumUs / s.latCount);
+    const uint32_t queue = (uint32_t)(s.queueSumUs / s.latCount);
+    Serial.printf("  note-on -> DAC %u us avg, %u min, %u max over %u notes\n",
+      (unsigned)avg, (unsigned)s.latMinUs, (unsigned)s.latMaxUs, (unsigned)s.latCount);
+    Serial.printf("  input %u (max %u), queue %u, output %u\n", (unsigned)wait, (unsigned)s.waitMaxUs,
+      (unsigned)queue, (unsigned)(avg - wait - queue));
+  } else {
+    Serial.println("  no note-ons measured since the last report");
+  }
+  g_statsResetReq.fetch_add(1, std::memory_order_release);
+}